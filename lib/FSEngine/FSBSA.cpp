@@ -31,18 +31,37 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***** END LICENCE BLOCK *****/
 
 #include "FSBSA.h"
+#include "FSManager.h"
 #include "../DDS.h"
 
-#include <wx/mstream.h>
-#include <wx/zstream.h>
+#include <wx/filefn.h>
+#include <zlib.h>
 #include <vector>
 #include <algorithm>
 
 #include "../LZ4F/lz4frame.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #pragma warning (disable : 4389 4018)
 
 
+//! FNV-1a hash of a byte range
+static wxUint64 fnvHash(const void *data, size_t len) {
+	wxUint64 hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= ((const wxUint8*)data)[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+
 wxUint32 BSA::BSAFile::size() const {
 	if (sizeFlags > 0) {
 		// Skyrim and earlier
@@ -76,45 +95,120 @@ static bool BSAReadSizedString(wxFile &bsa, std::string &s) {
 	return false;
 }
 
-wxMemoryBuffer gUncompress(const wxMemoryBuffer &data, int skip = 0) {
-	if (data.GetDataLen() <= 4) {
-		// Input data is truncated
-		return wxMemoryBuffer();
+//! Decompression state that's reused by all archive reads of a thread
+struct BSADecompressor {
+	LZ4F_decompressionContext_t lz4 = nullptr;
+	z_stream zlib = {};
+	bool zlibReady = false;
+
+	~BSADecompressor() {
+		if (lz4)
+			LZ4F_freeDecompressionContext(lz4);
+		if (zlibReady)
+			inflateEnd(&zlib);
 	}
+};
 
-	wxMemoryOutputStream output;
+static thread_local BSADecompressor decompressor;
 
-	wxMemoryInputStream input((char*)data.GetData() + skip, data.GetDataLen() - skip);
-	wxZlibInputStream zlibStream(input);
-	zlibStream.Read(output);
+//! Inflates zlib or gzip data, returns the number of bytes written to dst or 0 if the stream doesn't end within dstSize
+static size_t gUncompress(const char *src, size_t srcSize, char *dst, size_t dstSize) {
+	z_stream &stream = decompressor.zlib;
+	if (!decompressor.zlibReady) {
+		// Detects the zlib and gzip headers
+		if (inflateInit2(&stream, MAX_WBITS + 32) != Z_OK)
+			return 0;
 
-	wxMemoryBuffer result(output.GetLength());
-	output.CopyTo(result.GetData(), output.GetLength());
-	result.SetDataLen(output.GetLength());
-	return result;
+		decompressor.zlibReady = true;
+	}
+	else if (inflateReset(&stream) != Z_OK)
+		return 0;
+
+	stream.next_in = (Bytef*)src;
+	stream.avail_in = (uInt)srcSize;
+	stream.next_out = (Bytef*)dst;
+	stream.avail_out = (uInt)dstSize;
+	if (inflate(&stream, Z_FINISH) != Z_STREAM_END)
+		return 0;
+
+	return dstSize - stream.avail_out;
 }
 
-wxMemoryBuffer lz4fUncompress(const wxMemoryBuffer &data) {
-	if (data.GetDataLen() <= 4) {
-		// Input data is truncated
-		return wxMemoryBuffer();
+//! Decompresses an LZ4 frame, returns the number of bytes written to dst
+static size_t lz4fUncompress(const char *src, size_t srcSize, char *dst, size_t dstSize) {
+	if (!decompressor.lz4 && LZ4F_isError(LZ4F_createDecompressionContext(&decompressor.lz4, LZ4F_VERSION))) {
+		decompressor.lz4 = nullptr;
+		return 0;
+	}
+
+	LZ4F_decompressOptions_t options = { 0 };
+
+	size_t result = LZ4F_decompress(decompressor.lz4, dst, &dstSize, src, &srcSize, &options);
+	if (result != 0) {
+		// The context is only ready for the next frame once a frame was decoded completely
+		LZ4F_freeDecompressionContext(decompressor.lz4);
+		decompressor.lz4 = nullptr;
 	}
 
-	size_t srcSize = data.GetDataLen() - 4;
-	size_t dstSize = ((unsigned int*)data.GetData())[0];
+	if (LZ4F_isError(result))
+		return 0;
 
-	wxMemoryBuffer result(dstSize);
+	return dstSize;
+}
 
-	LZ4F_decompressionContext_t dCtx = nullptr;
-	LZ4F_createDecompressionContext(&dCtx, LZ4F_VERSION);
+//! Decompresses the data and appends it to the content.
+//! Compressed files of Skyrim and earlier start with their uncompressed size instead of knowing it from the records.
+static void appendDecompressed(wxMemoryBuffer &content, const wxMemoryBuffer &data, wxUint32 unpackedSize, bool sizePrefix, bool lz4) {
+	const char *src = (const char*)data.GetData();
+	size_t srcSize = data.GetDataLen();
 
-	LZ4F_decompressOptions_t options = { 0 };
+	if (srcSize <= 4) {
+		// Input data is truncated
+		return;
+	}
 
-	LZ4F_decompress(dCtx, result.GetData(), &dstSize, (char*)data.GetData() + 4, &srcSize, &options);
-	LZ4F_freeDecompressionContext(dCtx);
+	if (sizePrefix) {
+		unpackedSize = *(const wxUint32*)src;
+		src += 4;
+		srcSize -= 4;
+
+		// Neither zlib nor LZ4 inflate data to more than about 1032 times its size, larger sizes come from corrupt data
+		if (unpackedSize / 1032 > srcSize)
+			return;
+	}
+
+	char *dst = (char*)content.GetAppendBuf(unpackedSize);
+	size_t written = lz4 ? lz4fUncompress(src, srcSize, dst, unpackedSize) : gUncompress(src, srcSize, dst, unpackedSize);
+	content.UngetAppendBuf(written);
+}
+
+//! Size of one mip of a BA2 texture in bytes
+static wxUint32 texMipSize(const F4TexInfo &info, wxUint32 mip) {
+	wxUint32 width = info.width >> mip;
+	wxUint32 height = info.height >> mip;
+	if (width == 0)
+		width = 1;
+	if (height == 0)
+		height = 1;
+
+	switch (info.format) {
+	case DXGI_FORMAT_BC1_UNORM:
+		return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC7_UNORM:
+		return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+		return width * height * 4;
+
+	case DXGI_FORMAT_R8_UNORM:
+		return width * height;
+	}
 
-	result.SetDataLen(dstSize);
-	return result;
+	return 0;
 }
 
 
@@ -123,6 +217,9 @@ BSA::BSA(const std::string &filename) : FSArchiveFile(), bsa(filename), bsaInfo(
 	bsaBase = bsaInfo.GetPath();
 	bsaName = bsaInfo.GetFullName();
 	headerVersion = 0;
+	numFiles = 0;
+	compressToggle = false;
+	namePrefix = false;
 }
 
 BSA::~BSA() {
@@ -156,14 +253,44 @@ bool BSA::canOpen(const std::string &fn) {
 	return false;
 }
 
+void BSA::setIndexCacheDir(const std::string &dir) {
+	if (dir.empty()) {
+		indexCacheFile.clear();
+		return;
+	}
+
+	// Archives of different games can share a name, the hash of the full path tells them apart
+	std::string lowerPath = bsaPath;
+	std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), ::tolower);
+	wxUint64 pathHash = fnvHash(lowerPath.data(), lowerPath.size());
+
+	char hashStr[17];
+	snprintf(hashStr, sizeof(hashStr), "%016llx", (unsigned long long)pathHash);
+
+	indexCacheFile = dir + "/" + bsaName + "." + hashStr + ".idx";
+}
+
 bool BSA::open() {
 	wxMutexLocker lock(bsaMutex);
 
+	wxUint64 hash = 0;
+
 	try {
 		bsa.Open(bsaPath);
 		if (!bsa.IsOpened())
 			throw std::string("file open");
 
+		if (!indexCacheFile.empty()) {
+			hash = headerHash();
+			if (loadIndexCache(hash)) {
+				status = "loaded from index cache";
+				return true;
+			}
+
+			if (bsa.Seek(0) == wxInvalidOffset)
+				throw std::string("file seek");
+		}
+
 		wxUint32 magic, version;
 
 		bsa.Read((char*)&magic, sizeof(magic));
@@ -387,6 +514,9 @@ bool BSA::open() {
 
 	status = "loaded successful";
 
+	if (!indexCacheFile.empty())
+		saveIndexCache(hash);
+
 	return true;
 }
 
@@ -396,12 +526,11 @@ void BSA::close() {
 	bsa.Close();
 	for (auto &it : root.children)
 		delete it.second;
-	for (auto &it : root.files)
-		delete it.second;
 
 	root.children.clear();
 	root.files.clear();
 	folders.clear();
+	fileRecords.clear();
 }
 
 wxInt64 BSA::fileSize(const std::string & fn) const {
@@ -441,156 +570,263 @@ void BSA::fileTree(std::vector<std::string> &tree) const {
 		addFilesOfFolders(folder.first, tree);
 }
 
+void BSA::fileList(std::vector<std::string> &list) const {
+	// Fallout 4 archives store full paths in the root folder
+	for (auto &file : root.files)
+		list.push_back(file.first);
+
+	for (auto &folder : folders) {
+		if (!folder.second)
+			continue;
+
+		for (auto &file : folder.second->files)
+			list.push_back(folder.first + "/" + file.first);
+	}
+}
+
 bool BSA::fileContents(const std::string &fn, wxMemoryBuffer &content) {
-	if (const BSAFile *file = getFile(fn)) {
-		wxMutexLocker lock(bsaMutex);
-		if (bsa.Seek(file->offset)) {
-			wxInt64 filesz = file->size();
-			ssize_t fileok = 1;
-			if (namePrefix) {
-				char len;
-				fileok = bsa.Read(&len, 1);
-				filesz -= len;
-				if (fileok != wxInvalidOffset)
-					fileok = bsa.Seek(file->offset + 1 + len);
-			}
+	const BSAFile *file = getFile(fn);
+	if (!file)
+		return false;
 
-			if (file->tex.chunks.size() > 0) {
-				// Fill DDS Header for BA2
-				DDS_HEADER ddsHeader = {};
-				ddsHeader.dwSize = sizeof(ddsHeader);
-				ddsHeader.dwFlags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE | DDS_HEADER_FLAGS_MIPMAP;
-				ddsHeader.dwHeight = file->tex.header.height;
-				ddsHeader.dwWidth = file->tex.header.width;
-				ddsHeader.dwMipMapCount = file->tex.header.numMips;
-				ddsHeader.dwCaps = DDS_SURFACE_FLAGS_TEXTURE | DDS_SURFACE_FLAGS_MIPMAP;
-				ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
-				
-				DDS_HEADER_DXT10 ddsHeader10 = {};
-				ddsHeader10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
-				ddsHeader10.arraySize = 1;
-
-				if (file->tex.header.unk16 == 2049) {
-					ddsHeader.dwCaps2 = DDS_CUBEMAP_ALLFACES;
-					ddsHeader10.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
-					ddsHeader10.arraySize *= 6;
-				}
+	// Reads don't share a file position, so any number of threads can read from the archive at once
+	wxUint64 offset = file->offset;
+	wxInt64 filesz = file->size();
+	if (namePrefix) {
+		// Skip the full path in front of the data
+		wxUint8 len;
+		if (!readAt(offset, &len, 1))
+			return false;
 
-				bool ok = true;
+		offset += 1 + len;
+		filesz -= 1 + len;
+	}
 
-				switch (file->tex.header.format) {
-				case DXGI_FORMAT_BC1_UNORM:
-					ddsHeader.ddspf = DDSPF_DXT1;
-					ddsHeader.dwPitchOrLinearSize /= 2;	// 4bpp
-					break;
-
-				case DXGI_FORMAT_BC2_UNORM:
-					ddsHeader.ddspf = DDSPF_DXT3;
-					break;
-
-				case DXGI_FORMAT_BC3_UNORM:
-					ddsHeader.ddspf = DDSPF_DXT5;
-					break;
-
-				case DXGI_FORMAT_BC5_UNORM:
-					ddsHeader.ddspf = DDSPF_DX10;
-					ddsHeader10.dxgiFormat = DXGI_FORMAT_BC5_UNORM;
-					break;
-
-				case DXGI_FORMAT_BC7_UNORM:
-					ddsHeader.ddspf = DDSPF_DX10;
-					ddsHeader10.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
-					break;
-
-				case DXGI_FORMAT_B8G8R8A8_UNORM:
-					ddsHeader.ddspf = DDSPF_A8R8G8B8;
-					ddsHeader.dwPitchOrLinearSize *= 4;	// 32bpp
-					break;
-
-				case DXGI_FORMAT_R8_UNORM:
-					ddsHeader.ddspf = DDSPF_L8;
-					break;
-
-				default:
-					ok = false;
-					break;
-				}
+	if (filesz < 0)
+		return false;
 
-				if (!ok)
-					return false;
+	if (file->tex.chunks.size() > 0)
+		return texContents(file->tex, 0, content);
 
-				// Append DDS Header
-				content.AppendData(&DDS_MAGIC, 4);
-				content.AppendData(&ddsHeader, sizeof(ddsHeader));
-				if (ddsHeader10.dxgiFormat != DXGI_FORMAT_UNKNOWN)
-					content.AppendData(&ddsHeader10, sizeof(ddsHeader10));
-			}
+	wxMemoryBuffer data(filesz);
+	data.SetDataLen(filesz);
+	if (!readAt(offset, data.GetData(), filesz))
+		return false;
 
-			wxMemoryBuffer firstChunk(filesz);
-			firstChunk.SetDataLen(filesz);
-			if (fileok != wxInvalidOffset && bsa.Read(firstChunk.GetData(), filesz) == filesz) {
-				if (file->sizeFlags > 0) {
-					// BSA
-					if (file->compressed() ^ compressToggle) {
-						if (headerVersion == SSE_BSAHEADER_VERSION) {
-							firstChunk = lz4fUncompress(firstChunk);
-							content.AppendData(firstChunk, firstChunk.GetDataLen());
-						}
-						else {
-							firstChunk = gUncompress(firstChunk, 4);
-							content.AppendData(firstChunk, firstChunk.GetDataLen());
-						}
-					}
-					else
-						content.AppendData(firstChunk.GetData(), firstChunk.GetDataLen());
-				}
-				else if (file->packedLength > 0) {
-					// BA2
-					firstChunk = gUncompress(firstChunk);
-					content.AppendData(firstChunk, firstChunk.GetDataLen());
-				}
+	if (file->sizeFlags > 0) {
+		// BSA
+		if (file->compressed() ^ compressToggle)
+			appendDecompressed(content, data, 0, true, headerVersion == SSE_BSAHEADER_VERSION);
+		else
+			content.AppendData(data.GetData(), data.GetDataLen());
+	}
+	else if (file->packedLength > 0) {
+		// BA2
+		appendDecompressed(content, data, file->unpackedLength, false, false);
+	}
+	else
+		content.AppendData(data.GetData(), data.GetDataLen());
 
-				if (file->tex.chunks.size() > 0) {
-					// Start at 2nd chunk for BA2
-					for (int i = 1; i < file->tex.chunks.size(); i++) {
-						const F4TexChunk& chunk = file->tex.chunks[i];
-						if (bsa.Seek(chunk.offset)) {
-							wxMemoryBuffer chunkData;
-
-							if (chunk.packedSize > 0) {
-								chunkData.SetBufSize(chunk.packedSize);
-								chunkData.SetDataLen(chunk.packedSize);
-								if (bsa.Read(chunkData.GetData(), chunk.packedSize) == chunk.packedSize)
-									chunkData = gUncompress(chunkData);
-
-								if (chunkData.GetDataLen() != chunk.unpackedSize) {
-									// Size does not match at chunk.offset
-									return false;
-								}
-
-							}
-							else {
-								chunkData.SetBufSize(chunk.unpackedSize);
-								chunkData.SetDataLen(chunk.unpackedSize);
-								if (!(bsa.Read(chunkData.GetData(), chunk.unpackedSize) == chunk.unpackedSize)) {
-									// Size does not match at chunk.offset
-									return false;
-								}
-							}
-
-							content.AppendData(chunkData.GetData(), chunkData.GetDataLen());
-						}
-						else {
-							// Seek error
-							return false;
-						}
-					}
-				}
-				return true;
-			}
-		}
+	return true;
+}
+
+bool BSA::textureContents(const std::string &fn, wxMemoryBuffer &content, wxUint32 maxSize) {
+	const BSAFile *file = getFile(fn);
+	if (!file)
+		return false;
+
+	// Cube maps store their faces one after another, they're always read whole
+	const F4TexInfo &info = file->tex.header;
+	if (maxSize == 0 || file->tex.chunks.empty() || info.unk16 == 2049)
+		return fileContents(fn, content);
+
+	wxUint32 firstMip = 0;
+	while (firstMip + 1 < info.numMips && ((info.width >> firstMip) > maxSize || (info.height >> firstMip) > maxSize))
+		firstMip++;
+
+	return texContents(file->tex, firstMip, content);
+}
+
+bool BSA::texContents(const F4Tex &tex, wxUint32 firstMip, wxMemoryBuffer &content) const {
+	wxUint32 width = tex.header.width >> firstMip;
+	wxUint32 height = tex.header.height >> firstMip;
+	if (width == 0)
+		width = 1;
+	if (height == 0)
+		height = 1;
+
+	// Fill DDS Header for BA2
+	DDS_HEADER ddsHeader = {};
+	ddsHeader.dwSize = sizeof(ddsHeader);
+	ddsHeader.dwFlags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE | DDS_HEADER_FLAGS_MIPMAP;
+	ddsHeader.dwHeight = height;
+	ddsHeader.dwWidth = width;
+	ddsHeader.dwMipMapCount = tex.header.numMips - firstMip;
+	ddsHeader.dwCaps = DDS_SURFACE_FLAGS_TEXTURE | DDS_SURFACE_FLAGS_MIPMAP;
+	ddsHeader.dwPitchOrLinearSize = width * height;	// 8bpp
+	
+	DDS_HEADER_DXT10 ddsHeader10 = {};
+	ddsHeader10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	ddsHeader10.arraySize = 1;
+
+	if (tex.header.unk16 == 2049) {
+		ddsHeader.dwCaps2 = DDS_CUBEMAP_ALLFACES;
+		ddsHeader10.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+		ddsHeader10.arraySize *= 6;
 	}
-	return false;
+
+	bool ok = true;
+
+	switch (tex.header.format) {
+	case DXGI_FORMAT_BC1_UNORM:
+		ddsHeader.ddspf = DDSPF_DXT1;
+		ddsHeader.dwPitchOrLinearSize /= 2;	// 4bpp
+		break;
+
+	case DXGI_FORMAT_BC2_UNORM:
+		ddsHeader.ddspf = DDSPF_DXT3;
+		break;
+
+	case DXGI_FORMAT_BC3_UNORM:
+		ddsHeader.ddspf = DDSPF_DXT5;
+		break;
+
+	case DXGI_FORMAT_BC5_UNORM:
+		ddsHeader.ddspf = DDSPF_DX10;
+		ddsHeader10.dxgiFormat = DXGI_FORMAT_BC5_UNORM;
+		break;
+
+	case DXGI_FORMAT_BC7_UNORM:
+		ddsHeader.ddspf = DDSPF_DX10;
+		ddsHeader10.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+		break;
+
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+		ddsHeader.ddspf = DDSPF_A8R8G8B8;
+		ddsHeader.dwPitchOrLinearSize *= 4;	// 32bpp
+		break;
+
+	case DXGI_FORMAT_R8_UNORM:
+		ddsHeader.ddspf = DDSPF_L8;
+		break;
+
+	default:
+		ok = false;
+		break;
+	}
+
+	if (!ok)
+		return false;
+
+	// Append DDS Header
+	content.AppendData(&DDS_MAGIC, 4);
+	content.AppendData(&ddsHeader, sizeof(ddsHeader));
+	if (ddsHeader10.dxgiFormat != DXGI_FORMAT_UNKNOWN)
+		content.AppendData(&ddsHeader10, sizeof(ddsHeader10));
+
+	return texChunkContents(tex, firstMip, content);
+}
+
+bool BSA::texChunkContents(const F4Tex &tex, wxUint32 firstMip, wxMemoryBuffer &content) const {
+	// Each chunk has a known place in the output, so it's sized once and the chunks are decompressed into place.
+	// Chunks that only hold mips larger than firstMip are left out, the one holding firstMip is cut to start at it.
+	std::vector<const F4TexChunk*> chunks;
+	std::vector<wxUint32> chunkSkip;
+	std::vector<size_t> chunkStart;
+	size_t totalSize = 0;
+	for (auto &chunk : tex.chunks) {
+		if (chunk.endMip < firstMip)
+			continue;
+
+		wxUint32 skip = 0;
+		for (wxUint32 mip = chunk.startMip; mip < firstMip; mip++)
+			skip += texMipSize(tex.header, mip);
+
+		if (skip > chunk.unpackedSize)
+			return false;
+
+		chunks.push_back(&chunk);
+		chunkSkip.push_back(skip);
+		chunkStart.push_back(totalSize);
+		totalSize += chunk.unpackedSize - skip;
+	}
+
+	char *dst = (char*)content.GetAppendBuf(totalSize);
+	bool ok = true;
+
+	if (chunks.size() > 1 && totalSize >= BSA_PARALLELCHUNK_SIZE) {
+		// Not a vector<bool>, its elements can't be written from several threads
+		std::vector<char> chunkOk(chunks.size(), 0);
+		FSManager::parallelFor(chunks.size(), [&](int i) {
+			chunkOk[i] = texChunkContents(*chunks[i], chunkSkip[i], dst + chunkStart[i]);
+		});
+
+		ok = std::find(chunkOk.begin(), chunkOk.end(), 0) == chunkOk.end();
+	}
+	else {
+		for (size_t i = 0; i < chunks.size() && ok; i++)
+			ok = texChunkContents(*chunks[i], chunkSkip[i], dst + chunkStart[i]);
+	}
+
+	if (!ok)
+		return false;
+
+	content.UngetAppendBuf(totalSize);
+	return true;
+}
+
+bool BSA::texChunkContents(const F4TexChunk &chunk, wxUint32 skip, char *dst) const {
+	if (chunk.packedSize == 0)
+		return readAt(chunk.offset + skip, dst, chunk.unpackedSize - skip);
+
+	std::vector<char> chunkData(chunk.packedSize);
+	if (!readAt(chunk.offset, chunkData.data(), chunk.packedSize))
+		return false;
+
+	if (skip > 0) {
+		// The skipped mips are still part of the compressed stream
+		std::vector<char> unpacked(chunk.unpackedSize);
+		if (gUncompress(chunkData.data(), chunkData.size(), unpacked.data(), chunk.unpackedSize) != chunk.unpackedSize)
+			return false;
+
+		memcpy(dst, unpacked.data() + skip, chunk.unpackedSize - skip);
+		return true;
+	}
+
+	// Size does not match at chunk.offset otherwise
+	return gUncompress(chunkData.data(), chunkData.size(), dst, chunk.unpackedSize) == chunk.unpackedSize;
+}
+
+bool BSA::readAt(wxUint64 offset, void *data, size_t size) const {
+	char *dst = (char*)data;
+
+	while (size > 0) {
+#ifdef _WIN32
+		HANDLE handle = (HANDLE)_get_osfhandle(bsa.fd());
+		if (handle == INVALID_HANDLE_VALUE)
+			return false;
+
+		// ReadFile with an explicit offset doesn't depend on the shared file position.
+		// It still moves it on a synchronous handle, but nothing reads from it after the archive was opened.
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+		DWORD toRead = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+		DWORD bytesRead = 0;
+		if (!ReadFile(handle, dst, toRead, &bytesRead, &overlapped) || bytesRead == 0)
+			return false;
+#else
+		ssize_t bytesRead = pread(bsa.fd(), dst, size, offset);
+		if (bytesRead <= 0)
+			return false;
+#endif
+		dst += bytesRead;
+		offset += bytesRead;
+		size -= bytesRead;
+	}
+
+	return true;
 }
 
 bool BSA::exportFile(const std::string &fn, const std::string &target) {
@@ -671,7 +907,7 @@ BSA::BSAFolder* BSA::insertFolder( char* folder, int szFn) {
 BSA::BSAFile *BSA::insertFile(BSAFolder *folder, std::string name, wxUint32 sizeFlags, wxUint32 offset) {
 	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
 
-	BSAFile *file = new BSAFile;
+	BSAFile *file = newFile();
 	file->sizeFlags = sizeFlags;
 	file->offset = offset;
 
@@ -692,7 +928,7 @@ BSA::BSAFile* BSA::insertFile(char* filename, int szFn, wxUint32 packed, wxUint3
 	//else
 	//	folder = &root;
 
-	BSAFile *file = new BSAFile;
+	BSAFile *file = newFile();
 	if (dds)
 		file->tex = *dds;
 
@@ -704,6 +940,218 @@ BSA::BSAFile* BSA::insertFile(char* filename, int szFn, wxUint32 packed, wxUint3
 	return nullptr;
 }
 
+BSA::BSAFile *BSA::newFile() {
+	fileRecords.emplace_back();
+	return &fileRecords.back();
+}
+
+wxUint64 BSA::headerHash() {
+	char header[64] = {};
+	ssize_t len = bsa.Read(header, sizeof(header));
+	if (len == wxInvalidOffset)
+		len = 0;
+
+	return fnvHash(header, len);
+}
+
+void BSA::archiveStats(wxUint64 &size, wxInt64 &time) {
+	size = bsa.Length();
+	time = bsaInfo.GetModificationTime().GetValue().GetValue();
+}
+
+bool BSA::loadIndexCache(wxUint64 hash) {
+	wxFile cache;
+	if (!wxFile::Exists(indexCacheFile) || !cache.Open(indexCacheFile))
+		return false;
+
+	wxFileOffset cacheSize = cache.Length();
+	if (cacheSize < (wxFileOffset)sizeof(BSAIndexCacheHeader))
+		return false;
+
+	wxMemoryBuffer data(cacheSize);
+	if (cache.Read(data.GetData(), cacheSize) != cacheSize)
+		return false;
+
+	const char *cursor = (const char*)data.GetData();
+	const BSAIndexCacheHeader &header = *(const BSAIndexCacheHeader*)cursor;
+	cursor += sizeof(BSAIndexCacheHeader);
+
+	wxUint64 archiveSize;
+	wxInt64 archiveTime;
+	archiveStats(archiveSize, archiveTime);
+
+	if (header.magic != BSA_INDEXCACHE_FILEID || header.version != BSA_INDEXCACHE_VERSION)
+		return false;
+
+	if (header.archiveSize != archiveSize || header.archiveTime != archiveTime || header.headerHash != hash)
+		return false;
+
+	wxUint64 tablesSize = (wxUint64)header.recordCount * sizeof(BSAIndexCacheRecord) + (wxUint64)header.chunkCount * sizeof(F4TexChunk) + header.namesLength;
+	if (tablesSize != cacheSize - sizeof(BSAIndexCacheHeader))
+		return false;
+
+	const BSAIndexCacheRecord *records = (const BSAIndexCacheRecord*)cursor;
+	const F4TexChunk *chunks = (const F4TexChunk*)(cursor + header.recordCount * sizeof(BSAIndexCacheRecord));
+	const char *names = (const char*)(chunks + header.chunkCount);
+
+	// Check the tables before anything is inserted
+	wxUint64 nameIndex = 0;
+	wxUint64 chunkIndex = 0;
+	for (wxUint32 i = 0; i < header.recordCount; i++) {
+		const BSAIndexCacheRecord &record = records[i];
+		if (record.folderLength > record.nameLength)
+			return false;
+
+		// Folder records have no file
+		if (record.folderLength == record.nameLength && (record.folderLength == 0 || record.chunkCount > 0))
+			return false;
+
+		nameIndex += record.nameLength;
+		chunkIndex += record.chunkCount;
+	}
+
+	if (nameIndex != header.namesLength || chunkIndex != header.chunkCount)
+		return false;
+
+	headerVersion = header.headerVersion;
+	numFiles = header.numFiles;
+	compressToggle = (header.flags & 1) != 0;
+	namePrefix = (header.flags & 2) != 0;
+
+	nameIndex = 0;
+	chunkIndex = 0;
+	BSAFolder *folder = &root;
+	std::string folderName;
+	if (headerVersion == F4_BSAHEADER_VERSION)
+		root.files.reserve(header.recordCount);
+
+	for (wxUint32 i = 0; i < header.recordCount; i++) {
+		const BSAIndexCacheRecord &record = records[i];
+		const char *name = names + nameIndex;
+		nameIndex += record.nameLength;
+
+		// Records are grouped by folder
+		if (record.folderLength == 0) {
+			folder = &root;
+			folderName.clear();
+		}
+		else if (folderName.size() != record.folderLength || folderName.compare(0, record.folderLength, name, record.folderLength) != 0) {
+			folderName.assign(name, record.folderLength);
+			folder = insertFolder(folderName);
+		}
+
+		if (record.folderLength == record.nameLength)
+			continue;
+
+		BSAFile *file = newFile();
+		file->sizeFlags = record.sizeFlags;
+		file->packedLength = record.packedLength;
+		file->unpackedLength = record.unpackedLength;
+		file->offset = record.offset;
+
+		if (record.chunkCount > 0) {
+			file->tex.header = record.texHeader;
+			file->tex.chunks.assign(chunks + chunkIndex, chunks + chunkIndex + record.chunkCount);
+			chunkIndex += record.chunkCount;
+		}
+
+		if (record.folderLength == 0)
+			folder->files.emplace(std::string(name, record.nameLength), file);
+		else
+			folder->files.emplace(std::string(name + record.folderLength + 1, record.nameLength - record.folderLength - 1), file);
+	}
+
+	return true;
+}
+
+void BSA::saveIndexCache(wxUint64 hash) {
+	std::vector<BSAIndexCacheRecord> records;
+	std::vector<F4TexChunk> chunks;
+	std::string names;
+	records.reserve(fileRecords.size());
+
+	auto addFiles = [&](const std::string &folderName, const BSAFolder *folder) {
+		// Folders with files are recreated by their files, the others get a record of their own
+		if (folder->files.empty() && !folderName.empty()) {
+			if (folderName.size() > 0xFFFF)
+				return false;
+
+			BSAIndexCacheRecord record = {};
+			record.nameLength = folderName.size();
+			record.folderLength = folderName.size();
+			records.push_back(record);
+			names += folderName;
+			return true;
+		}
+
+		for (auto &it : folder->files) {
+			const BSAFile *file = it.second;
+			size_t nameLength = it.first.size();
+			if (!folderName.empty())
+				nameLength += folderName.size() + 1;
+
+			if (nameLength > 0xFFFF || folderName.size() > 0xFFFF)
+				return false;
+
+			BSAIndexCacheRecord record = {};
+			record.offset = file->offset;
+			record.sizeFlags = file->sizeFlags;
+			record.packedLength = file->packedLength;
+			record.unpackedLength = file->unpackedLength;
+			record.nameLength = nameLength;
+			record.folderLength = folderName.size();
+			record.chunkCount = file->tex.chunks.size();
+			if (record.chunkCount > 0) {
+				record.texHeader = file->tex.header;
+				chunks.insert(chunks.end(), file->tex.chunks.begin(), file->tex.chunks.end());
+			}
+			records.push_back(record);
+
+			if (!folderName.empty()) {
+				names += folderName;
+				names += '/';
+			}
+			names += it.first;
+		}
+		return true;
+	};
+
+	if (!addFiles(std::string(), &root))
+		return;
+
+	for (auto &it : folders) {
+		if (it.second && it.second != &root && !addFiles(it.first, it.second))
+			return;
+	}
+
+	BSAIndexCacheHeader header = {};
+	header.magic = BSA_INDEXCACHE_FILEID;
+	header.version = BSA_INDEXCACHE_VERSION;
+	archiveStats(header.archiveSize, header.archiveTime);
+	header.headerHash = hash;
+	header.numFiles = numFiles;
+	header.headerVersion = headerVersion;
+	header.flags = (compressToggle ? 1 : 0) | (namePrefix ? 2 : 0);
+	header.recordCount = records.size();
+	header.chunkCount = chunks.size();
+	header.namesLength = names.size();
+
+	// Written under a temporary name, so that other instances never read a partial cache
+	std::string tempFile = indexCacheFile + ".tmp";
+	wxFile cache(tempFile, wxFile::write);
+	if (cache.Error())
+		return;
+
+	bool ok = cache.Write(&header, sizeof(header)) == sizeof(header);
+	ok = ok && cache.Write(records.data(), records.size() * sizeof(BSAIndexCacheRecord)) == records.size() * sizeof(BSAIndexCacheRecord);
+	ok = ok && cache.Write(chunks.data(), chunks.size() * sizeof(F4TexChunk)) == chunks.size() * sizeof(F4TexChunk);
+	ok = ok && cache.Write(names.data(), names.size()) == names.size();
+	cache.Close();
+
+	if (!ok || !wxRenameFile(tempFile, indexCacheFile, true))
+		wxRemoveFile(tempFile);
+}
+
 const BSA::BSAFolder *BSA::getFolder(std::string fn) const {
 	std::transform(fn.begin(), fn.end(), fn.begin(), ::tolower);
 
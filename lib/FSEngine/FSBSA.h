@@ -39,6 +39,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <wx/filename.h>
 #include <wx/thread.h>
 #include <unordered_map>
+#include <deque>
 
 
 /* Default header data */
@@ -178,6 +179,46 @@ struct F4Tex {
 	std::vector<F4TexChunk> chunks;
 };
 
+//! Minimum unpacked size of a BA2 texture for its chunks to be decompressed in parallel
+#define BSA_PARALLELCHUNK_SIZE 0x100000
+
+/* Index cache */
+#define BSA_INDEXCACHE_FILEID  0x58444953 //!< Magic for a cached archive index, the literal string "SIDX".
+#define BSA_INDEXCACHE_VERSION 0x02 //!< Version number of the cached index layout
+
+//! The header of a cached archive index.
+/*!
+* The cache is only used if size, modification time and header hash still match the archive.
+*/
+struct BSAIndexCacheHeader {
+	wxUint32 magic; //!< BSA_INDEXCACHE_FILEID
+	wxUint32 version; //!< BSA_INDEXCACHE_VERSION
+	wxUint64 archiveSize; //!< Size of the archive in bytes
+	wxInt64 archiveTime; //!< Modification time of the archive
+	wxUint64 headerHash; //!< Hash of the first bytes of the archive
+	wxUint64 numFiles; //!< BSA::numFiles
+	wxUint32 headerVersion; //!< BSA::headerVersion
+	wxUint32 flags; //!< 1 = BSA::compressToggle, 2 = BSA::namePrefix
+	wxUint32 recordCount; //!< Number of BSAIndexCacheRecord entries
+	wxUint32 chunkCount; //!< Number of F4TexChunk entries
+	wxUint64 namesLength; //!< Total length of the file paths
+};
+
+//! A file of a cached archive index, followed by its chunks and path in the respective tables
+/*!
+* A record whose path is only its folder (nameLength == folderLength) keeps a folder without files.
+*/
+struct BSAIndexCacheRecord {
+	wxUint64 offset; //!< Offset of the file in the archive
+	wxUint32 sizeFlags; //!< Size and flags of a Skyrim and earlier file
+	wxUint32 packedLength; //!< Packed length of a Fallout 4 file
+	wxUint32 unpackedLength; //!< Unpacked length of a Fallout 4 file
+	wxUint16 nameLength; //!< Length of the full path
+	wxUint16 folderLength; //!< Length of the folder part of the path, 0 for files of the root folder
+	wxUint32 chunkCount; //!< Number of texture chunks
+	F4TexInfo texHeader; //!< Texture header, if there are chunks
+};
+
 
 class BSA final : public FSArchiveFile {
 public:
@@ -209,6 +250,8 @@ public:
 	void addFilesOfFolders(const std::string&, std::vector<std::string>&) const override final;
 	//! Returns the entire file tree of the BSA
 	void fileTree(std::vector<std::string>&) const override final;
+	//! Adds the full paths of all files inside the BSA to the list
+	void fileList(std::vector<std::string>&) const override final;
 
 	//! Returns the contents of the specified file
 	/*!
@@ -218,6 +261,16 @@ public:
 	*/
 	bool fileContents(const std::string&, wxMemoryBuffer&) override final;
 
+	//! Returns the contents of the specified texture, without the mips larger than maxSize
+	/*!
+	* Only BA2 textures are trimmed, their chunks of the largest mips aren't read at all.
+	* \param fn The filename to get the contents for
+	* \param content Reference to the byte array that holds the file contents
+	* \param maxSize The largest width or height to keep, 0 keeps all mips
+	* \return True if successful
+	*/
+	bool textureContents(const std::string&, wxMemoryBuffer&, wxUint32 maxSize) override final;
+
 	//! Writes the contents to the specified file
 	bool exportFile(const std::string&, const std::string&) override final;
 
@@ -235,6 +288,9 @@ public:
 	//! Returns BSA::numFiles.
 	wxUint64 fileCount() const { return numFiles; }
 
+	//! Sets the folder the index of the %BSA is cached in; must be called before opening
+	void setIndexCacheDir(const std::string &dir);
+
 protected:
 	//! A file inside a BSA
 	struct BSAFile
@@ -266,8 +322,6 @@ protected:
 		~BSAFolder() {
 			for (auto &it : children)
 				delete it.second;
-			for (auto &it : files)
-				delete it.second;
 
 			children.clear();
 			files.clear();
@@ -275,9 +329,12 @@ protected:
 
 		BSAFolder *parent; //!< The parent item
 		std::unordered_map<std::string, BSAFolder*> children; //!< A map of child folders
-		std::unordered_map<std::string, BSAFile*> files; //!< A map of files inside the folder
+		std::unordered_map<std::string, BSAFile*> files; //!< A map of files inside the folder, owned by BSA::fileRecords
 	};
 
+	//! Creates a file record
+	BSAFile *newFile();
+
 	//! Recursive function to generate the tree structure of folders inside a %BSA
 	BSAFolder *insertFolder(std::string name);
 	BSAFolder *insertFolder(char* folder, int szFn);
@@ -285,6 +342,28 @@ protected:
 	BSAFile *insertFile(BSAFolder *folder, std::string name, wxUint32 sizeFlags, wxUint32 offset);
 	BSAFile *insertFile(char* filename, int szFn, wxUint32 packed, wxUint32 unpacked, wxUint64 offset, F4Tex* dds = nullptr);
 
+	//! Hash of the first bytes of the %BSA, identifies it for the index cache
+	wxUint64 headerHash();
+	//! Loads the folder and file records from the index cache, if it's valid for the %BSA
+	bool loadIndexCache(wxUint64 hash);
+	//! Writes the folder and file records to the index cache
+	void saveIndexCache(wxUint64 hash);
+	//! Size and modification time of the %BSA file
+	void archiveStats(wxUint64 &size, wxInt64 &time);
+
+	//! Appends the DDS header and data of a BA2 texture, starting at mip firstMip
+	bool texContents(const F4Tex &tex, wxUint32 firstMip, wxMemoryBuffer &content) const;
+	//! Appends the data of all chunks of a BA2 texture that hold mip firstMip or smaller
+	bool texChunkContents(const F4Tex &tex, wxUint32 firstMip, wxMemoryBuffer &content) const;
+	//! Reads and decompresses a BA2 texture chunk to dst, leaving out its first skip bytes
+	bool texChunkContents(const F4TexChunk &chunk, wxUint32 skip, char *dst) const;
+
+	//! Reads from the given offset of the %BSA without using the shared file position
+	/*!
+	* On Windows the read still moves the file position, so it can't be mixed with reads through the wxFile.
+	*/
+	bool readAt(wxUint64 offset, void *data, size_t size) const;
+
 	//! Gets the specified folder, or the root folder if not found
 	const BSAFolder *getFolder(std::string fn) const;
 	//! Gets the specified file, or null if not found
@@ -295,7 +374,7 @@ protected:
 	//! File info for the %BSA
 	wxFileName bsaInfo;
 
-	//! Mutual exclusion handler
+	//! Mutual exclusion handler for opening and closing, reads don't need it
 	wxMutex bsaMutex;
 
 	//! The absolute name of the file, e.g. "d:/temp/test.bsa"
@@ -309,6 +388,11 @@ protected:
 	std::unordered_map<std::string, BSAFolder*> folders;
 	//! The root folder
 	BSAFolder root;
+	//! Storage of all file records
+	std::deque<BSAFile> fileRecords;
+
+	//! File path of the index cache, empty if not cached
+	std::string indexCacheFile;
 
 	//! Error string for exception handling
 	std::string status;
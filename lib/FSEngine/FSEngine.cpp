@@ -36,9 +36,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 //! \file fsengine.cpp File system engine implementations
 
-FSArchiveHandler *FSArchiveHandler::openArchive(const std::string &fn) {
+FSArchiveHandler *FSArchiveHandler::openArchive(const std::string &fn, const std::string &indexCacheDir) {
 	if (BSA::canOpen(fn)) {
 		BSA *bsa = new BSA(fn);
+		bsa->setIndexCacheDir(indexCacheDir);
 		if (bsa->open())
 			return new FSArchiveHandler(bsa);
 
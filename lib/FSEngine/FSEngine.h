@@ -42,8 +42,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 class FSArchiveHandler
 {
 public:
-	//! Opens a BSA for the specified file
-	static FSArchiveHandler *openArchive(const std::string&);
+	//! Opens a BSA for the specified file, caching its index in the folder if one is given
+	static FSArchiveHandler *openArchive(const std::string&, const std::string &indexCacheDir = std::string());
 
 public:
 	//! Constructor
@@ -78,7 +78,9 @@ public:
 	virtual wxInt64 fileSize(const std::string&) const = 0;
 	virtual void addFilesOfFolders(const std::string&, std::vector<std::string>&) const = 0;
 	virtual void fileTree(std::vector<std::string>&) const = 0;
+	virtual void fileList(std::vector<std::string>&) const = 0;
 	virtual bool fileContents(const std::string&, wxMemoryBuffer&) = 0;
+	virtual bool textureContents(const std::string&, wxMemoryBuffer&, wxUint32 maxSize) = 0;
 	virtual bool exportFile(const std::string&, const std::string&) = 0;
 	virtual std::string absoluteFilePath(const std::string&) const = 0;
 
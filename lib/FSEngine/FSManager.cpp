@@ -34,6 +34,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "FSManager.h"
 #include "FSEngine.h"
 
+#include <wx/filename.h>
+
 #include <algorithm>
 #include <iterator>
 
@@ -41,6 +43,12 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //! Global BSA file manager
 static FSManager *theFSManager = nullptr;
 
+//! Folder the indices of archives are cached in
+static std::string indexCacheDir;
+
+//! Runs the parallel parts of archive reads, set by the application
+static FSManager::ParallelFor parallelForFunc;
+
 FSManager* FSManager::get() {
 	if (!theFSManager)
 		theFSManager = new FSManager();
@@ -59,18 +67,145 @@ void FSManager::del() {
 }
 
 std::list<FSArchiveFile*> FSManager::archiveList() {
+	FSManager *manager = get();
+
+	std::lock_guard<std::mutex> lock(manager->openLock);
+	manager->openArchives();
+
 	std::list<FSArchiveFile*> archives;
 
-	std::transform(get()->archives.begin(), get()->archives.end(), std::back_inserter(archives),
+	std::transform(manager->archives.begin(), manager->archives.end(), std::back_inserter(archives),
 		[](std::map<std::string, FSArchiveHandler*>::value_type& val){ return val.second->getArchive(); });
 
 	return archives;
 }
 
 void FSManager::addArchives(const std::vector<std::string>& archiveList) {
-	for (auto &archive : archiveList) {
-		if (FSArchiveHandler *a = FSArchiveHandler::openArchive(archive))
-			get()->archives[archive] = a;
+	FSManager *manager = get();
+
+	std::lock_guard<std::mutex> lock(manager->openLock);
+	for (auto &archive : archiveList)
+		if (manager->archives.find(archive) == manager->archives.end())
+			manager->pendingArchives.insert(archive);
+}
+
+void FSManager::setIndexCacheDir(const std::string& dir) {
+	indexCacheDir = dir;
+	if (!indexCacheDir.empty() && !wxFileName::DirExists(indexCacheDir)) {
+		if (!wxFileName::Mkdir(indexCacheDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+			indexCacheDir.clear();
+	}
+}
+
+FSArchiveFile *FSManager::resolve(const std::string& path) {
+	if (!theFSManager)
+		return nullptr;
+
+	std::string file = normalizePath(path);
+
+	std::lock_guard<std::mutex> lock(theFSManager->openLock);
+	return theFSManager->findFile(file);
+}
+
+//! Calls read with the archive of the index first and the other archives containing the file after, until one succeeds
+template<typename Read>
+static bool readFromArchives(const std::string& path, wxMemoryBuffer& content, const Read& read) {
+	FSArchiveFile *indexed = FSManager::resolve(path);
+	if (!indexed)
+		return false;
+
+	wxMemoryBuffer data;
+	if (read(indexed, data) && !data.IsEmpty()) {
+		content = std::move(data);
+		return true;
+	}
+
+	for (FSArchiveFile *archive : FSManager::archiveList()) {
+		if (!archive || archive == indexed || !archive->hasFile(path))
+			continue;
+
+		wxMemoryBuffer fallbackData;
+		if (read(archive, fallbackData) && !fallbackData.IsEmpty()) {
+			content = std::move(fallbackData);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FSManager::fileContents(const std::string& path, wxMemoryBuffer& content) {
+	return readFromArchives(path, content, [&](FSArchiveFile *archive, wxMemoryBuffer& data) {
+		return archive->fileContents(path, data);
+	});
+}
+
+bool FSManager::textureContents(const std::string& path, wxMemoryBuffer& content, unsigned int maxSize) {
+	return readFromArchives(path, content, [&](FSArchiveFile *archive, wxMemoryBuffer& data) {
+		return archive->textureContents(path, data, maxSize);
+	});
+}
+
+std::string FSManager::normalizePath(std::string path) {
+	std::replace(path.begin(), path.end(), '\\', '/');
+	std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+	return path;
+}
+
+void FSManager::setParallelFor(const ParallelFor& func) {
+	parallelForFunc = func;
+}
+
+void FSManager::parallelFor(int count, const std::function<void(int)>& func) {
+	if (parallelForFunc) {
+		parallelForFunc(count, func);
+		return;
+	}
+
+	for (int i = 0; i < count; i++)
+		func(i);
+}
+
+void FSManager::openArchives() {
+	while (!pendingArchives.empty())
+		openNextArchive();
+}
+
+void FSManager::openNextArchive() {
+	std::string path = *pendingArchives.begin();
+	pendingArchives.erase(pendingArchives.begin());
+
+	FSArchiveHandler *a = FSArchiveHandler::openArchive(path, indexCacheDir);
+	if (!a)
+		return;
+
+	auto it = archives.emplace(path, a).first;
+	FSArchiveFile *archive = a->getArchive();
+	if (!archive)
+		return;
+
+	std::vector<std::string> files;
+	archive->fileList(files);
+
+	// Archives added later can come first in the order, their files replace the ones of later archives
+	IndexEntry entry = { &it->first, archive };
+	fileIndex.reserve(fileIndex.size() + files.size());
+	for (auto &file : files) {
+		auto indexed = fileIndex.emplace(std::move(file), entry);
+		if (!indexed.second && *indexed.first->second.archivePath > path)
+			indexed.first->second = entry;
+	}
+}
+
+FSArchiveFile *FSManager::findFile(const std::string& file) {
+	for (;;) {
+		auto it = fileIndex.find(file);
+
+		// Pending archives before the one found could provide the file as well and would win
+		if (pendingArchives.empty() || (it != fileIndex.end() && *pendingArchives.begin() > *it->second.archivePath))
+			return it != fileIndex.end() ? it->second.archive : nullptr;
+
+		openNextArchive();
 	}
 }
 
@@ -82,4 +217,5 @@ FSManager::~FSManager() {
 		delete it.second;
 
 	archives.clear();
+	fileIndex.clear();
 }
@@ -34,11 +34,17 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <vector>
 #include <map>
+#include <set>
 #include <list>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
 
 
 class FSArchiveHandler;
 class FSArchiveFile;
+class wxMemoryBuffer;
 
 //! The file system manager class.
 class FSManager {
@@ -52,7 +58,35 @@ public:
 	//! Gets the list of globally registered BSA files
 	static std::list<FSArchiveFile*> archiveList();
 	//! Adds archives to the global list
+	/*!
+	* The archives are opened when files are looked up, not here.
+	*/
 	static void addArchives(const std::vector<std::string>&);
+	//! Sets the folder that the indices of archives are cached in, an empty path disables the cache
+	static void setIndexCacheDir(const std::string&);
+	//! Gets the archive that provides the file, or null if no archive contains it
+	/*!
+	* Looks the path up in the merged index of the opened archives. The path is matched case-insensitively,
+	* with either kind of slash. Loose files aren't indexed, callers try the data folder first.
+	* Only the archives that come before the one providing the file are opened, a missing file opens all of them.
+	*/
+	static FSArchiveFile *resolve(const std::string&);
+	//! Reads a file from the archive that provides it
+	/*!
+	* If reading from the indexed archive fails or returns nothing, the other archives that contain the file are tried in order.
+	*/
+	static bool fileContents(const std::string&, wxMemoryBuffer&);
+	//! Reads a texture like fileContents, without the mips larger than maxSize
+	static bool textureContents(const std::string&, wxMemoryBuffer&, unsigned int maxSize);
+	//! Converts a path to the lower case, forward slash form used as key of the index
+	static std::string normalizePath(std::string);
+
+	//! Calls func(i) for every i in [0, count) and returns once all calls are done
+	typedef std::function<void(int count, const std::function<void(int)>& func)> ParallelFor;
+	//! Sets how archives split reads over several threads, without one everything is read on the calling thread
+	static void setParallelFor(const ParallelFor&);
+	//! Calls func(i) for every i in [0, count) through the function set with setParallelFor
+	static void parallelFor(int count, const std::function<void(int)>& func);
 
 protected:
 	//! Constructor
@@ -60,5 +94,28 @@ protected:
 	//! Destructor
 	~FSManager();
 
+	//! An archive providing a file, with the key of the archive in FSManager::archives
+	struct IndexEntry {
+		const std::string *archivePath;
+		FSArchiveFile *archive;
+	};
+
+	//! Opens all archives that were added since the last lookup, the lock has to be held
+	void openArchives();
+	//! Opens the first pending archive and adds its files to the index, the lock has to be held
+	void openNextArchive();
+	//! Looks up a normalized path, opening pending archives as needed, the lock has to be held
+	FSArchiveFile *findFile(const std::string&);
+
 	std::map<std::string, FSArchiveHandler*> archives;
+
+	//! Paths of archives that haven't been opened yet, in the order of FSManager::archives
+	std::set<std::string> pendingArchives;
+
+	//! Guards all members, lookups may open archives and change the index
+	std::mutex openLock;
+
+	//! Normalized file path to the archive it's read from.
+	//! When several archives contain a file, the first one in the order of FSManager::archives wins.
+	std::unordered_map<std::string, IndexEntry> fileIndex;
 };
@@ -5,6 +5,7 @@ See the included LICENSE file
 */
 
 #include "BasicTypes.h"
+#include "utils/StringUtil.h"
 
 std::string NiVersion::GetVersionInfo() {
 	return vstr +
@@ -97,6 +98,9 @@ void NiHeader::Clear() {
 	blockTypeIndices.clear();
 	blockSizes.clear();
 	strings.clear();
+	stringIds.clear();
+	stringIdsValid = false;
+	blockRevision++;
 }
 
 std::string NiHeader::GetCreatorInfo() {
@@ -168,6 +172,8 @@ void NiHeader::DeleteBlock(int blockId) {
 	// Next tell all the blocks that the deletion happened
 	for (auto &b : (*blocks))
 		BlockDeleted(b.get(), blockId);
+
+	blockRevision++;
 }
 
 void NiHeader::DeleteBlockByType(const std::string& blockTypeStr) {
@@ -184,8 +190,79 @@ void NiHeader::DeleteBlockByType(const std::string& blockTypeStr) {
 		if (blockTypeIndices[i] == blockTypeId)
 			indices.push_back(i);
 
-	for (int j = indices.size() - 1; j >= 0; j--)
-		DeleteBlock(indices[j]);
+	DeleteBlocks(indices);
+}
+
+void NiHeader::DeleteBlocks(const std::vector<int>& blockIds) {
+	std::vector<bool> deleted(numBlocks, false);
+	bool hasDeletions = false;
+	for (auto &id : blockIds) {
+		if (id >= 0 && id < numBlocks) {
+			deleted[id] = true;
+			hasDeletions = true;
+		}
+	}
+
+	if (!hasDeletions)
+		return;
+
+	// Old to new block indices, compacting the block lists in the same pass
+	int oldNumBlocks = numBlocks;
+	std::vector<int> newIndices(oldNumBlocks, 0xFFFFFFFF);
+	int n = 0;
+	for (int i = 0; i < oldNumBlocks; i++) {
+		if (deleted[i])
+			continue;
+
+		newIndices[i] = n;
+		if (n != i) {
+			(*blocks)[n] = std::move((*blocks)[i]);
+			blockTypeIndices[n] = blockTypeIndices[i];
+			blockSizes[n] = blockSizes[i];
+		}
+		n++;
+	}
+
+	blocks->resize(n);
+	blockTypeIndices.resize(n);
+	blockSizes.resize(n);
+	numBlocks = n;
+	blockRevision++;
+
+	// Remove block types that aren't used anymore
+	std::vector<int> newTypeIndices(blockTypes.size(), 0xFFFFFFFF);
+	for (auto &t : blockTypeIndices)
+		newTypeIndices[t] = 0;
+
+	int numTypes = 0;
+	for (int i = 0; i < blockTypes.size(); i++) {
+		if (newTypeIndices[i] == 0xFFFFFFFF)
+			continue;
+
+		newTypeIndices[i] = numTypes;
+		if (numTypes != i)
+			blockTypes[numTypes] = blockTypes[i];
+		numTypes++;
+	}
+
+	blockTypes.resize(numTypes);
+	numBlockTypes = numTypes;
+	for (auto &t : blockTypeIndices)
+		t = newTypeIndices[t];
+
+	// Next update the references of all remaining blocks at once
+	std::set<int*> refs;
+	for (auto &b : (*blocks)) {
+		refs.clear();
+		b->GetChildRefs(refs);
+		b->GetPtrs(refs);
+
+		for (auto &r : refs) {
+			auto& index = (*r);
+			if (index >= 0 && index < oldNumBlocks)
+				index = newIndices[index];
+		}
+	}
 }
 
 int NiHeader::AddBlock(NiObject* newBlock) {
@@ -194,6 +271,7 @@ int NiHeader::AddBlock(NiObject* newBlock) {
 	blockSizes.push_back(newBlock->CalcBlockSize(version));
 	blocks->push_back(std::move(std::unique_ptr<NiObject>(newBlock)));
 	numBlocks = blocks->size();
+	blockRevision++;
 	return numBlocks - 1;
 }
 
@@ -220,6 +298,7 @@ int NiHeader::ReplaceBlock(int oldBlockId, NiObject* newBlock) {
 	blockSizes[oldBlockId] = newBlock->CalcBlockSize(version);
 	auto blockPtrSwap = std::unique_ptr<NiObject>(newBlock);
 	(*blocks)[oldBlockId].swap(blockPtrSwap);
+	blockRevision++;
 	return oldBlockId;
 }
 
@@ -235,6 +314,8 @@ void NiHeader::SwapBlocks(const int blockIndexLo, const int blockIndexHi) {
 	// Next tell all the blocks that the swap happened
 	for (auto &b : (*blocks))
 		BlockSwapped(b.get(), blockIndexLo, blockIndexHi);
+
+	blockRevision++;
 }
 
 bool NiHeader::IsBlockReferenced(const int blockId) {
@@ -254,17 +335,44 @@ bool NiHeader::IsBlockReferenced(const int blockId) {
 }
 
 void NiHeader::DeleteUnreferencedBlocks(bool* hadDeletions) {
-	for (int i = 1; i < numBlocks; i++) {
-		if (!IsBlockReferenced(i)) {
-			DeleteBlock(i);
+	if (numBlocks == 0)
+		return;
 
-			// Deleting a block can cause others to become unreferenced
-			if (hadDeletions)
-				(*hadDeletions) = true;
+	// Mark all blocks that can be reached from the root through child references
+	std::vector<bool> referenced(numBlocks, false);
+	std::vector<int> pending(1, 0);
+	referenced[0] = true;
 
-			return DeleteUnreferencedBlocks();
+	std::set<int*> refs;
+	while (!pending.empty()) {
+		int blockId = pending.back();
+		pending.pop_back();
+
+		refs.clear();
+		(*blocks)[blockId]->GetChildRefs(refs);
+
+		for (auto &r : refs) {
+			int index = (*r);
+			if (index >= 0 && index < numBlocks && !referenced[index]) {
+				referenced[index] = true;
+				pending.push_back(index);
+			}
 		}
 	}
+
+	// Sweep all others in one batch
+	std::vector<int> unreferenced;
+	for (int i = 1; i < numBlocks; i++)
+		if (!referenced[i])
+			unreferenced.push_back(i);
+
+	if (unreferenced.empty())
+		return;
+
+	DeleteBlocks(unreferenced);
+
+	if (hadDeletions)
+		(*hadDeletions) = true;
 }
 
 ushort NiHeader::AddOrFindBlockTypeId(const std::string& blockTypeName) {
@@ -299,10 +407,26 @@ void NiHeader::CalcAllBlockSizes() {
 		blockSizes[i] = blocks->at(i)->CalcBlockSize(version);
 }
 
-int NiHeader::FindStringId(const std::string& str) {
+void NiHeader::UpdateStringIds() {
+	if (stringIdsValid)
+		return;
+
+	stringIds.clear();
+	stringIds.reserve(strings.size());
+
+	// Duplicates keep the first ID
 	for (int i = 0; i < strings.size(); i++)
-		if (strings[i].GetString().compare(str) == 0)
-			return i;
+		stringIds.emplace(strings[i].GetString(), i);
+
+	stringIdsValid = true;
+}
+
+int NiHeader::FindStringId(const std::string& str) {
+	UpdateStringIds();
+
+	auto it = stringIds.find(str);
+	if (it != stringIds.end())
+		return it->second;
 
 	return 0xFFFFFFFF;
 }
@@ -311,11 +435,11 @@ int NiHeader::AddOrFindStringId(const std::string& str) {
 	if (str.empty())
 		return 0xFFFFFFFF;
 
-	for (int i = 0; i < strings.size(); i++) {
-		if (strings[i].GetString().compare(str) == 0) {
-			return i;
-		}
-	}
+	UpdateStringIds();
+
+	auto it = stringIds.find(str);
+	if (it != stringIds.end())
+		return it->second;
 
 	int r = strings.size();
 
@@ -324,6 +448,7 @@ int NiHeader::AddOrFindStringId(const std::string& str) {
 	strings.push_back(niStr);
 	numStrings++;
 
+	stringIds.emplace(str, r);
 	return r;
 }
 
@@ -335,12 +460,16 @@ std::string NiHeader::GetStringById(const int id) {
 }
 
 void NiHeader::SetStringById(const int id, const std::string& str) {
-	if (id >= 0 && id < numStrings)
+	if (id >= 0 && id < numStrings) {
 		strings[id].SetString(str);
+		stringIdsValid = false;
+	}
 }
 
 void NiHeader::ClearStrings() {
 	strings.clear();
+	stringIds.clear();
+	stringIdsValid = false;
 	numStrings = 0;
 	maxStringLen = 0;
 }
@@ -362,6 +491,9 @@ void NiHeader::FillStringRefs() {
 			r->SetString(str);
 		}
 	}
+
+	// Names of blocks may have changed
+	blockRevision++;
 }
 
 void NiHeader::UpdateHeaderStrings(const bool hasUnknown) {
@@ -412,7 +544,7 @@ void NiHeader::BlockSwapped(NiObject* o, int blockIndexLo, int blockIndexHi) {
 void NiHeader::Get(NiStream& stream) {
 	char ver[256];
 	stream.getline(ver, sizeof(ver));
-	if (_strnicmp(ver, "Gamebryo", 8) != 0)
+	if (StrNICmp(ver, "Gamebryo", 8) != 0)
 		return;
 
 	byte v1, v2, v3, v4;
@@ -438,12 +570,10 @@ void NiHeader::Get(NiStream& stream) {
 		blockTypes[i].Get(stream, 4);
 
 	blockTypeIndices.resize(numBlocks);
-	for (int i = 0; i < numBlocks; i++)
-		stream >> blockTypeIndices[i];
+	stream.readArray(blockTypeIndices.data(), numBlocks);
 
 	blockSizes.resize(numBlocks);
-	for (int i = 0; i < numBlocks; i++)
-		stream >> blockSizes[i];
+	stream.readArray(blockSizes.data(), numBlocks);
 
 	stream >> numStrings;
 	stream >> maxStringLen;
@@ -452,6 +582,8 @@ void NiHeader::Get(NiStream& stream) {
 	for (int i = 0; i < numStrings; i++)
 		strings[i].Get(stream, 4);
 
+	stringIdsValid = false;
+
 	stream >> unkInt2;
 	valid = true;
 }
@@ -8,9 +8,12 @@ See the included LICENSE file
 
 #include "utils/Object3d.h"
 
+#include <cstring>
+#include <iostream>
 #include <set>
 #include <streambuf>
 #include <string>
+#include <unordered_map>
 #include <algorithm>
 #include <memory>
 
@@ -42,22 +45,64 @@ private:
 	std::iostream* stream = nullptr;
 	NiVersion* version = nullptr;
 
+	// Data read from memory without a stream
+	const char* data = nullptr;
+	size_t dataSize = 0;
+	size_t dataPos = 0;
+
 public:
 	NiStream(std::iostream* stream, NiVersion* version) {
 		this->stream = stream;
 		this->version = version;
 	}
 
+	// Read-only stream over data in memory, which has to stay valid while reading
+	NiStream(const char* data, size_t dataSize, NiVersion* version) {
+		this->data = data;
+		this->dataSize = dataSize;
+		this->version = version;
+	}
+
 	void write(const char* ptr, std::streamsize count) {
 		stream->write(ptr, count);
 	}
 
 	void read(char* ptr, std::streamsize count) {
-		stream->read(ptr, count);
+		if (stream) {
+			stream->read(ptr, count);
+			return;
+		}
+
+		// Reading past the end stops at the end like a stream does
+		size_t size = std::min((size_t)count, dataSize - dataPos);
+		memcpy(ptr, data + dataPos, size);
+		dataPos += size;
+	}
+
+	// Reads count consecutive elements at once, same as reading them one by one
+	template<typename T>
+	void readArray(T* ptr, size_t count) {
+		read((char*)ptr, count * sizeof(T));
 	}
 
 	void getline(char* ptr, std::streamsize maxCount) {
-		stream->getline(ptr, maxCount);
+		if (stream) {
+			stream->getline(ptr, maxCount);
+			return;
+		}
+
+		if (maxCount <= 0)
+			return;
+
+		// The delimiter is skipped but not stored
+		std::streamsize count = 0;
+		while (count + 1 < maxCount && dataPos < dataSize && data[dataPos] != '\n')
+			ptr[count++] = data[dataPos++];
+
+		if (dataPos < dataSize && data[dataPos] == '\n')
+			dataPos++;
+
+		ptr[count] = '\0';
 	}
 
 	// Be careful with sizes of structs and classes
@@ -246,23 +291,23 @@ template <typename T>
 class BlockRefShortArray : public BlockRefArray<T> {
 public:
 	virtual void Get(NiStream& stream) override {
-		stream.read((char*)&arraySize, 2);
-		refs.resize(arraySize);
+		stream.read((char*)&this->arraySize, 2);
+		this->refs.resize(this->arraySize);
 
-		for (auto &r : refs)
+		for (auto &r : this->refs)
 			r.Get(stream);
 	}
 
 	virtual void Put(NiStream& stream) override {
-		stream.write((char*)&arraySize, 2);
+		stream.write((char*)&this->arraySize, 2);
 
-		for (auto &r : refs)
+		for (auto &r : this->refs)
 			r.Put(stream);
 	}
 
 	virtual int CalcBlockSize() override {
-		CleanInvalidRefs();
-		return 2 + arraySize * 4;
+		this->CleanInvalidRefs();
+		return 2 + this->arraySize * 4;
 	}
 };
 
@@ -362,8 +407,17 @@ private:
 	uint maxStringLen;
 	std::vector<NiString> strings;
 
+	// First ID of each string, rebuilt after the strings were changed in place
+	std::unordered_map<std::string, int> stringIds;
+	bool stringIdsValid = false;
+
 	uint unkInt2;
 
+	// Changes whenever blocks are added, deleted, replaced or moved
+	uint blockRevision = 0;
+
+	void UpdateStringIds();
+
 public:
 	NiHeader();
 
@@ -386,6 +440,7 @@ public:
 	};
 
 	uint GetNumBlocks() { return numBlocks; }
+	uint GetBlockRevision() { return blockRevision; }
 
 	template <class T>
 	T* GetBlock(const int blockId) {
@@ -397,12 +452,17 @@ public:
 
 	void DeleteBlock(int blockId);
 	void DeleteBlockByType(const std::string& blockTypeStr);
+
+	// Deletes all listed blocks at once, updating the references of the remaining blocks in a single pass
+	void DeleteBlocks(const std::vector<int>& blockIds);
 	int AddBlock(NiObject* newBlock);
 	int ReplaceBlock(int oldBlockId, NiObject* newBlock);
 
 	// Swaps two blocks, updating references in other blocks that may refer to their old indices
 	void SwapBlocks(const int blockIndexLo, const int blockIndexHi);
 	bool IsBlockReferenced(const int blockId);
+
+	// Deletes all blocks that can't be reached from the root block through child references
 	void DeleteUnreferencedBlocks(bool* hadDeletions = nullptr);
 
 	ushort AddOrFindBlockTypeId(const std::string& blockTypeName);
@@ -57,8 +57,7 @@ void NiBinaryExtraData::Get(NiStream& stream) {
 
 	stream >> size;
 	data.resize(size);
-	for (int i = 0; i < size; i++)
-		stream >> data[i];
+	stream.readArray(data.data(), size);
 }
 
 void NiBinaryExtraData::Put(NiStream& stream) {
@@ -402,12 +401,10 @@ void BSDecalPlacementVectorExtraData::Get(NiStream& stream) {
 		stream >> decalVectorBlocks[i].numVectors;
 
 		decalVectorBlocks[i].points.resize(decalVectorBlocks[i].numVectors);
-		for (int j = 0; j < decalVectorBlocks[i].numVectors; j++)
-			stream >> decalVectorBlocks[i].points[j];
+		stream.readArray(decalVectorBlocks[i].points.data(), decalVectorBlocks[i].numVectors);
 
 		decalVectorBlocks[i].normals.resize(decalVectorBlocks[i].numVectors);
-		for (int j = 0; j < decalVectorBlocks[i].numVectors; j++)
-			stream >> decalVectorBlocks[i].normals[j];
+		stream.readArray(decalVectorBlocks[i].normals.data(), decalVectorBlocks[i].numVectors);
 	}
 }
 
@@ -7,7 +7,8 @@ See the included LICENSE file
 #include "Geometry.h"
 #include "Skin.h"
 
-#include "utils/half.hpp"
+#include "utils/GeometryKernels.h"
+#include "utils/HalfFloat.h"
 #include "utils/KDMatcher.h"
 
 void NiGeometryData::Init() {
@@ -25,8 +26,7 @@ void NiGeometryData::Get(NiStream& stream) {
 
 	if (hasVertices && !isPSys) {
 		vertices.resize(numVertices);
-		for (int i = 0; i < numVertices; i++)
-			stream >> vertices[i];
+		stream.readArray(vertices.data(), numVertices);
 	}
 
 	stream >> numUVSets;
@@ -43,18 +43,15 @@ void NiGeometryData::Get(NiStream& stream) {
 	if (hasNormals && !isPSys) {
 		normals.resize(numVertices);
 
-		for (int i = 0; i < numVertices; i++)
-			stream >> normals[i];
+		stream.readArray(normals.data(), numVertices);
 
 		if (nbtMethod) {
 			tangents.resize(numVertices);
 			bitangents.resize(numVertices);
 
-			for (int i = 0; i < numVertices; i++)
-				stream >> tangents[i];
+			stream.readArray(tangents.data(), numVertices);
 
-			for (int i = 0; i < numVertices; i++)
-				stream >> bitangents[i];
+			stream.readArray(bitangents.data(), numVertices);
 		}
 	}
 
@@ -63,14 +60,12 @@ void NiGeometryData::Get(NiStream& stream) {
 	stream >> hasVertexColors;
 	if (hasVertexColors && !isPSys) {
 		vertexColors.resize(numVertices);
-		for (int i = 0; i < numVertices; i++)
-			stream >> vertexColors[i];
+		stream.readArray(vertexColors.data(), numVertices);
 	}
 
 	if (numTextureSets > 0 && !isPSys) {
 		uvSets.resize(numVertices);
-		for (int i = 0; i < numVertices; i++)
-			stream >> uvSets[i];
+		stream.readArray(uvSets.data(), numVertices);
 	}
 
 	stream >> consistencyFlags;
@@ -220,36 +215,14 @@ void NiGeometryData::Create(std::vector<Vector3>* verts, std::vector<Triangle>*
 }
 
 void NiGeometryData::notifyVerticesDelete(const std::vector<ushort>& vertIndices) {
-	std::vector<int> indexCollapse(vertices.size(), 0);
-	bool hasNorm = normals.size() > 0;
-	bool hasTan = tangents.size() > 0;
-	bool hasBin = bitangents.size() > 0;
-	bool hasCol = vertexColors.size() > 0;
-	bool hasUV = uvSets.size() > 0;
-
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < vertIndices.size() && vertIndices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;	// Flag delete
-			j++;
-		}
-	}
-
-	for (int i = vertices.size() - 1; i >= 0; i--) {
-		if (indexCollapse[i] == -1) {
-			vertices.erase(vertices.begin() + i);
-			numVertices--;
-			if (hasNorm)
-				normals.erase(normals.begin() + i);
-			if (hasTan)
-				tangents.erase(tangents.begin() + i);
-			if (hasBin)
-				bitangents.erase(bitangents.begin() + i);
-			if (hasCol)
-				vertexColors.erase(vertexColors.begin() + i);
-			if (hasUV)
-				uvSets.erase(uvSets.begin() + i);
-		}
-	}
+	IndexCollapse indexCollapse(vertIndices);
+	indexCollapse.CompactData(vertices);
+	indexCollapse.CompactData(normals);
+	indexCollapse.CompactData(tangents);
+	indexCollapse.CompactData(bitangents);
+	indexCollapse.CompactData(vertexColors);
+	indexCollapse.CompactData(uvSets);
+	numVertices = vertices.size();
 }
 
 void NiGeometryData::RecalcNormals(const bool smooth, const float smoothThresh) {
@@ -417,8 +390,7 @@ void BSTriShape::Get(NiStream& stream) {
 	stream >> flags;
 	stream >> translation;
 
-	for (int i = 0; i < 3; i++)
-		stream >> rotation[i];
+	stream.readArray(rotation, 3);
 
 	stream >> scale;
 	collisionRef.Get(stream);
@@ -451,75 +423,13 @@ void BSTriShape::Get(NiStream& stream) {
 
 	vertData.resize(numVertices);
 
-	if (dataSize > 0) {
-		half_float::half halfData;
-		for (int i = 0; i < numVertices; i++) {
-			if (HasVertices()) {
-				if (IsFullPrecision() || stream.GetVersion().User2() == 100) {
-					// Full precision
-					stream >> vertData[i].vert;
-					stream >> vertData[i].bitangentX;
-				}
-				else {
-					// Half precision
-					stream.read((char*)&halfData, 2);
-					vertData[i].vert.x = halfData;
-					stream.read((char*)&halfData, 2);
-					vertData[i].vert.y = halfData;
-					stream.read((char*)&halfData, 2);
-					vertData[i].vert.z = halfData;
-
-					stream.read((char*)&halfData, 2);
-					vertData[i].bitangentX = halfData;
-				}
-			}
-
-			if (HasUVs()) {
-				stream.read((char*)&halfData, 2);
-				vertData[i].uv.u = halfData;
-				stream.read((char*)&halfData, 2);
-				vertData[i].uv.v = halfData;
-			}
-
-			if (HasNormals()) {
-				for (int j = 0; j < 3; j++)
-					stream >> vertData[i].normal[j];
-
-				stream >> vertData[i].bitangentY;
-
-				if (HasTangents()) {
-					for (int j = 0; j < 3; j++)
-						stream >> vertData[i].tangent[j];
-
-					stream >> vertData[i].bitangentZ;
-				}
-			}
-
-
-			if (HasVertexColors())
-				for (int j = 0; j < 4; j++)
-					stream >> vertData[i].colorData[j];
-
-			if (IsSkinned()) {
-				for (int j = 0; j < 4; j++) {
-					stream.read((char*)&halfData, 2);
-					vertData[i].weights[j] = halfData;
-				}
-
-				for (int j = 0; j < 4; j++)
-					stream >> vertData[i].weightBones[j];
-			}
-
-			if ((vertFlags7 & (1 << 4)) != 0)
-				stream >> vertData[i].eyeData;
-		}
-	}
+	if (dataSize > 0)
+		GetVertexData(stream);
 
 	triangles.resize(numTriangles);
 
 	if (dataSize > 0) {
-		for (int i = 0; i < numTriangles; i++)
-			stream >> triangles[i];
+		stream.readArray(triangles.data(), numTriangles);
 	}
 
 	if (stream.GetVersion().User() == 12 && stream.GetVersion().User2() == 100) {
@@ -530,27 +440,14 @@ void BSTriShape::Get(NiStream& stream) {
 			particleNorms.resize(numVertices);
 			particleTris.resize(numTriangles);
 
-			half_float::half halfData;
-			for (int i = 0; i < numVertices; i++) {
-				stream.read((char*)&halfData, 2);
-				particleVerts[i].x = halfData;
-				stream.read((char*)&halfData, 2);
-				particleVerts[i].y = halfData;
-				stream.read((char*)&halfData, 2);
-				particleVerts[i].z = halfData;
-			}
+			std::vector<ushort> halves(numVertices * 3);
+			stream.readArray(halves.data(), halves.size());
+			HalfFloat::ToFloat(halves.data(), (float*)particleVerts.data(), halves.size());
 
-			for (int i = 0; i < numVertices; i++) {
-				stream.read((char*)&halfData, 2);
-				particleNorms[i].x = halfData;
-				stream.read((char*)&halfData, 2);
-				particleNorms[i].y = halfData;
-				stream.read((char*)&halfData, 2);
-				particleNorms[i].z = halfData;
-			}
+			stream.readArray(halves.data(), halves.size());
+			HalfFloat::ToFloat(halves.data(), (float*)particleNorms.data(), halves.size());
 
-			for (int i = 0; i < numTriangles; i++)
-				stream >> particleTris[i];
+			stream.readArray(particleTris.data(), numTriangles);
 		}
 	}
 }
@@ -608,142 +505,244 @@ void BSTriShape::Put(NiStream& stream) {
 		stream << numVertices;
 		stream << dataSize;
 
+		if (dataSize > 0)
+			PutVertexData(stream);
+
 		if (dataSize > 0) {
-			half_float::half halfData;
-			for (int i = 0; i < numVertices; i++) {
-				if (HasVertices()) {
-					if (IsFullPrecision() || stream.GetVersion().User2() == 100) {
-						// Full precision
-						stream << vertData[i].vert;
-						stream << vertData[i].bitangentX;
-					}
-					else {
-						// Half precision
-						halfData = vertData[i].vert.x;
-						stream.write((char*)&halfData, 2);
-						halfData = vertData[i].vert.y;
-						stream.write((char*)&halfData, 2);
-						halfData = vertData[i].vert.z;
-						stream.write((char*)&halfData, 2);
-
-						halfData = vertData[i].bitangentX;
-						stream.write((char*)&halfData, 2);
-					}
-				}
+			for (int i = 0; i < numTriangles; i++)
+				stream << triangles[i];
+		}
+	}
 
-				if (HasUVs()) {
-					halfData = vertData[i].uv.u;
-					stream.write((char*)&halfData, 2);
+	if (stream.GetVersion().User() == 12 && stream.GetVersion().User2() == 100) {
+		stream << particleDataSize;
 
-					halfData = vertData[i].uv.v;
-					stream.write((char*)&halfData, 2);
-				}
+		if (particleDataSize > 0) {
+			std::vector<ushort> halves(numVertices * 3);
+			HalfFloat::FromFloat((float*)particleVerts.data(), halves.data(), halves.size());
+			stream.write((char*)halves.data(), halves.size() * 2);
+
+			HalfFloat::FromFloat((float*)particleNorms.data(), halves.data(), halves.size());
+			stream.write((char*)halves.data(), halves.size() * 2);
+
+			for (int i = 0; i < numTriangles; i++)
+				stream << particleTris[i];
+		}
+	}
+}
 
-				if (HasNormals()) {
-					for (int j = 0; j < 3; j++)
-						stream << vertData[i].normal[j];
+namespace {
+	// Fields and byte offsets of the packed vertex data of a BSTriShape, see CalcDataSizes
+	struct PackedVertexLayout {
+		bool vertices, uvs, normals, tangents, colors, skinned, eyeData;
+		bool fullPrecision;
 
-					stream << vertData[i].bitangentY;
+		int uvOffset, normalOffset, colorOffset, skinOffset, eyeOffset;
+		int stride;
 
-					if (HasTangents()) {
-						for (int j = 0; j < 3; j++)
-							stream << vertData[i].tangent[j];
+		// Half floats per vertex: position and bitangent X, UV, weights
+		int numHalves;
 
-						stream << vertData[i].bitangentZ;
-					}
+		PackedVertexLayout(BSTriShape& shape, NiVersion& version) {
+			vertices = shape.HasVertices();
+			uvs = shape.HasUVs();
+			normals = shape.HasNormals();
+			tangents = normals && shape.HasTangents();
+			colors = shape.HasVertexColors();
+			skinned = shape.IsSkinned();
+			eyeData = (shape.vertFlags7 & (1 << 4)) != 0;
+			fullPrecision = shape.IsFullPrecision() || version.User2() == 100;
+
+			uvOffset = vertices ? (fullPrecision ? 16 : 8) : 0;
+			normalOffset = uvOffset + (uvs ? 4 : 0);
+			colorOffset = normalOffset + (normals ? 4 : 0) + (tangents ? 4 : 0);
+			skinOffset = colorOffset + (colors ? 4 : 0);
+			eyeOffset = skinOffset + (skinned ? 12 : 0);
+			stride = eyeOffset + (eyeData ? 4 : 0);
+
+			numHalves = (vertices && !fullPrecision ? 4 : 0) + (uvs ? 2 : 0) + (skinned ? 4 : 0);
+		}
+	};
+
+	// Vertices are converted in chunks that stay in the cache between packing and conversion
+	const int vertexChunkSize = 256;
+	const int maxHalvesPerVertex = 10;
+}
+
+void BSTriShape::GetVertexData(NiStream& stream) {
+	PackedVertexLayout layout(*this, stream.GetVersion());
+
+	std::vector<byte> packed(layout.stride * numVertices);
+	stream.readArray(packed.data(), packed.size());
+
+	ushort halves[vertexChunkSize * maxHalvesPerVertex];
+	float floats[vertexChunkSize * maxHalvesPerVertex];
+
+	for (int start = 0; start < numVertices; start += vertexChunkSize) {
+		int end = std::min(start + vertexChunkSize, (int)numVertices);
+
+		ushort* h = halves;
+		for (int i = start; i < end; i++) {
+			const byte* p = &packed[i * layout.stride];
+			if (layout.vertices && !layout.fullPrecision) {
+				memcpy(h, p, 8);
+				h += 4;
+			}
+
+			if (layout.uvs) {
+				memcpy(h, p + layout.uvOffset, 4);
+				h += 2;
+			}
+
+			if (layout.skinned) {
+				memcpy(h, p + layout.skinOffset, 8);
+				h += 4;
+			}
+		}
+
+		HalfFloat::ToFloat(halves, floats, h - halves);
+
+		const float* f = floats;
+		for (int i = start; i < end; i++) {
+			const byte* p = &packed[i * layout.stride];
+			BSVertexData& vd = vertData[i];
+
+			if (layout.vertices) {
+				if (layout.fullPrecision) {
+					memcpy(&vd.vert, p, 12);
+					memcpy(&vd.bitangentX, p + 12, 4);
+				}
+				else {
+					vd.vert = Vector3(f[0], f[1], f[2]);
+					vd.bitangentX = f[3];
+					f += 4;
 				}
+			}
 
-				if (HasVertexColors())
-					for (int j = 0; j < 4; j++)
-						stream << vertData[i].colorData[j];
+			if (layout.uvs) {
+				vd.uv = Vector2(f[0], f[1]);
+				f += 2;
+			}
 
-				if (IsSkinned()) {
-					for (int j = 0; j < 4; j++) {
-						halfData = vertData[i].weights[j];
-						stream.write((char*)&halfData, 2);
-					}
+			if (layout.normals) {
+				memcpy(vd.normal, p + layout.normalOffset, 3);
+				vd.bitangentY = p[layout.normalOffset + 3];
 
-					for (int j = 0; j < 4; j++)
-						stream << vertData[i].weightBones[j];
+				if (layout.tangents) {
+					memcpy(vd.tangent, p + layout.normalOffset + 4, 3);
+					vd.bitangentZ = p[layout.normalOffset + 7];
 				}
+			}
+
+			if (layout.colors)
+				memcpy(vd.colorData, p + layout.colorOffset, 4);
 
-				if ((vertFlags7 & (1 << 4)) != 0)
-					stream << vertData[i].eyeData;
+			if (layout.skinned) {
+				memcpy(vd.weights, f, 16);
+				memcpy(vd.weightBones, p + layout.skinOffset + 8, 4);
+				f += 4;
 			}
-		}
 
-		if (dataSize > 0) {
-			for (int i = 0; i < numTriangles; i++)
-				stream << triangles[i];
+			if (layout.eyeData)
+				memcpy(&vd.eyeData, p + layout.eyeOffset, 4);
 		}
 	}
+}
 
-	if (stream.GetVersion().User() == 12 && stream.GetVersion().User2() == 100) {
-		stream << particleDataSize;
+void BSTriShape::PutVertexData(NiStream& stream) {
+	PackedVertexLayout layout(*this, stream.GetVersion());
 
-		if (particleDataSize > 0) {
-			half_float::half halfData;
-			for (int i = 0; i < numVertices; i++) {
-				halfData = particleVerts[i].x;
-				stream.write((char*)&halfData, 2);
-				halfData = particleVerts[i].y;
-				stream.write((char*)&halfData, 2);
-				halfData = particleVerts[i].z;
-				stream.write((char*)&halfData, 2);
+	std::vector<byte> packed(layout.stride * numVertices);
+
+	float floats[vertexChunkSize * maxHalvesPerVertex];
+	ushort halves[vertexChunkSize * maxHalvesPerVertex];
+
+	for (int start = 0; start < numVertices; start += vertexChunkSize) {
+		int end = std::min(start + vertexChunkSize, (int)numVertices);
+
+		float* f = floats;
+		for (int i = start; i < end; i++) {
+			const BSVertexData& vd = vertData[i];
+			if (layout.vertices && !layout.fullPrecision) {
+				f[0] = vd.vert.x;
+				f[1] = vd.vert.y;
+				f[2] = vd.vert.z;
+				f[3] = vd.bitangentX;
+				f += 4;
 			}
 
-			for (int i = 0; i < numVertices; i++) {
-				halfData = particleNorms[i].x;
-				stream.write((char*)&halfData, 2);
-				halfData = particleNorms[i].y;
-				stream.write((char*)&halfData, 2);
-				halfData = particleNorms[i].z;
-				stream.write((char*)&halfData, 2);
+			if (layout.uvs) {
+				f[0] = vd.uv.u;
+				f[1] = vd.uv.v;
+				f += 2;
 			}
 
-			for (int i = 0; i < numTriangles; i++)
-				stream << particleTris[i];
+			if (layout.skinned) {
+				memcpy(f, vd.weights, 16);
+				f += 4;
+			}
+		}
+
+		HalfFloat::FromFloat(floats, halves, f - floats);
+
+		const ushort* h = halves;
+		for (int i = start; i < end; i++) {
+			byte* p = &packed[i * layout.stride];
+			const BSVertexData& vd = vertData[i];
+
+			if (layout.vertices) {
+				if (layout.fullPrecision) {
+					memcpy(p, &vd.vert, 12);
+					memcpy(p + 12, &vd.bitangentX, 4);
+				}
+				else {
+					memcpy(p, h, 8);
+					h += 4;
+				}
+			}
+
+			if (layout.uvs) {
+				memcpy(p + layout.uvOffset, h, 4);
+				h += 2;
+			}
+
+			if (layout.normals) {
+				memcpy(p + layout.normalOffset, vd.normal, 3);
+				p[layout.normalOffset + 3] = vd.bitangentY;
+
+				if (layout.tangents) {
+					memcpy(p + layout.normalOffset + 4, vd.tangent, 3);
+					p[layout.normalOffset + 7] = vd.bitangentZ;
+				}
+			}
+
+			if (layout.colors)
+				memcpy(p + layout.colorOffset, vd.colorData, 4);
+
+			if (layout.skinned) {
+				memcpy(p + layout.skinOffset, h, 8);
+				memcpy(p + layout.skinOffset + 8, vd.weightBones, 4);
+				h += 4;
+			}
+
+			if (layout.eyeData)
+				memcpy(p + layout.eyeOffset, &vd.eyeData, 4);
 		}
 	}
+
+	stream.write((char*)packed.data(), packed.size());
 }
 
 void BSTriShape::notifyVerticesDelete(const std::vector<ushort>& vertIndices) {
-	std::vector<int> indexCollapse(vertData.size(), 0);
-	std::vector<int> indexCollapseTris(vertData.size(), 0);
+	IndexCollapse indexCollapse(vertIndices);
 
 	deletedTris.clear();
 
-	int remCount = 0;
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < vertIndices.size() && vertIndices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;	// Flag delete
-			indexCollapseTris[i] = -1;	// Flag delete
-			remCount++;
-			j++;
-		}
-		else
-			indexCollapseTris[i] = remCount;
-	}
-
-	for (int i = vertData.size() - 1; i >= 0; i--) {
-		if (indexCollapse[i] == -1) {
-			vertData.erase(vertData.begin() + i);
-			numVertices--;
-		}
-	}
+	indexCollapse.CompactData(vertData);
+	numVertices = vertData.size();
 
-	for (int i = numTriangles - 1; i >= 0; i--) {
-		if (indexCollapseTris[triangles[i].p1] == -1 || indexCollapseTris[triangles[i].p2] == -1 || indexCollapseTris[triangles[i].p3] == -1) {
-			deletedTris.push_back(i);
-			triangles.erase(triangles.begin() + i);
-			numTriangles--;
-		}
-		else {
-			triangles[i].p1 = triangles[i].p1 - indexCollapseTris[triangles[i].p1];
-			triangles[i].p2 = triangles[i].p2 - indexCollapseTris[triangles[i].p2];
-			triangles[i].p3 = triangles[i].p3 - indexCollapseTris[triangles[i].p3];
-		}
-	}
+	indexCollapse.CompactTriangles(triangles, &deletedTris);
+	numTriangles = triangles.size();
 }
 
 void BSTriShape::GetChildRefs(std::set<int*>& refs) {
@@ -956,13 +955,9 @@ void BSTriShape::UpdateBounds() {
 void BSTriShape::SetNormals(const std::vector<Vector3>& inNorms) {
 	SetNormals(true);
 
-	rawNormals.resize(numVertices);
-	for (int i = 0; i < numVertices; i++) {
-		rawNormals[i] = inNorms[i];
-		vertData[i].normal[0] = (unsigned char)round((((inNorms[i].x + 1.0f) / 2.0f) * 255.0f));
-		vertData[i].normal[1] = (unsigned char)round((((inNorms[i].y + 1.0f) / 2.0f) * 255.0f));
-		vertData[i].normal[2] = (unsigned char)round((((inNorms[i].z + 1.0f) / 2.0f) * 255.0f));
-	}
+	rawNormals.assign(inNorms.begin(), inNorms.begin() + numVertices);
+	if (numVertices > 0)
+		GeometryKernels::PackUnitVectors(rawNormals.data(), numVertices, &vertData[0].normal[0], &vertData[0].normal[1], &vertData[0].normal[2], sizeof(BSVertexData));
 }
 
 void BSTriShape::RecalcNormals(const bool smooth, const float smoothThresh) {
@@ -978,16 +973,8 @@ void BSTriShape::RecalcNormals(const bool smooth, const float smoothThresh) {
 	}
 
 	// Face normals
-	Vector3 tn;
-	for (int t = 0; t < numTriangles; t++) {
-		triangles[t].trinormal(verts, &tn);
-		norms[triangles[t].p1] += tn;
-		norms[triangles[t].p2] += tn;
-		norms[triangles[t].p3] += tn;
-	}
-
-	for (auto &n : norms)
-		n.Normalize();
+	GeometryKernels::AccumulateFaceNormals(verts.data(), triangles.data(), numTriangles, norms.data());
+	GeometryKernels::NormalizeVectors(norms.data(), numVertices);
 
 	// Smooth normals
 	if (smooth) {
@@ -1005,8 +992,7 @@ void BSTriShape::RecalcNormals(const bool smooth, const float smoothThresh) {
 			}
 		}
 
-		for (auto &n : norms)
-			n.Normalize();
+		GeometryKernels::NormalizeVectors(norms.data(), numVertices);
 	}
 
 	rawNormals.resize(numVertices);
@@ -1014,10 +1000,10 @@ void BSTriShape::RecalcNormals(const bool smooth, const float smoothThresh) {
 		rawNormals[i].x = -norms[i].x;
 		rawNormals[i].y = norms[i].z;
 		rawNormals[i].z = norms[i].y;
-		vertData[i].normal[0] = (unsigned char)round((((rawNormals[i].x + 1.0f) / 2.0f) * 255.0f));
-		vertData[i].normal[1] = (unsigned char)round((((rawNormals[i].y + 1.0f) / 2.0f) * 255.0f));
-		vertData[i].normal[2] = (unsigned char)round((((rawNormals[i].z + 1.0f) / 2.0f) * 255.0f));
 	}
+
+	if (numVertices > 0)
+		GeometryKernels::PackUnitVectors(rawNormals.data(), numVertices, &vertData[0].normal[0], &vertData[0].normal[1], &vertData[0].normal[2], sizeof(BSVertexData));
 }
 
 void BSTriShape::CalcTangentSpace() {
@@ -1025,90 +1011,23 @@ void BSTriShape::CalcTangentSpace() {
 		return;
 
 	GetNormalData(false);
+	GetRawVerts();
+	GetUVData();
 	SetTangents(true);
 
-	std::vector<Vector3> tan1;
-	std::vector<Vector3> tan2;
-	tan1.resize(numVertices);
-	tan2.resize(numVertices);
-
-	for (int i = 0; i < triangles.size(); i++) {
-		int i1 = triangles[i].p1;
-		int i2 = triangles[i].p2;
-		int i3 = triangles[i].p3;
-
-		Vector3 v1 = vertData[i1].vert;
-		Vector3 v2 = vertData[i2].vert;
-		Vector3 v3 = vertData[i3].vert;
-
-		Vector2 w1 = vertData[i1].uv;
-		Vector2 w2 = vertData[i2].uv;
-		Vector2 w3 = vertData[i3].uv;
-
-		float x1 = v2.x - v1.x;
-		float x2 = v3.x - v1.x;
-		float y1 = v2.y - v1.y;
-		float y2 = v3.y - v1.y;
-		float z1 = v2.z - v1.z;
-		float z2 = v3.z - v1.z;
-
-		float s1 = w2.u - w1.u;
-		float s2 = w3.u - w1.u;
-		float t1 = w2.v - w1.v;
-		float t2 = w3.v - w1.v;
-
-		float r = (s1 * t2 - s2 * t1);
-		r = (r >= 0.0f ? +1.0f : -1.0f);
-
-		Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		sdir.Normalize();
-		tdir.Normalize();
+	rawTangents.assign(numVertices, Vector3());
+	rawBitangents.assign(numVertices, Vector3());
 
-		tan1[i1] += tdir;
-		tan1[i2] += tdir;
-		tan1[i3] += tdir;
+	GeometryKernels::AccumulateTriangleTangents(rawVertices.data(), rawUvs.data(), triangles.data(), triangles.size(), rawTangents.data(), rawBitangents.data());
+	GeometryKernels::OrthogonalizeTangents(rawNormals.data(), rawTangents.data(), rawBitangents.data(), numVertices);
 
-		tan2[i1] += sdir;
-		tan2[i2] += sdir;
-		tan2[i3] += sdir;
+	if (numVertices > 0) {
+		GeometryKernels::PackUnitVectors(rawTangents.data(), numVertices, &vertData[0].tangent[0], &vertData[0].tangent[1], &vertData[0].tangent[2], sizeof(BSVertexData));
+		GeometryKernels::PackUnitVectors(rawBitangents.data(), numVertices, nullptr, &vertData[0].bitangentY, &vertData[0].bitangentZ, sizeof(BSVertexData));
 	}
 
-	rawBitangents.resize(numVertices);
-	rawTangents.resize(numVertices);
-
-	for (int i = 0; i < numVertices; i++) {
-		rawTangents[i] = tan1[i];
-		rawBitangents[i] = tan2[i];
-
-		if (rawTangents[i].IsZero() || rawBitangents[i].IsZero()) {
-			rawTangents[i].x = rawNormals[i].y;
-			rawTangents[i].y = rawNormals[i].z;
-			rawTangents[i].z = rawNormals[i].x;
-			rawBitangents[i] = rawNormals[i].cross(rawTangents[i]);
-		}
-		else {
-			rawTangents[i].Normalize();
-			rawTangents[i] = (rawTangents[i] - rawNormals[i] * rawNormals[i].dot(rawTangents[i]));
-			rawTangents[i].Normalize();
-
-			rawBitangents[i].Normalize();
-
-			rawBitangents[i] = (rawBitangents[i] - rawNormals[i] * rawNormals[i].dot(rawBitangents[i]));
-			rawBitangents[i] = (rawBitangents[i] - rawTangents[i] * rawTangents[i].dot(rawBitangents[i]));
-
-			rawBitangents[i].Normalize();
-		}
-
-		vertData[i].tangent[0] = (unsigned char)round((((rawTangents[i].x + 1.0f) / 2.0f) * 255.0f));
-		vertData[i].tangent[1] = (unsigned char)round((((rawTangents[i].y + 1.0f) / 2.0f) * 255.0f));
-		vertData[i].tangent[2] = (unsigned char)round((((rawTangents[i].z + 1.0f) / 2.0f) * 255.0f));
-
+	for (int i = 0; i < numVertices; i++)
 		vertData[i].bitangentX = rawBitangents[i].x;
-		vertData[i].bitangentY = (unsigned char)round((((rawBitangents[i].y + 1.0f) / 2.0f) * 255.0f));
-		vertData[i].bitangentZ = (unsigned char)round((((rawBitangents[i].z + 1.0f) / 2.0f) * 255.0f));
-	}
 }
 
 void BSTriShape::UpdateFlags(NiVersion& version) {
@@ -1558,8 +1477,7 @@ void BSDynamicTriShape::Get(NiStream& stream) {
 	stream >> dynamicDataSize;
 
 	dynamicData.resize(numVertices);
-	for (int i = 0; i < numVertices; i++)
-		stream >> dynamicData[i];
+	stream.readArray(dynamicData.data(), numVertices);
 }
 
 void BSDynamicTriShape::Put(NiStream& stream) {
@@ -1574,20 +1492,9 @@ void BSDynamicTriShape::Put(NiStream& stream) {
 void BSDynamicTriShape::notifyVerticesDelete(const std::vector<ushort>& vertIndices) {
 	BSTriShape::notifyVerticesDelete(vertIndices);
 
-	std::vector<int> indexCollapse(dynamicData.size(), 0);
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < vertIndices.size() && vertIndices[j] == i) {
-			indexCollapse[i] = -1;
-			j++;
-		}
-	}
-
-	for (int i = dynamicData.size() - 1; i >= 0; i--) {
-		if (indexCollapse[i] == -1) {
-			dynamicData.erase(dynamicData.begin() + i);
-			dynamicDataSize--;
-		}
-	}
+	int oldSize = dynamicData.size();
+	IndexCollapse(vertIndices).CompactData(dynamicData);
+	dynamicDataSize -= oldSize - dynamicData.size();
 }
 
 int BSDynamicTriShape::CalcBlockSize(NiVersion& version) {
@@ -1645,8 +1552,7 @@ void NiGeometry::Get(NiStream& stream) {
 		materialNameRefs[i].Get(stream);
 
 	materials.resize(numMaterials);
-	for (int i = 0; i < numMaterials; i++)
-		stream >> materials[i];
+	stream.readArray(materials.data(), numMaterials);
 
 	stream >> activeMaterial;
 	stream >> dirty;
@@ -1762,8 +1668,7 @@ void NiTriShapeData::Get(NiStream& stream) {
 
 	if (hasTriangles) {
 		triangles.resize(numTriangles);
-		for (int i = 0; i < numTriangles; i++) 
-			stream >> triangles[i];
+		stream.readArray(triangles.data(), numTriangles);
 	}
 
 	MatchGroup mg;
@@ -1772,8 +1677,7 @@ void NiTriShapeData::Get(NiStream& stream) {
 	for (int i = 0; i < numMatchGroups; i++) {
 		stream >> mg.count;
 		mg.matches.resize(mg.count);
-		for (int j = 0; j < mg.count; j++)
-			stream >> mg.matches[j];
+		stream.readArray(mg.matches.data(), mg.count);
 
 		matchGroups[i] = mg;
 	}
@@ -1814,32 +1718,12 @@ void NiTriShapeData::Create(std::vector<Vector3>* verts, std::vector<Triangle>*
 }
 
 void NiTriShapeData::notifyVerticesDelete(const std::vector<ushort>& vertIndices) {
-	std::vector<int> indexCollapse(vertices.size(), 0);
-	int remCount = 0;
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < vertIndices.size() && vertIndices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;	// Flag delete
-			remCount++;
-			j++;
-		}
-		else
-			indexCollapse[i] = remCount;
-	}
-
 	NiTriBasedGeomData::notifyVerticesDelete(vertIndices);
 
-	for (int i = numTriangles - 1; i >= 0; i--) {
-		if (indexCollapse[triangles[i].p1] == -1 || indexCollapse[triangles[i].p2] == -1 || indexCollapse[triangles[i].p3] == -1) {
-			triangles.erase(triangles.begin() + i);
-			numTriangles--;
-			numTrianglePoints -= 3;
-		}
-		else {
-			triangles[i].p1 = triangles[i].p1 - indexCollapse[triangles[i].p1];
-			triangles[i].p2 = triangles[i].p2 - indexCollapse[triangles[i].p2];
-			triangles[i].p3 = triangles[i].p3 - indexCollapse[triangles[i].p3];
-		}
-	}
+	int oldCount = triangles.size();
+	IndexCollapse(vertIndices).CompactTriangles(triangles);
+	numTriangles = triangles.size();
+	numTrianglePoints -= (oldCount - numTriangles) * 3;
 }
 
 void NiTriShapeData::RecalcNormals(const bool smooth, const float smoothThresh) {
@@ -1853,16 +1737,8 @@ void NiTriShapeData::RecalcNormals(const bool smooth, const float smoothThresh)
 		n.Zero();
 
 	// Face normals
-	Vector3 tn;
-	for (int t = 0; t < numTriangles; t++) {
-		triangles[t].trinormal(vertices, &tn);
-		normals[triangles[t].p1] += tn;
-		normals[triangles[t].p2] += tn;
-		normals[triangles[t].p3] += tn;
-	}
-
-	for (auto &n : normals)
-		n.Normalize();
+	GeometryKernels::AccumulateFaceNormals(vertices.data(), triangles.data(), numTriangles, normals.data());
+	GeometryKernels::NormalizeVectors(normals.data(), normals.size());
 
 	// Smooth normals
 	if (smooth) {
@@ -1880,8 +1756,7 @@ void NiTriShapeData::RecalcNormals(const bool smooth, const float smoothThresh)
 			}
 		}
 
-		for (auto &n : normals)
-			n.Normalize();
+		GeometryKernels::NormalizeVectors(normals.data(), normals.size());
 	}
 }
 
@@ -1891,77 +1766,11 @@ void NiTriShapeData::CalcTangentSpace() {
 
 	NiTriBasedGeomData::CalcTangentSpace();
 
-	std::vector<Vector3> tan1;
-	std::vector<Vector3> tan2;
-	tan1.resize(numVertices);
-	tan2.resize(numVertices);
-
-	for (int i = 0; i < numTriangles; i++) {
-		int i1 = triangles[i].p1;
-		int i2 = triangles[i].p2;
-		int i3 = triangles[i].p3;
-
-		Vector3 v1 = vertices[i1];
-		Vector3 v2 = vertices[i2];
-		Vector3 v3 = vertices[i3];
-
-		Vector2 w1 = uvSets[i1];
-		Vector2 w2 = uvSets[i2];
-		Vector2 w3 = uvSets[i3];
-
-		float x1 = v2.x - v1.x;
-		float x2 = v3.x - v1.x;
-		float y1 = v2.y - v1.y;
-		float y2 = v3.y - v1.y;
-		float z1 = v2.z - v1.z;
-		float z2 = v3.z - v1.z;
-
-		float s1 = w2.u - w1.u;
-		float s2 = w3.u - w1.u;
-		float t1 = w2.v - w1.v;
-		float t2 = w3.v - w1.v;
-
-		float r = (s1 * t2 - s2 * t1);
-		r = (r >= 0.0f ? +1.0f : -1.0f);
-
-		Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		sdir.Normalize();
-		tdir.Normalize();
+	tangents.assign(numVertices, Vector3());
+	bitangents.assign(numVertices, Vector3());
 
-		tan1[i1] += sdir;
-		tan1[i2] += sdir;
-		tan1[i3] += sdir;
-
-		tan2[i1] += tdir;
-		tan2[i2] += tdir;
-		tan2[i3] += tdir;
-	}
-
-	for (int i = 0; i < numVertices; i++) {
-		bitangents[i] = tan1[i];
-		tangents[i] = tan2[i];
-
-		if (tangents[i].IsZero() || bitangents[i].IsZero()) {
-			tangents[i].x = normals[i].y;
-			tangents[i].y = normals[i].z;
-			tangents[i].z = normals[i].x;
-			bitangents[i] = normals[i].cross(tangents[i]);
-		}
-		else {
-			tangents[i].Normalize();
-			tangents[i] = (tangents[i] - normals[i] * normals[i].dot(tangents[i]));
-			tangents[i].Normalize();
-
-			bitangents[i].Normalize();
-
-			bitangents[i] = (bitangents[i] - normals[i] * normals[i].dot(bitangents[i]));
-			bitangents[i] = (bitangents[i] - tangents[i] * tangents[i].dot(bitangents[i]));
-
-			bitangents[i].Normalize();
-		}
-	}
+	GeometryKernels::AccumulateTriangleTangents(vertices.data(), uvSets.data(), triangles.data(), numTriangles, tangents.data(), bitangents.data());
+	GeometryKernels::OrthogonalizeTangents(normals.data(), tangents.data(), bitangents.data(), numVertices);
 }
 
 int NiTriShapeData::CalcBlockSize(NiVersion& version) {
@@ -2000,16 +1809,14 @@ void NiTriStripsData::Get(NiStream& stream) {
 
 	stream >> numStrips;
 	stripLengths.resize(numStrips);
-	for (int i = 0; i < numStrips; i++)
-		stream >> stripLengths[i];
+	stream.readArray(stripLengths.data(), numStrips);
 
 	stream >> hasPoints;
 	if (hasPoints) {
 		points.resize(numStrips);
 		for (int i = 0; i < numStrips; i++) {
 			points[i].resize(stripLengths[i]);
-			for (int j = 0; j < stripLengths[i]; j++)
-				stream >> points[i][j];
+			stream.readArray(points[i].data(), stripLengths[i]);
 		}
 	}
 }
@@ -2030,28 +1837,21 @@ void NiTriStripsData::Put(NiStream& stream) {
 }
 
 void NiTriStripsData::notifyVerticesDelete(const std::vector<ushort>& vertIndices) {
-	std::vector<int> indexCollapse(vertices.size(), 0);
-	int remCount = 0;
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < vertIndices.size() && vertIndices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;	// Flag delete
-			remCount++;
-			j++;
-		}
-		else
-			indexCollapse[i] = remCount;
-	}
+	IndexCollapse indexCollapse(vertIndices);
 
 	NiTriBasedGeomData::notifyVerticesDelete(vertIndices);
 
 	// This is not a healthy way to delete strip data. Probably need to restrip the shape.
 	for (int i = 0; i < numStrips; i++) {
+		int n = 0;
 		for (int j = 0; j < stripLengths[i]; j++) {
-			if (indexCollapse[points[i][j]] == -1) {
-				points[i].erase(points[i].begin() + j);
-				stripLengths[i]--;
-			}
+			int index = indexCollapse[points[i][j]];
+			if (index != -1)
+				points[i][n++] = index;
 		}
+
+		points[i].resize(n);
+		stripLengths[i] = n;
 	}
 }
 
@@ -2092,16 +1892,8 @@ void NiTriStripsData::RecalcNormals(const bool smooth, const float smoothThresh)
 		n.Zero();
 
 	// Face normals
-	Vector3 tn;
-	for (int t = 0; t < tris.size(); t++) {
-		tris[t].trinormal(vertices, &tn);
-		normals[tris[t].p1] += tn;
-		normals[tris[t].p2] += tn;
-		normals[tris[t].p3] += tn;
-	}
-
-	for (auto &n : normals)
-		n.Normalize();
+	GeometryKernels::AccumulateFaceNormals(vertices.data(), tris.data(), tris.size(), normals.data());
+	GeometryKernels::NormalizeVectors(normals.data(), normals.size());
 
 	// Smooth normals
 	if (smooth) {
@@ -2119,8 +1911,7 @@ void NiTriStripsData::RecalcNormals(const bool smooth, const float smoothThresh)
 			}
 		}
 
-		for (auto &n : normals)
-			n.Normalize();
+		GeometryKernels::NormalizeVectors(normals.data(), normals.size());
 	}
 }
 
@@ -2130,80 +1921,14 @@ void NiTriStripsData::CalcTangentSpace() {
 
 	NiTriBasedGeomData::CalcTangentSpace();
 
-	std::vector<Vector3> tan1;
-	std::vector<Vector3> tan2;
-	tan1.resize(numVertices);
-	tan2.resize(numVertices);
-
 	std::vector<Triangle> tris;
 	StripsToTris(&tris);
 
-	for (int i = 0; i < tris.size(); i++) {
-		int i1 = tris[i].p1;
-		int i2 = tris[i].p2;
-		int i3 = tris[i].p3;
-
-		Vector3 v1 = vertices[i1];
-		Vector3 v2 = vertices[i2];
-		Vector3 v3 = vertices[i3];
-
-		Vector2 w1 = uvSets[i1];
-		Vector2 w2 = uvSets[i2];
-		Vector2 w3 = uvSets[i3];
-
-		float x1 = v2.x - v1.x;
-		float x2 = v3.x - v1.x;
-		float y1 = v2.y - v1.y;
-		float y2 = v3.y - v1.y;
-		float z1 = v2.z - v1.z;
-		float z2 = v3.z - v1.z;
-
-		float s1 = w2.u - w1.u;
-		float s2 = w3.u - w1.u;
-		float t1 = w2.v - w1.v;
-		float t2 = w3.v - w1.v;
-
-		float r = (s1 * t2 - s2 * t1);
-		r = (r >= 0.0f ? +1.0f : -1.0f);
+	tangents.assign(numVertices, Vector3());
+	bitangents.assign(numVertices, Vector3());
 
-		Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		sdir.Normalize();
-		tdir.Normalize();
-
-		tan1[i1] += sdir;
-		tan1[i2] += sdir;
-		tan1[i3] += sdir;
-
-		tan2[i1] += tdir;
-		tan2[i2] += tdir;
-		tan2[i3] += tdir;
-	}
-
-	for (int i = 0; i < numVertices; i++) {
-		bitangents[i] = tan1[i];
-		tangents[i] = tan2[i];
-
-		if (tangents[i].IsZero() || bitangents[i].IsZero()) {
-			tangents[i].x = normals[i].y;
-			tangents[i].y = normals[i].z;
-			tangents[i].z = normals[i].x;
-			bitangents[i] = normals[i].cross(tangents[i]);
-		}
-		else {
-			tangents[i].Normalize();
-			tangents[i] = (tangents[i] - normals[i] * normals[i].dot(tangents[i]));
-			tangents[i].Normalize();
-
-			bitangents[i].Normalize();
-
-			bitangents[i] = (bitangents[i] - normals[i] * normals[i].dot(bitangents[i]));
-			bitangents[i] = (bitangents[i] - tangents[i] * tangents[i].dot(bitangents[i]));
-
-			bitangents[i].Normalize();
-		}
-	}
+	GeometryKernels::AccumulateTriangleTangents(vertices.data(), uvSets.data(), tris.data(), tris.size(), tangents.data(), bitangents.data());
+	GeometryKernels::OrthogonalizeTangents(normals.data(), tangents.data(), bitangents.data(), numVertices);
 }
 
 int NiTriStripsData::CalcBlockSize(NiVersion& version) {
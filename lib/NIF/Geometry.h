@@ -120,6 +120,10 @@ private:
 
 	BoundingSphere bounds;
 
+	// Vertex data is read and written as one packed buffer, with its half floats converted in bulk
+	void GetVertexData(NiStream& stream);
+	void PutVertexData(NiStream& stream);
+
 public:
 	// Set in CalcBlockSize(NiVersion& version)
 	byte vertFlags1;			// Number of uint elements in vertex data
@@ -10,6 +10,7 @@ See the included LICENSE file
 #include <queue>
 #include <regex>
 #include <fstream>
+#include <cstdio>
 
 
 NiFactoryRegister& NiFactoryRegister::GetNiFactoryRegister() {
@@ -186,11 +187,44 @@ NiFactoryRegister::NiFactoryRegister() {
 }
 
 
+void NifFile::UpdateBlockIndex() {
+	uint blockRevision = hdr.GetBlockRevision();
+	uint nameRevision = *blockIndex.currentNameRevision;
+	if (blockIndex.valid && blockIndex.blockRevision == blockRevision && blockIndex.nameRevision == nameRevision)
+		return;
+
+	blockIndex.names.clear();
+	blockIndex.ids.clear();
+	blockIndex.ids.reserve(blocks.size());
+
+	for (int i = 0; i < blocks.size(); i++) {
+		NiObject* block = blocks[i].get();
+		blockIndex.ids.emplace(block, i);
+
+		auto net = dynamic_cast<NiObjectNET*>(block);
+		if (net) {
+			net->SetNameRevision(blockIndex.currentNameRevision);
+			blockIndex.names[net->GetName()].push_back(i);
+		}
+	}
+
+	blockIndex.valid = true;
+	blockIndex.blockRevision = blockRevision;
+	blockIndex.nameRevision = nameRevision;
+}
+
 NiShape* NifFile::FindShapeByName(const std::string& name, int dupIndex) {
+	std::lock_guard<std::mutex> lock(blockIndex.lock);
+	UpdateBlockIndex();
+
+	auto it = blockIndex.names.find(name);
+	if (it == blockIndex.names.end())
+		return nullptr;
+
 	int numFound = 0;
-	for (auto& block : blocks) {
-		auto geom = dynamic_cast<NiShape*>(block.get());
-		if (geom && !name.compare(geom->GetName())) {
+	for (auto &id : it->second) {
+		auto geom = dynamic_cast<NiShape*>(blocks[id].get());
+		if (geom) {
 			if (numFound >= dupIndex)
 				return geom;
 
@@ -201,10 +235,17 @@ NiShape* NifFile::FindShapeByName(const std::string& name, int dupIndex) {
 }
 
 NiAVObject* NifFile::FindAVObjectByName(const std::string& name, int dupIndex) {
+	std::lock_guard<std::mutex> lock(blockIndex.lock);
+	UpdateBlockIndex();
+
+	auto it = blockIndex.names.find(name);
+	if (it == blockIndex.names.end())
+		return nullptr;
+
 	int numFound = 0;
-	for (auto& block : blocks) {
-		auto avo = dynamic_cast<NiAVObject*>(block.get());
-		if (avo && !name.compare(avo->GetName())) {
+	for (auto &id : it->second) {
+		auto avo = dynamic_cast<NiAVObject*>(blocks[id].get());
+		if (avo) {
 			if (numFound >= dupIndex)
 				return avo;
 
@@ -215,9 +256,16 @@ NiAVObject* NifFile::FindAVObjectByName(const std::string& name, int dupIndex) {
 }
 
 NiNode* NifFile::FindNodeByName(const std::string& name) {
-	for (auto& block : blocks) {
-		auto node = dynamic_cast<NiNode*>(block.get());
-		if (node && !name.compare(node->GetName()))
+	std::lock_guard<std::mutex> lock(blockIndex.lock);
+	UpdateBlockIndex();
+
+	auto it = blockIndex.names.find(name);
+	if (it == blockIndex.names.end())
+		return nullptr;
+
+	for (auto &id : it->second) {
+		auto node = dynamic_cast<NiNode*>(blocks[id].get());
+		if (node)
 			return node;
 	}
 	return nullptr;
@@ -225,15 +273,12 @@ NiNode* NifFile::FindNodeByName(const std::string& name) {
 
 int NifFile::GetBlockID(NiObject* block) {
 	if (block != nullptr) {
-		auto it = std::find_if(blocks.begin(), blocks.end(), [&block] (const auto& ptr) {
-			if (ptr.get() == block)
-				return true;
-			else
-				return false;
-		});
+		std::lock_guard<std::mutex> lock(blockIndex.lock);
+		UpdateBlockIndex();
 
-		if (it != blocks.end())
-			return std::distance(blocks.begin(), it);
+		auto it = blockIndex.ids.find(block);
+		if (it != blockIndex.ids.end())
+			return it->second;
 	}
 
 	return 0xFFFFFFFF;
@@ -271,10 +316,12 @@ void NifFile::CopyFrom(const NifFile& other) {
 	blocks.resize(nBlocks);
 
 	for (int i = 0; i < nBlocks; i++)
-		blocks[i] = std::move(std::unique_ptr<NiObject>(other.blocks[i]->Clone()));
+		if (other.blocks[i])
+			blocks[i] = std::move(std::unique_ptr<NiObject>(other.blocks[i]->Clone()));
 
 	LinkGeomData();
 	hdr.SetBlockReference(&blocks);
+	blockIndex.valid = false;
 }
 
 void NifFile::LinkGeomData() {
@@ -294,14 +341,29 @@ void NifFile::Clear() {
 
 	blocks.clear();
 	hdr.Clear();
+
+	blockIndex.valid = false;
+	blockIndex.names.clear();
+	blockIndex.ids.clear();
 }
 
 int NifFile::Load(const std::string& filename) {
 	Clear();
 
-	std::fstream file(filename.c_str(), std::ios::in | std::ios::binary);
+	std::fstream file(filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
 	if (file.is_open()) {
-		NiStream stream(&file, &hdr.GetVersion());
+		// Read the whole file at once, the blocks are parsed from memory
+		std::vector<char> data;
+		std::streamoff fileSize = file.tellg();
+		if (fileSize > 0) {
+			data.resize((size_t)fileSize);
+			file.seekg(0, std::ios::beg);
+			file.read(data.data(), data.size());
+			data.resize((size_t)file.gcount());
+		}
+		file.close();
+
+		NiStream stream(data.data(), data.size(), &hdr.GetVersion());
 		if (filename.rfind("\\") != std::string::npos)
 			fileName = filename.substr(filename.rfind("\\"));
 		else
@@ -341,7 +403,6 @@ int NifFile::Load(const std::string& filename) {
 		}
 
 		hdr.SetBlockReference(&blocks);
-		file.close();
 	}
 	else {
 		Clear();
@@ -1490,10 +1551,10 @@ bool NifFile::RenameDuplicateShape(const std::string& dupedShape) {
 	NiAVObject* geom = FindAVObjectByName(dupedShape);
 	if (geom) {
 		while ((geom = FindAVObjectByName(dupedShape, 1)) != nullptr) {
-			_snprintf(buf, 10, "_%d", dupCount);
+			snprintf(buf, 10, "_%d", dupCount);
 			while (hdr.FindStringId(geom->GetName() + buf) != 0xFFFFFFFF) {
 				dupCount++;
-				_snprintf(buf, 10, "_%d", dupCount);
+				snprintf(buf, 10, "_%d", dupCount);
 			}
 
 			geom->SetName(geom->GetName() + buf);
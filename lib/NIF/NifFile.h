@@ -17,6 +17,7 @@ See the included LICENSE file
 #include "Shaders.h"
 #include "Skin.h"
 
+#include <mutex>
 #include <unordered_map>
 
 struct OptOptionsSSE {
@@ -60,8 +61,9 @@ public:
 
 	template<typename T>
 	void RegisterFactory() {
-		// Any NiObject can be registered together with its block name
-		m_registrations.emplace(T::BlockName, std::make_shared<NiFactory<T>>());
+		// Any NiObject can be registered together with its block name.
+		// The name is copied first, binding the static member to a reference would need a definition of it outside the class.
+		m_registrations.emplace(std::string(T::BlockName), std::make_shared<NiFactory<T>>());
 	}
 
 	// Get block factory via header std::string
@@ -100,6 +102,21 @@ private:
 
 	NiHeader hdr;
 
+	// Block IDs by name and by block, rebuilt after blocks were changed or an object of this file was renamed.
+	// Lookups lock the index, so they can be used from several threads as long as none of them changes blocks or names.
+	// Blocks added since the last rebuild change the block revision, so they don't need to count renames yet.
+	struct BlockIndex {
+		std::mutex lock;
+		bool valid = false;
+		uint blockRevision = 0;
+		uint nameRevision = 0;
+		std::shared_ptr<std::atomic<uint>> currentNameRevision = std::make_shared<std::atomic<uint>>(0);
+		std::unordered_map<std::string, std::vector<int>> names;
+		std::unordered_map<NiObject*, int> ids;
+	} blockIndex;
+
+	void UpdateBlockIndex();
+
 public:
 	NifFile() {}
 
@@ -248,6 +265,8 @@ public:
 	void DeleteShader(const std::string& shapeName);
 	void DeleteAlpha(const std::string& shapeName);
 	void DeleteSkinning(const std::string& shapeName);
+	// Indices have to be sorted without duplicates, every block of the shape is compacted in a single pass.
+	// Returns true if the whole shape was deleted.
 	bool DeleteVertsForShape(const std::string& shapeName, const std::vector<ushort>& indices);
 
 	int CalcShapeDiff(const std::string& shapeName, const std::vector<Vector3>* targetData, std::unordered_map<ushort, Vector3>& outDiffData, float scale = 1.0f);
@@ -49,10 +49,14 @@ std::string NiObjectNET::GetName() {
 
 void NiObjectNET::SetName(const std::string& str) {
 	name.SetString(str);
+	if (nameRevision)
+		(*nameRevision)++;
 }
 
 void NiObjectNET::ClearName() {
 	name.Clear();
+	if (nameRevision)
+		(*nameRevision)++;
 }
 
 int NiObjectNET::GetControllerRef() {
@@ -120,8 +124,7 @@ void NiAVObject::Get(NiStream& stream) {
 
 	stream >> translation;
 
-	for (int i = 0; i < 3; i++)
-		stream >> rotation[i];
+	stream.readArray(rotation, 3);
 
 	stream >> scale;
 
@@ -10,12 +10,18 @@ See the included LICENSE file
 #include "Animation.h"
 #include "ExtraData.h"
 
+#include <atomic>
+#include <memory>
+
 class NiObjectNET : public NiObject {
 private:
 	StringRef name;
 	BlockRef<NiTimeController> controllerRef;
 	BlockRefArray<NiExtraData> extraDataRefs;
 
+	// Name revision of the file the object is part of, counted up on every rename
+	std::shared_ptr<std::atomic<uint>> nameRevision;
+
 public:
 	uint skyrimShaderType;					// BSLightingShaderProperty && User Version >= 12
 	bool bBSLightingShaderProperty;
@@ -29,6 +35,9 @@ public:
 	void SetName(const std::string& str);
 	void ClearName();
 
+	// Attached by the file that indexes the object by name, so renames only invalidate the index of that file
+	void SetNameRevision(const std::shared_ptr<std::atomic<uint>>& revision) { nameRevision = revision; }
+
 	int GetControllerRef();
 	void SetControllerRef(int ctlrRef);
 
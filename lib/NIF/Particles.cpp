@@ -36,8 +36,7 @@ void NiParticlesData::Get(NiStream& stream) {
 	}
 
 	subtexOffsets.resize(numSubtexOffsets);
-	for (int i = 0; i < numSubtexOffsets; i++)
-		stream >> subtexOffsets[i];
+	stream.readArray(subtexOffsets.data(), numSubtexOffsets);
 
 	if (stream.GetVersion().User() >= 12) {
 		stream >> aspectRatio;
@@ -146,8 +145,7 @@ void NiMeshPSysData::Get(NiStream& stream) {
 
 	stream >> numGenerations;
 	generationPoolSize.resize(numGenerations);
-	for (int i = 0; i < numGenerations; i++)
-		stream >> generationPoolSize[i];
+	stream.readArray(generationPoolSize.data(), numGenerations);
 
 	nodeRef.Get(stream);
 }
@@ -503,8 +501,7 @@ void BSPSysScaleModifier::Get(NiStream& stream) {
 
 	stream >> numFloats;
 	floats.resize(numFloats);
-	for (int i = 0; i < numFloats; i++)
-		stream >> floats[i];
+	stream.readArray(floats.data(), numFloats);
 }
 
 void BSPSysScaleModifier::Put(NiStream& stream) {
@@ -962,8 +959,7 @@ void NiParticleSystem::Get(NiStream& stream) {
 			materialNameRefs[i].Get(stream);
 
 		materials.resize(numMaterials);
-		for (int i = 0; i < numMaterials; i++)
-			stream >> materials[i];
+		stream.readArray(materials.data(), numMaterials);
 
 		stream >> activeMaterial;
 		stream >> defaultMatNeedsUpdate;
@@ -9,6 +9,8 @@ See the included LICENSE file
 #include "BasicTypes.h"
 #include "Objects.h"
 
+#include <limits>
+
 enum BSShaderType : uint {
 	SHADER_TALL_GRASS,
 	SHADER_DEFAULT,
@@ -69,36 +69,23 @@ void NiSkinData::Put(NiStream& stream) {
 }
 
 void NiSkinData::notifyVerticesDelete(const std::vector<ushort>& vertIndices) {
-	ushort highestRemoved = vertIndices.back();
-	std::vector<int> indexCollapse(highestRemoved + 1, 0);
-
 	NiObject::notifyVerticesDelete(vertIndices);
 
-	int remCount = 0;
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < vertIndices.size() && vertIndices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;	// Flag delete
-			remCount++;
-			j++;
-		}
-		else
-			indexCollapse[i] = remCount;
-	}
-
-	ushort ival;
+	IndexCollapse indexCollapse(vertIndices);
 	for (auto &b : bones) {
-		for (int i = b.numVertices - 1; i >= 0; i--) {
-			ival = b.vertexWeights[i].index;
-			if (b.vertexWeights[i].index > highestRemoved) {
-				b.vertexWeights[i].index -= remCount;
-			}
-			else if (indexCollapse[ival] == -1) {
-				b.vertexWeights.erase(b.vertexWeights.begin() + i);
-				b.numVertices--;
-			}
-			else
-				b.vertexWeights[i].index -= indexCollapse[ival];
+		int n = 0;
+		for (int i = 0; i < b.numVertices; i++) {
+			int index = indexCollapse[b.vertexWeights[i].index];
+			if (index == -1)
+				continue;
+
+			b.vertexWeights[n] = b.vertexWeights[i];
+			b.vertexWeights[n].index = index;
+			n++;
 		}
+
+		b.vertexWeights.resize(n);
+		b.numVertices = n;
 	}
 }
 
@@ -178,22 +165,19 @@ void NiSkinPartition::Get(NiStream& stream) {
 				}
 
 				if (HasNormals()) {
-					for (int j = 0; j < 3; j++)
-						stream >> vertData[i].normal[j];
+					stream.readArray(vertData[i].normal, 3);
 
 					stream >> vertData[i].bitangentY;
 
 					if (HasTangents()) {
-						for (int j = 0; j < 3; j++)
-							stream >> vertData[i].tangent[j];
+						stream.readArray(vertData[i].tangent, 3);
 
 						stream >> vertData[i].bitangentZ;
 					}
 				}
 
 				if (HasVertexColors())
-					for (int j = 0; j < 4; j++)
-						stream >> vertData[i].colorData[j];
+					stream.readArray(vertData[i].colorData, 4);
 
 				if (IsSkinned()) {
 					for (int j = 0; j < 4; j++) {
@@ -201,8 +185,7 @@ void NiSkinPartition::Get(NiStream& stream) {
 						vertData[i].weights[j] = halfData;
 					}
 
-					for (int j = 0; j < 4; j++)
-						stream >> vertData[i].weightBones[j];
+					stream.readArray(vertData[i].weightBones, 4);
 				}
 
 				if ((vertFlags7 & (1 << 4)) != 0)
@@ -220,48 +203,41 @@ void NiSkinPartition::Get(NiStream& stream) {
 		stream >> partition.numWeightsPerVertex;
 
 		partition.bones.resize(partition.numBones);
-		for (int i = 0; i < partition.numBones; i++)
-			stream >> partition.bones[i];
+		stream.readArray(partition.bones.data(), partition.numBones);
 
 		stream >> partition.hasVertexMap;
 		if (partition.hasVertexMap) {
 			partition.vertexMap.resize(partition.numVertices);
-			for (int i = 0; i < partition.numVertices; i++)
-				stream >> partition.vertexMap[i];
+			stream.readArray(partition.vertexMap.data(), partition.numVertices);
 		}
 
 		stream >> partition.hasVertexWeights;
 		if (partition.hasVertexWeights) {
 			partition.vertexWeights.resize(partition.numVertices);
-			for (int i = 0; i < partition.numVertices; i++)
-				stream >> partition.vertexWeights[i];
+			stream.readArray(partition.vertexWeights.data(), partition.numVertices);
 		}
 
 		partition.stripLengths.resize(partition.numStrips);
-		for (int i = 0; i < partition.numStrips; i++)
-			stream >> partition.stripLengths[i];
+		stream.readArray(partition.stripLengths.data(), partition.numStrips);
 
 		stream >> partition.hasFaces;
 		if (partition.hasFaces) {
 			partition.strips.resize(partition.numStrips);
 			for (int i = 0; i < partition.numStrips; i++) {
 				partition.strips[i].resize(partition.stripLengths[i]);
-				for (int j = 0; j < partition.stripLengths[i]; j++)
-					stream >> partition.strips[i][j];
+				stream.readArray(partition.strips[i].data(), partition.stripLengths[i]);
 			}
 		}
 
 		if (partition.numStrips == 0 && partition.hasFaces) {
 			partition.triangles.resize(partition.numTriangles);
-			for (int i = 0; i < partition.numTriangles; i++)
-				stream >> partition.triangles[i];
+			stream.readArray(partition.triangles.data(), partition.numTriangles);
 		}
 
 		stream >> partition.hasBoneIndices;
 		if (partition.hasBoneIndices) {
 			partition.boneIndices.resize(partition.numVertices);
-			for (int i = 0; i < partition.numVertices; i++)
-				stream >> partition.boneIndices[i];
+			stream.readArray(partition.boneIndices.data(), partition.numVertices);
 		}
 
 		if (stream.GetVersion().User() >= 12)
@@ -278,8 +254,7 @@ void NiSkinPartition::Get(NiStream& stream) {
 			stream >> partition.vertFlags8;
 
 			partition.trueTriangles.resize(partition.numTriangles);
-			for (int i = 0; i < partition.numTriangles; i++)
-				stream >> partition.trueTriangles[i];
+			stream.readArray(partition.trueTriangles.data(), partition.numTriangles);
 		}
 
 		partitions[p] = partition;
@@ -431,146 +406,48 @@ void NiSkinPartition::notifyVerticesDelete(const std::vector<ushort>& vertIndice
 	if (vertIndices.empty())
 		return;
 
-	ushort highestRemoved = vertIndices.back();
-	std::vector<int> indexCollapse(highestRemoved + 1, 0);
-
 	NiObject::notifyVerticesDelete(vertIndices);
 
-	int remCount = 0;
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < vertIndices.size() && vertIndices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;	// Flag delete
-			remCount++;
-			j++;
-		}
-		else
-			indexCollapse[i] = remCount;
-	}
+	IndexCollapse indexCollapse(vertIndices);
+	std::vector<ushort> mapIndices;
 
-	size_t maxVertexMapSz = 0;
-	for (auto &p : partitions)
-		if (p.vertexMap.size() > maxVertexMapSz)
-			maxVertexMapSz = p.vertexMap.size();
+	for (auto &p : partitions) {
+		// Partition vertices that get deleted, in ascending order
+		mapIndices.clear();
+		for (int i = 0; i < p.vertexMap.size(); i++)
+			if (indexCollapse.IsDeleted(p.vertexMap[i]))
+				mapIndices.push_back(i);
 
-	std::vector<int> mapCollapse(maxVertexMapSz, 0);
-	int mapRemCount = 0;
-	int mapHighestRemoved = maxVertexMapSz;
+		IndexCollapse mapCollapse(mapIndices);
 
-	ushort index;
-	for (auto &p : partitions) {
-		mapRemCount = 0;
-		mapHighestRemoved = maxVertexMapSz;
+		// Vertex map holds shape indices, the deleted ones are removed and the rest renumbered
+		int n = 0;
 		for (int i = 0; i < p.vertexMap.size(); i++) {
-			if (p.vertexMap[i] <= highestRemoved && indexCollapse[p.vertexMap[i]] == -1) {
-				mapRemCount++;
-				mapCollapse[i] = -1;
-				mapHighestRemoved = i;
-			}
-			else
-				mapCollapse[i] = mapRemCount;
+			int index = indexCollapse[p.vertexMap[i]];
+			if (index != -1)
+				p.vertexMap[n++] = index;
 		}
+		p.vertexMap.resize(n);
+		p.numVertices = n;
 
-		for (int i = p.vertexMap.size() - 1; i >= 0; i--) {
-			index = p.vertexMap[i];
-			if (index > highestRemoved) {
-				p.vertexMap[i] -= remCount;
-			}
-			else if (indexCollapse[index] == -1) {
-				p.vertexMap.erase(p.vertexMap.begin() + i);
-				p.numVertices--;
-				if (p.hasVertexWeights)
-					p.vertexWeights.erase(p.vertexWeights.begin() + i);
-				if (p.hasBoneIndices)
-					p.boneIndices.erase(p.boneIndices.begin() + i);
-			}
-			else
-				p.vertexMap[i] -= indexCollapse[index];
-		}
+		if (p.hasVertexWeights)
+			mapCollapse.CompactData(p.vertexWeights);
+		if (p.hasBoneIndices)
+			mapCollapse.CompactData(p.boneIndices);
 
+		// True triangles use shape indices, the others index the vertex map
 		if (!p.trueTriangles.empty()) {
-			for (int i = p.numTriangles - 1; i >= 0; i--) {
-				if (p.triangles[i].p1 > highestRemoved) {
-					p.triangles[i].p1 -= remCount;
-				}
-				else if (indexCollapse[p.triangles[i].p1] == -1) {
-					p.triangles.erase(p.triangles.begin() + i);
-					p.numTriangles--;
-					continue;
-				}
-				else
-					p.triangles[i].p1 -= indexCollapse[p.triangles[i].p1];
-
-				if (p.triangles[i].p2 > highestRemoved) {
-					p.triangles[i].p2 -= remCount;
-				}
-				else if (indexCollapse[p.triangles[i].p2] == -1) {
-					p.triangles.erase(p.triangles.begin() + i);
-					p.numTriangles--;
-					continue;
-				}
-				else
-					p.triangles[i].p2 -= indexCollapse[p.triangles[i].p2];
-
-				if (p.triangles[i].p3 > highestRemoved) {
-					p.triangles[i].p3 -= remCount;
-				}
-				else if (indexCollapse[p.triangles[i].p3] == -1) {
-					p.triangles.erase(p.triangles.begin() + i);
-					p.numTriangles--;
-					continue;
-				}
-				else
-					p.triangles[i].p3 -= indexCollapse[p.triangles[i].p3];
-			}
-
+			indexCollapse.CompactTriangles(p.triangles);
 			p.trueTriangles = p.triangles;
 		}
-		else {
-			for (int i = p.numTriangles - 1; i >= 0; i--) {
-				if (p.triangles[i].p1 > mapHighestRemoved) {
-					p.triangles[i].p1 -= mapRemCount;
-				}
-				else if (mapCollapse[p.triangles[i].p1] == -1) {
-					p.triangles.erase(p.triangles.begin() + i);
-					p.numTriangles--;
-					continue;
-				}
-				else
-					p.triangles[i].p1 -= mapCollapse[p.triangles[i].p1];
-
-				if (p.triangles[i].p2 > mapHighestRemoved) {
-					p.triangles[i].p2 -= mapRemCount;
-				}
-				else if (mapCollapse[p.triangles[i].p2] == -1) {
-					p.triangles.erase(p.triangles.begin() + i);
-					p.numTriangles--;
-					continue;
-				}
-				else
-					p.triangles[i].p2 -= mapCollapse[p.triangles[i].p2];
+		else
+			mapCollapse.CompactTriangles(p.triangles);
 
-				if (p.triangles[i].p3 > mapHighestRemoved) {
-					p.triangles[i].p3 -= mapRemCount;
-				}
-				else if (mapCollapse[p.triangles[i].p3] == -1) {
-					p.triangles.erase(p.triangles.begin() + i);
-					p.numTriangles--;
-					continue;
-				}
-				else
-					p.triangles[i].p3 -= mapCollapse[p.triangles[i].p3];
-			}
-		}
+		p.numTriangles = p.triangles.size();
 	}
 
 	if (!vertData.empty()) {
-		auto vertBegin = &vertData.front();
-		auto pos = remove_if(vertData.begin(), vertData.end(), [&vertBegin, &vertIndices](BSVertexData& v) {
-			auto i = std::distance(vertBegin, &v);
-			return (std::find(vertIndices.begin(), vertIndices.end(), i) != vertIndices.end());
-		});
-
-		vertData.erase(pos, vertData.end());
+		indexCollapse.CompactData(vertData);
 		numVertices = vertData.size();
 	}
 }
@@ -688,8 +565,7 @@ void BSDismemberSkinInstance::Get(NiStream& stream) {
 	stream >> numPartitions;
 	partitions.resize(numPartitions);
 
-	for (int i = 0; i < numPartitions; i++)
-		stream >> partitions[i];
+	stream.readArray(partitions.data(), numPartitions);
 }
 
 void BSDismemberSkinInstance::Put(NiStream& stream) {
@@ -739,8 +615,7 @@ void BSSkinBoneData::Get(NiStream& stream) {
 
 	stream >> nBones;
 	boneXforms.resize(nBones);
-	for (int i = 0; i < nBones; i++)
-		stream >> boneXforms[i];
+	stream.readArray(boneXforms.data(), nBones);
 }
 
 void BSSkinBoneData::Put(NiStream& stream) {
@@ -778,8 +653,7 @@ void BSSkinInstance::Get(NiStream& stream) {
 
 	stream >> numUnk;
 	unk.resize(numUnk);
-	for (int i = 0; i < numUnk; i++)
-		stream >> unk[i];
+	stream.readArray(unk.data(), numUnk);
 }
 
 void BSSkinInstance::Put(NiStream& stream) {
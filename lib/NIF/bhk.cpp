@@ -279,13 +279,11 @@ void bhkConvexVerticesShape::Get(NiStream& stream) {
 
 	stream >> numVerts;
 	verts.resize(numVerts);
-	for (int i = 0; i < numVerts; i++)
-		stream >> verts[i];
+	stream.readArray(verts.data(), numVerts);
 
 	stream >> numNormals;
 	normals.resize(numNormals);
-	for (int i = 0; i < numNormals; i++)
-		stream >> normals[i];
+	stream.readArray(normals.data(), numNormals);
 }
 
 void bhkConvexVerticesShape::Put(NiStream& stream) {
@@ -467,8 +465,7 @@ void bhkMoppBvTreeShape::Get(NiStream& stream) {
 		stream >> buildType;
 
 	data.resize(dataSize);
-	for (int i = 0; i < dataSize; i++)
-		stream >> data[i];
+	stream.readArray(data.data(), dataSize);
 }
 
 void bhkMoppBvTreeShape::Put(NiStream& stream) {
@@ -534,8 +531,7 @@ void bhkNiTriStripsShape::Get(NiStream& stream) {
 
 	stream >> numFilters;
 	filters.resize(numFilters);
-	for (int i = 0; i < numFilters; i++)
-		stream >> filters[i];
+	stream.readArray(filters.data(), numFilters);
 }
 
 void bhkNiTriStripsShape::Put(NiStream& stream) {
@@ -595,8 +591,7 @@ void bhkListShape::Get(NiStream& stream) {
 	stream >> numUnkInts;
 	unkInts.resize(numUnkInts);
 
-	for (int i = 0; i < numUnkInts; i++)
-		stream >> unkInts[i];
+	stream.readArray(unkInts.data(), numUnkInts);
 }
 
 void bhkListShape::Put(NiStream& stream) {
@@ -1212,8 +1207,7 @@ void bhkBallSocketConstraintChain::Get(NiStream& stream) {
 
 	stream >> numPivots;
 	pivots.resize(numPivots);
-	for (int i = 0; i < numPivots; i++)
-		stream >> pivots[i];
+	stream.readArray(pivots.data(), numPivots);
 
 	stream >> tau;
 	stream >> damping;
@@ -1440,35 +1434,29 @@ void bhkCompressedMeshShapeData::Get(NiStream& stream) {
 
 	stream >> numMat32;
 	mat32.resize(numMat32);
-	for (int i = 0; i < numMat32; i++)
-		stream >> mat32[i];
+	stream.readArray(mat32.data(), numMat32);
 
 	stream >> numMat16;
 	mat16.resize(numMat16);
-	for (int i = 0; i < numMat16; i++)
-		stream >> mat16[i];
+	stream.readArray(mat16.data(), numMat16);
 
 	stream >> numMat8;
 	mat8.resize(numMat8);
-	for (int i = 0; i < numMat8; i++)
-		stream >> mat8[i];
+	stream.readArray(mat8.data(), numMat8);
 
 	stream >> numMaterials;
 	materials.resize(numMaterials);
-	for (int i = 0; i < numMaterials; i++)
-		stream >> materials[i];
+	stream.readArray(materials.data(), numMaterials);
 
 	stream >> numNamedMat;
 
 	stream >> numTransforms;
 	transforms.resize(numTransforms);
-	for (int i = 0; i < numTransforms; i++)
-		stream >> transforms[i];
+	stream.readArray(transforms.data(), numTransforms);
 
 	stream >> numBigVerts;
 	bigVerts.resize(numBigVerts);
-	for (int i = 0; i < numBigVerts; i++)
-		stream >> bigVerts[i];
+	stream.readArray(bigVerts.data(), numBigVerts);
 
 	stream >> numBigTris;
 	bigTris.resize(numBigTris);
@@ -1485,23 +1473,19 @@ void bhkCompressedMeshShapeData::Get(NiStream& stream) {
 
 		stream >> chunks[i].numVerts;
 		chunks[i].verts.resize(chunks[i].numVerts);
-		for (int j = 0; j < chunks[i].numVerts; j++)
-			stream >> chunks[i].verts[j];
+		stream.readArray(chunks[i].verts.data(), chunks[i].numVerts);
 
 		stream >> chunks[i].numIndices;
 		chunks[i].indices.resize(chunks[i].numIndices);
-		for (int j = 0; j < chunks[i].numIndices; j++)
-			stream >> chunks[i].indices[j];
+		stream.readArray(chunks[i].indices.data(), chunks[i].numIndices);
 
 		stream >> chunks[i].numStrips;
 		chunks[i].strips.resize(chunks[i].numStrips);
-		for (int j = 0; j < chunks[i].numStrips; j++)
-			stream >> chunks[i].strips[j];
+		stream.readArray(chunks[i].strips.data(), chunks[i].numStrips);
 
 		stream >> chunks[i].numWeldingInfo;
 		chunks[i].weldingInfo.resize(chunks[i].numWeldingInfo);
-		for (int j = 0; j < chunks[i].numWeldingInfo; j++)
-			stream >> chunks[i].weldingInfo[j];
+		stream.readArray(chunks[i].weldingInfo.data(), chunks[i].numWeldingInfo);
 	}
 
 	stream >> numConvexPieceA;
@@ -0,0 +1,663 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "GeometryKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GEOMETRY_KERNELS_SSE
+
+// MSVC allows AVX2 intrinsics in any function, other compilers only if the whole file is built for AVX2
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define GEOMETRY_KERNELS_AVX2
+#endif
+#endif
+
+#ifdef GEOMETRY_KERNELS_SSE
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+namespace {
+	enum InstructionSet {
+		IS_SCALAR,
+		IS_SSE,
+		IS_AVX2
+	};
+
+	InstructionSet DetectInstructionSet() {
+#if defined(GEOMETRY_KERNELS_SSE) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool sse2 = (info[3] & (1 << 26)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+
+		// The OS has to save the AVX registers as well
+		if (osxsave && avx && maxLeaf >= 7 && (_xgetbv(0) & 6) == 6) {
+			__cpuidex(info, 7, 0);
+			if (info[1] & (1 << 5))
+				return IS_AVX2;
+		}
+
+		if (sse2)
+			return IS_SSE;
+#elif defined(GEOMETRY_KERNELS_SSE)
+		__builtin_cpu_init();
+#ifdef GEOMETRY_KERNELS_AVX2
+		if (__builtin_cpu_supports("avx2"))
+			return IS_AVX2;
+#endif
+		if (__builtin_cpu_supports("sse2"))
+			return IS_SSE;
+#endif
+		return IS_SCALAR;
+	}
+
+	const InstructionSet instructionSet = DetectInstructionSet();
+
+
+	// Scalar code, also used for the remainders of the SIMD paths
+
+	void FaceNormalsScalar(const Vector3* verts, const Triangle* tris, int start, int end, Vector3* normals) {
+		for (int t = start; t < end; t++) {
+			const Triangle& tri = tris[t];
+			const Vector3& v1 = verts[tri.p1];
+			const Vector3& v2 = verts[tri.p2];
+			const Vector3& v3 = verts[tri.p3];
+
+			Vector3 tn;
+			tn.x = (v2.y - v1.y) * (v3.z - v1.z) - (v2.z - v1.z) * (v3.y - v1.y);
+			tn.y = (v2.z - v1.z) * (v3.x - v1.x) - (v2.x - v1.x) * (v3.z - v1.z);
+			tn.z = (v2.x - v1.x) * (v3.y - v1.y) - (v2.y - v1.y) * (v3.x - v1.x);
+
+			normals[tri.p1] += tn;
+			normals[tri.p2] += tn;
+			normals[tri.p3] += tn;
+		}
+	}
+
+	void TriangleTangentsScalar(const Vector3* verts, const Vector2* uvs, const Triangle* tris, int start, int end, Vector3* tangents, Vector3* bitangents) {
+		for (int t = start; t < end; t++) {
+			int i1 = tris[t].p1;
+			int i2 = tris[t].p2;
+			int i3 = tris[t].p3;
+
+			const Vector3& v1 = verts[i1];
+			const Vector3& v2 = verts[i2];
+			const Vector3& v3 = verts[i3];
+
+			const Vector2& w1 = uvs[i1];
+			const Vector2& w2 = uvs[i2];
+			const Vector2& w3 = uvs[i3];
+
+			float x1 = v2.x - v1.x;
+			float x2 = v3.x - v1.x;
+			float y1 = v2.y - v1.y;
+			float y2 = v3.y - v1.y;
+			float z1 = v2.z - v1.z;
+			float z2 = v3.z - v1.z;
+
+			float s1 = w2.u - w1.u;
+			float s2 = w3.u - w1.u;
+			float t1 = w2.v - w1.v;
+			float t2 = w3.v - w1.v;
+
+			float r = (s1 * t2 - s2 * t1);
+			r = (r >= 0.0f ? +1.0f : -1.0f);
+
+			Vector3 sdir = Vector3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+			Vector3 tdir = Vector3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+
+			sdir.Normalize();
+			tdir.Normalize();
+
+			tangents[i1] += tdir;
+			tangents[i2] += tdir;
+			tangents[i3] += tdir;
+
+			bitangents[i1] += sdir;
+			bitangents[i2] += sdir;
+			bitangents[i3] += sdir;
+		}
+	}
+
+	void NormalizeScalar(Vector3* vecs, int start, int end) {
+		for (int i = start; i < end; i++)
+			vecs[i].Normalize();
+	}
+
+	void OrthogonalizeScalar(const Vector3* normals, Vector3* tangents, Vector3* bitangents, int start, int end) {
+		for (int i = start; i < end; i++) {
+			const Vector3& n = normals[i];
+			Vector3& tan = tangents[i];
+			Vector3& bitan = bitangents[i];
+
+			if (tan.IsZero() || bitan.IsZero()) {
+				tan.x = n.y;
+				tan.y = n.z;
+				tan.z = n.x;
+				bitan = n.cross(tan);
+			}
+			else {
+				tan.Normalize();
+				tan = (tan - n * n.dot(tan));
+				tan.Normalize();
+
+				bitan.Normalize();
+
+				bitan = (bitan - n * n.dot(bitan));
+				bitan = (bitan - tan * tan.dot(bitan));
+
+				bitan.Normalize();
+			}
+		}
+	}
+
+	void PackScalar(const Vector3* vecs, int start, int end, byte* outX, byte* outY, byte* outZ, size_t stride) {
+		for (int i = start; i < end; i++) {
+			if (outX)
+				outX[i * stride] = (byte)round((((vecs[i].x + 1.0f) / 2.0f) * 255.0f));
+			if (outY)
+				outY[i * stride] = (byte)round((((vecs[i].y + 1.0f) / 2.0f) * 255.0f));
+			if (outZ)
+				outZ[i * stride] = (byte)round((((vecs[i].z + 1.0f) / 2.0f) * 255.0f));
+		}
+	}
+
+
+#ifdef GEOMETRY_KERNELS_SSE
+	struct SSEOps {
+		typedef __m128 F;
+		static const int width = 4;
+
+		static F Load(const float* p) { return _mm_loadu_ps(p); }
+		static void Store(float* p, F a) { _mm_storeu_ps(p, a); }
+		static F Set(float f) { return _mm_set1_ps(f); }
+		static F Gather(const float* base, const int* indices) {
+			return _mm_set_ps(base[indices[3]], base[indices[2]], base[indices[1]], base[indices[0]]);
+		}
+
+		static F Add(F a, F b) { return _mm_add_ps(a, b); }
+		static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+		static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+		static F Div(F a, F b) { return _mm_div_ps(a, b); }
+		static F Sqrt(F a) { return _mm_sqrt_ps(a); }
+
+		static F Equal(F a, F b) { return _mm_cmpeq_ps(a, b); }
+		static F GreaterEqual(F a, F b) { return _mm_cmpge_ps(a, b); }
+		static F LessEqual(F a, F b) { return _mm_cmple_ps(a, b); }
+		static F And(F a, F b) { return _mm_and_ps(a, b); }
+		static F Or(F a, F b) { return _mm_or_ps(a, b); }
+
+		// mask ? a : b
+		static F Select(F mask, F a, F b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+		static F Truncate(F a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+		static void StoreInt(int* p, F a) { _mm_storeu_si128((__m128i*)p, _mm_cvttps_epi32(a)); }
+	};
+#endif
+
+#ifdef GEOMETRY_KERNELS_AVX2
+	struct AVX2Ops {
+		typedef __m256 F;
+		static const int width = 8;
+
+		static F Load(const float* p) { return _mm256_loadu_ps(p); }
+		static void Store(float* p, F a) { _mm256_storeu_ps(p, a); }
+		static F Set(float f) { return _mm256_set1_ps(f); }
+		static F Gather(const float* base, const int* indices) {
+			return _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)indices), 4);
+		}
+
+		static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+		static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+		static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+		static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+		static F Sqrt(F a) { return _mm256_sqrt_ps(a); }
+
+		static F Equal(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		static F GreaterEqual(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+		static F LessEqual(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+		static F And(F a, F b) { return _mm256_and_ps(a, b); }
+		static F Or(F a, F b) { return _mm256_or_ps(a, b); }
+
+		// mask ? a : b
+		static F Select(F mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+
+		static F Truncate(F a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+		static void StoreInt(int* p, F a) { _mm256_storeu_si256((__m256i*)p, _mm256_cvttps_epi32(a)); }
+	};
+#endif
+
+#ifdef GEOMETRY_KERNELS_SSE
+	// Vectors of one block, one lane per element
+	template<typename Ops>
+	struct Lanes {
+		typename Ops::F x;
+		typename Ops::F y;
+		typename Ops::F z;
+
+		// AoS to SoA
+		void Load(const Vector3* vecs) {
+			alignas(32) float lx[Ops::width];
+			alignas(32) float ly[Ops::width];
+			alignas(32) float lz[Ops::width];
+			for (int l = 0; l < Ops::width; l++) {
+				lx[l] = vecs[l].x;
+				ly[l] = vecs[l].y;
+				lz[l] = vecs[l].z;
+			}
+
+			x = Ops::Load(lx);
+			y = Ops::Load(ly);
+			z = Ops::Load(lz);
+		}
+
+		void Store(Vector3* vecs) const {
+			alignas(32) float lx[Ops::width];
+			alignas(32) float ly[Ops::width];
+			alignas(32) float lz[Ops::width];
+			Ops::Store(lx, x);
+			Ops::Store(ly, y);
+			Ops::Store(lz, z);
+
+			for (int l = 0; l < Ops::width; l++) {
+				vecs[l].x = lx[l];
+				vecs[l].y = ly[l];
+				vecs[l].z = lz[l];
+			}
+		}
+
+		// Adds lane l to a vector
+		static void AddTo(Vector3& vec, const float* lx, const float* ly, const float* lz, int l) {
+			vec.x += lx[l];
+			vec.y += ly[l];
+			vec.z += lz[l];
+		}
+	};
+
+	// Same operations as Vector3::Normalize
+	template<typename Ops>
+	void NormalizeLanes(Lanes<Ops>& v) {
+		typedef typename Ops::F F;
+		F d = Ops::Sqrt(Ops::Add(Ops::Add(Ops::Mul(v.x, v.x), Ops::Mul(v.y, v.y)), Ops::Mul(v.z, v.z)));
+		d = Ops::Select(Ops::Equal(d, Ops::Set(0.0f)), Ops::Set(1.0f), d);
+
+		v.x = Ops::Div(v.x, d);
+		v.y = Ops::Div(v.y, d);
+		v.z = Ops::Div(v.z, d);
+	}
+
+	template<typename Ops>
+	typename Ops::F DotLanes(const Lanes<Ops>& a, const Lanes<Ops>& b) {
+		return Ops::Add(Ops::Add(Ops::Mul(a.x, b.x), Ops::Mul(a.y, b.y)), Ops::Mul(a.z, b.z));
+	}
+
+	// a - b * f
+	template<typename Ops>
+	Lanes<Ops> SubScaledLanes(const Lanes<Ops>& a, const Lanes<Ops>& b, typename Ops::F f) {
+		Lanes<Ops> r;
+		r.x = Ops::Sub(a.x, Ops::Mul(b.x, f));
+		r.y = Ops::Sub(a.y, Ops::Mul(b.y, f));
+		r.z = Ops::Sub(a.z, Ops::Mul(b.z, f));
+		return r;
+	}
+
+	template<typename Ops>
+	void FaceNormalsSIMD(const Vector3* verts, const Triangle* tris, int numTris, Vector3* normals) {
+		typedef typename Ops::F F;
+		const int w = Ops::width;
+		const float* base = &verts[0].x;
+
+		alignas(32) int i1[w];
+		alignas(32) int i2[w];
+		alignas(32) int i3[w];
+		alignas(32) float nx[w];
+		alignas(32) float ny[w];
+		alignas(32) float nz[w];
+
+		int t = 0;
+		for (; t + w <= numTris; t += w) {
+			for (int l = 0; l < w; l++) {
+				i1[l] = tris[t + l].p1 * 3;
+				i2[l] = tris[t + l].p2 * 3;
+				i3[l] = tris[t + l].p3 * 3;
+			}
+
+			F v1x = Ops::Gather(base, i1);
+			F v1y = Ops::Gather(base + 1, i1);
+			F v1z = Ops::Gather(base + 2, i1);
+
+			F e1x = Ops::Sub(Ops::Gather(base, i2), v1x);
+			F e1y = Ops::Sub(Ops::Gather(base + 1, i2), v1y);
+			F e1z = Ops::Sub(Ops::Gather(base + 2, i2), v1z);
+
+			F e2x = Ops::Sub(Ops::Gather(base, i3), v1x);
+			F e2y = Ops::Sub(Ops::Gather(base + 1, i3), v1y);
+			F e2z = Ops::Sub(Ops::Gather(base + 2, i3), v1z);
+
+			Ops::Store(nx, Ops::Sub(Ops::Mul(e1y, e2z), Ops::Mul(e1z, e2y)));
+			Ops::Store(ny, Ops::Sub(Ops::Mul(e1z, e2x), Ops::Mul(e1x, e2z)));
+			Ops::Store(nz, Ops::Sub(Ops::Mul(e1x, e2y), Ops::Mul(e1y, e2x)));
+
+			// Accumulate in triangle order like the scalar code
+			for (int l = 0; l < w; l++) {
+				const Triangle& tri = tris[t + l];
+				Lanes<Ops>::AddTo(normals[tri.p1], nx, ny, nz, l);
+				Lanes<Ops>::AddTo(normals[tri.p2], nx, ny, nz, l);
+				Lanes<Ops>::AddTo(normals[tri.p3], nx, ny, nz, l);
+			}
+		}
+
+		FaceNormalsScalar(verts, tris, t, numTris, normals);
+	}
+
+	template<typename Ops>
+	void TriangleTangentsSIMD(const Vector3* verts, const Vector2* uvs, const Triangle* tris, int numTris, Vector3* tangents, Vector3* bitangents) {
+		typedef typename Ops::F F;
+		const int w = Ops::width;
+		const float* base = &verts[0].x;
+		const float* uvBase = &uvs[0].u;
+
+		alignas(32) int i1[w];
+		alignas(32) int i2[w];
+		alignas(32) int i3[w];
+		alignas(32) int u1[w];
+		alignas(32) int u2[w];
+		alignas(32) int u3[w];
+		alignas(32) float sx[w];
+		alignas(32) float sy[w];
+		alignas(32) float sz[w];
+		alignas(32) float tx[w];
+		alignas(32) float ty[w];
+		alignas(32) float tz[w];
+
+		int t = 0;
+		for (; t + w <= numTris; t += w) {
+			for (int l = 0; l < w; l++) {
+				const Triangle& tri = tris[t + l];
+				i1[l] = tri.p1 * 3;
+				i2[l] = tri.p2 * 3;
+				i3[l] = tri.p3 * 3;
+				u1[l] = tri.p1 * 2;
+				u2[l] = tri.p2 * 2;
+				u3[l] = tri.p3 * 2;
+			}
+
+			F v1x = Ops::Gather(base, i1);
+			F v1y = Ops::Gather(base + 1, i1);
+			F v1z = Ops::Gather(base + 2, i1);
+
+			F x1 = Ops::Sub(Ops::Gather(base, i2), v1x);
+			F x2 = Ops::Sub(Ops::Gather(base, i3), v1x);
+			F y1 = Ops::Sub(Ops::Gather(base + 1, i2), v1y);
+			F y2 = Ops::Sub(Ops::Gather(base + 1, i3), v1y);
+			F z1 = Ops::Sub(Ops::Gather(base + 2, i2), v1z);
+			F z2 = Ops::Sub(Ops::Gather(base + 2, i3), v1z);
+
+			F w1u = Ops::Gather(uvBase, u1);
+			F w1v = Ops::Gather(uvBase + 1, u1);
+			F s1 = Ops::Sub(Ops::Gather(uvBase, u2), w1u);
+			F s2 = Ops::Sub(Ops::Gather(uvBase, u3), w1u);
+			F t1 = Ops::Sub(Ops::Gather(uvBase + 1, u2), w1v);
+			F t2 = Ops::Sub(Ops::Gather(uvBase + 1, u3), w1v);
+
+			F r = Ops::Sub(Ops::Mul(s1, t2), Ops::Mul(s2, t1));
+			r = Ops::Select(Ops::GreaterEqual(r, Ops::Set(0.0f)), Ops::Set(1.0f), Ops::Set(-1.0f));
+
+			Lanes<Ops> sdir;
+			sdir.x = Ops::Mul(Ops::Sub(Ops::Mul(t2, x1), Ops::Mul(t1, x2)), r);
+			sdir.y = Ops::Mul(Ops::Sub(Ops::Mul(t2, y1), Ops::Mul(t1, y2)), r);
+			sdir.z = Ops::Mul(Ops::Sub(Ops::Mul(t2, z1), Ops::Mul(t1, z2)), r);
+
+			Lanes<Ops> tdir;
+			tdir.x = Ops::Mul(Ops::Sub(Ops::Mul(s1, x2), Ops::Mul(s2, x1)), r);
+			tdir.y = Ops::Mul(Ops::Sub(Ops::Mul(s1, y2), Ops::Mul(s2, y1)), r);
+			tdir.z = Ops::Mul(Ops::Sub(Ops::Mul(s1, z2), Ops::Mul(s2, z1)), r);
+
+			NormalizeLanes(sdir);
+			NormalizeLanes(tdir);
+
+			Ops::Store(sx, sdir.x);
+			Ops::Store(sy, sdir.y);
+			Ops::Store(sz, sdir.z);
+			Ops::Store(tx, tdir.x);
+			Ops::Store(ty, tdir.y);
+			Ops::Store(tz, tdir.z);
+
+			for (int l = 0; l < w; l++) {
+				const Triangle& tri = tris[t + l];
+				Lanes<Ops>::AddTo(tangents[tri.p1], tx, ty, tz, l);
+				Lanes<Ops>::AddTo(tangents[tri.p2], tx, ty, tz, l);
+				Lanes<Ops>::AddTo(tangents[tri.p3], tx, ty, tz, l);
+
+				Lanes<Ops>::AddTo(bitangents[tri.p1], sx, sy, sz, l);
+				Lanes<Ops>::AddTo(bitangents[tri.p2], sx, sy, sz, l);
+				Lanes<Ops>::AddTo(bitangents[tri.p3], sx, sy, sz, l);
+			}
+		}
+
+		TriangleTangentsScalar(verts, uvs, tris, t, numTris, tangents, bitangents);
+	}
+
+	template<typename Ops>
+	void NormalizeSIMD(Vector3* vecs, int count) {
+		const int w = Ops::width;
+
+		int i = 0;
+		for (; i + w <= count; i += w) {
+			Lanes<Ops> v;
+			v.Load(&vecs[i]);
+			NormalizeLanes(v);
+			v.Store(&vecs[i]);
+		}
+
+		NormalizeScalar(vecs, i, count);
+	}
+
+	template<typename Ops>
+	void OrthogonalizeSIMD(const Vector3* normals, Vector3* tangents, Vector3* bitangents, int count) {
+		typedef typename Ops::F F;
+		const int w = Ops::width;
+		const F zero = Ops::Set(0.0f);
+
+		int i = 0;
+		for (; i + w <= count; i += w) {
+			Lanes<Ops> n;
+			Lanes<Ops> tan;
+			Lanes<Ops> bitan;
+			n.Load(&normals[i]);
+			tan.Load(&tangents[i]);
+			bitan.Load(&bitangents[i]);
+
+			F tanZero = Ops::And(Ops::And(Ops::Equal(tan.x, zero), Ops::Equal(tan.y, zero)), Ops::Equal(tan.z, zero));
+			F bitanZero = Ops::And(Ops::And(Ops::Equal(bitan.x, zero), Ops::Equal(bitan.y, zero)), Ops::Equal(bitan.z, zero));
+			F useNormal = Ops::Or(tanZero, bitanZero);
+
+			// Derived from the normal
+			Lanes<Ops> nTan;
+			nTan.x = n.y;
+			nTan.y = n.z;
+			nTan.z = n.x;
+
+			Lanes<Ops> nBitan;
+			nBitan.x = Ops::Sub(Ops::Mul(n.y, nTan.z), Ops::Mul(n.z, nTan.y));
+			nBitan.y = Ops::Sub(Ops::Mul(n.z, nTan.x), Ops::Mul(n.x, nTan.z));
+			nBitan.z = Ops::Sub(Ops::Mul(n.x, nTan.y), Ops::Mul(n.y, nTan.x));
+
+			// Gram-Schmidt
+			NormalizeLanes(tan);
+			tan = SubScaledLanes(tan, n, DotLanes(n, tan));
+			NormalizeLanes(tan);
+
+			NormalizeLanes(bitan);
+			bitan = SubScaledLanes(bitan, n, DotLanes(n, bitan));
+			bitan = SubScaledLanes(bitan, tan, DotLanes(tan, bitan));
+			NormalizeLanes(bitan);
+
+			tan.x = Ops::Select(useNormal, nTan.x, tan.x);
+			tan.y = Ops::Select(useNormal, nTan.y, tan.y);
+			tan.z = Ops::Select(useNormal, nTan.z, tan.z);
+			bitan.x = Ops::Select(useNormal, nBitan.x, bitan.x);
+			bitan.y = Ops::Select(useNormal, nBitan.y, bitan.y);
+			bitan.z = Ops::Select(useNormal, nBitan.z, bitan.z);
+
+			tan.Store(&tangents[i]);
+			bitan.Store(&bitangents[i]);
+		}
+
+		OrthogonalizeScalar(normals, tangents, bitangents, i, count);
+	}
+
+	// round() rounds halfway cases away from zero
+	template<typename Ops>
+	typename Ops::F QuantizeLanes(typename Ops::F c) {
+		typedef typename Ops::F F;
+		F v = Ops::Mul(Ops::Div(Ops::Add(c, Ops::Set(1.0f)), Ops::Set(2.0f)), Ops::Set(255.0f));
+		F t = Ops::Truncate(v);
+		F frac = Ops::Sub(v, t);
+
+		F up = Ops::And(Ops::GreaterEqual(frac, Ops::Set(0.5f)), Ops::Set(1.0f));
+		F down = Ops::And(Ops::LessEqual(frac, Ops::Set(-0.5f)), Ops::Set(1.0f));
+		return Ops::Sub(Ops::Add(t, up), down);
+	}
+
+	template<typename Ops>
+	void PackSIMD(const Vector3* vecs, int count, byte* outX, byte* outY, byte* outZ, size_t stride) {
+		const int w = Ops::width;
+		alignas(32) int qx[w];
+		alignas(32) int qy[w];
+		alignas(32) int qz[w];
+
+		int i = 0;
+		for (; i + w <= count; i += w) {
+			Lanes<Ops> v;
+			v.Load(&vecs[i]);
+			Ops::StoreInt(qx, QuantizeLanes<Ops>(v.x));
+			Ops::StoreInt(qy, QuantizeLanes<Ops>(v.y));
+			Ops::StoreInt(qz, QuantizeLanes<Ops>(v.z));
+
+			for (int l = 0; l < w; l++) {
+				size_t offset = (i + l) * stride;
+				if (outX)
+					outX[offset] = (byte)qx[l];
+				if (outY)
+					outY[offset] = (byte)qy[l];
+				if (outZ)
+					outZ[offset] = (byte)qz[l];
+			}
+		}
+
+		PackScalar(vecs, i, count, outX, outY, outZ, stride);
+	}
+#endif
+}
+
+void GeometryKernels::AccumulateFaceNormals(const Vector3* verts, const Triangle* tris, int numTris, Vector3* normals) {
+	switch (instructionSet) {
+#ifdef GEOMETRY_KERNELS_AVX2
+	case IS_AVX2:
+		FaceNormalsSIMD<AVX2Ops>(verts, tris, numTris, normals);
+		break;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE
+	case IS_SSE:
+		FaceNormalsSIMD<SSEOps>(verts, tris, numTris, normals);
+		break;
+#endif
+	default:
+		FaceNormalsScalar(verts, tris, 0, numTris, normals);
+		break;
+	}
+}
+
+void GeometryKernels::AccumulateTriangleTangents(const Vector3* verts, const Vector2* uvs, const Triangle* tris, int numTris, Vector3* tangents, Vector3* bitangents) {
+	switch (instructionSet) {
+#ifdef GEOMETRY_KERNELS_AVX2
+	case IS_AVX2:
+		TriangleTangentsSIMD<AVX2Ops>(verts, uvs, tris, numTris, tangents, bitangents);
+		break;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE
+	case IS_SSE:
+		TriangleTangentsSIMD<SSEOps>(verts, uvs, tris, numTris, tangents, bitangents);
+		break;
+#endif
+	default:
+		TriangleTangentsScalar(verts, uvs, tris, 0, numTris, tangents, bitangents);
+		break;
+	}
+}
+
+void GeometryKernels::NormalizeVectors(Vector3* vecs, int count) {
+	switch (instructionSet) {
+#ifdef GEOMETRY_KERNELS_AVX2
+	case IS_AVX2:
+		NormalizeSIMD<AVX2Ops>(vecs, count);
+		break;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE
+	case IS_SSE:
+		NormalizeSIMD<SSEOps>(vecs, count);
+		break;
+#endif
+	default:
+		NormalizeScalar(vecs, 0, count);
+		break;
+	}
+}
+
+void GeometryKernels::OrthogonalizeTangents(const Vector3* normals, Vector3* tangents, Vector3* bitangents, int count) {
+	switch (instructionSet) {
+#ifdef GEOMETRY_KERNELS_AVX2
+	case IS_AVX2:
+		OrthogonalizeSIMD<AVX2Ops>(normals, tangents, bitangents, count);
+		break;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE
+	case IS_SSE:
+		OrthogonalizeSIMD<SSEOps>(normals, tangents, bitangents, count);
+		break;
+#endif
+	default:
+		OrthogonalizeScalar(normals, tangents, bitangents, 0, count);
+		break;
+	}
+}
+
+void GeometryKernels::PackUnitVectors(const Vector3* vecs, int count, byte* outX, byte* outY, byte* outZ, size_t stride) {
+	switch (instructionSet) {
+#ifdef GEOMETRY_KERNELS_AVX2
+	case IS_AVX2:
+		PackSIMD<AVX2Ops>(vecs, count, outX, outY, outZ, stride);
+		break;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE
+	case IS_SSE:
+		PackSIMD<SSEOps>(vecs, count, outX, outY, outZ, stride);
+		break;
+#endif
+	default:
+		PackScalar(vecs, 0, count, outX, outY, outZ, stride);
+		break;
+	}
+}
+
+const char* GeometryKernels::GetInstructionSet() {
+	switch (instructionSet) {
+	case IS_AVX2:
+		return "AVX2";
+	case IS_SSE:
+		return "SSE";
+	default:
+		return "Scalar";
+	}
+}
@@ -0,0 +1,34 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "Object3d.h"
+
+// Normal and tangent space kernels for triangle meshes.
+// Blocks of triangles and vertices are processed as separate x, y and z lanes with AVX2 or SSE, whichever the CPU supports,
+// with a scalar fallback. All paths do the same float operations in the same order, so their results are identical.
+namespace GeometryKernels {
+	// Adds the unnormalized face normal of each triangle to the normals of its three vertices
+	void AccumulateFaceNormals(const Vector3* verts, const Triangle* tris, int numTris, Vector3* normals);
+
+	// Adds the normalized texture space directions of each triangle to the tangents (along v) and bitangents (along u) of its vertices
+	void AccumulateTriangleTangents(const Vector3* verts, const Vector2* uvs, const Triangle* tris, int numTris, Vector3* tangents, Vector3* bitangents);
+
+	// Normalizes all vectors, zero vectors stay zero
+	void NormalizeVectors(Vector3* vecs, int count);
+
+	// Makes accumulated tangents and bitangents orthonormal to the normals and to each other (Gram-Schmidt).
+	// Vertices without accumulated directions get a tangent and bitangent derived from the normal instead.
+	void OrthogonalizeTangents(const Vector3* normals, Vector3* tangents, Vector3* bitangents, int count);
+
+	// Quantizes the components of unit vectors to round((c + 1) / 2 * 255).
+	// Each output advances by stride bytes per vector, null outputs are skipped.
+	void PackUnitVectors(const Vector3* vecs, int count, byte* outX, byte* outY, byte* outZ, size_t stride);
+
+	// Name of the instruction set the kernels run with on this CPU
+	const char* GetInstructionSet();
+}
@@ -0,0 +1,137 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "HalfFloat.h"
+#include "half.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+// MSVC allows F16C intrinsics in any function, other compilers only if the whole file is built for F16C
+#if defined(_MSC_VER) || defined(__F16C__)
+#define HALF_FLOAT_F16C
+#endif
+#endif
+
+#ifdef HALF_FLOAT_F16C
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+namespace {
+	bool DetectF16C() {
+#if defined(HALF_FLOAT_F16C) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		bool f16c = (info[2] & (1 << 29)) != 0;
+
+		// The instructions use the AVX registers, which the OS has to save as well
+		return osxsave && avx && f16c && (_xgetbv(0) & 6) == 6;
+#elif defined(HALF_FLOAT_F16C)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#else
+		return false;
+#endif
+	}
+
+	const bool hasF16C = DetectF16C();
+
+
+	void ToFloatScalar(const ushort* halves, float* floats, size_t start, size_t end) {
+		for (size_t i = start; i < end; i++)
+			floats[i] = half_float::detail::half2float<float>(halves[i]);
+	}
+
+	void FromFloatScalar(const float* floats, ushort* halves, size_t start, size_t end) {
+		for (size_t i = start; i < end; i++)
+			halves[i] = half_float::detail::float2half<(std::float_round_style)HALF_ROUND_STYLE>(floats[i]);
+	}
+
+
+#ifdef HALF_FLOAT_F16C
+	void ToFloatF16C(const ushort* halves, float* floats, size_t count) {
+		const __m128i expMask = _mm_set1_epi16(0x7C00);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m128i h = _mm_loadu_si128((const __m128i*)(halves + i));
+
+			// The hardware quiets signaling NaNs, the tables keep their bits
+			__m128i special = _mm_cmpeq_epi16(_mm_and_si128(h, expMask), expMask);
+			if (_mm_movemask_epi8(special) != 0) {
+				ToFloatScalar(halves, floats, i, i + 8);
+				continue;
+			}
+
+			_mm256_storeu_ps(floats + i, _mm256_cvtph_ps(h));
+		}
+
+		ToFloatScalar(halves, floats, i, count);
+	}
+
+	// True for the lanes where rounding to nearest even gives the same result as rounding ties away from zero:
+	// zero and values in the normal half range that aren't exactly halfway between two halves.
+	// Subnormal results, overflows, infinity and NaN are left to the tables.
+	__m128i SameRounding(__m128i bits) {
+		const __m128i absMask = _mm_set1_epi32(0x7FFFFFFF);
+		const __m128i minNormal = _mm_set1_epi32(0x387FFFFF);	// below 2^-14
+		const __m128i maxNormal = _mm_set1_epi32(0x477FF000);	// 65520, rounds to infinity
+		const __m128i roundMask = _mm_set1_epi32(0x1FFF);
+		const __m128i tie = _mm_set1_epi32(0x1000);
+
+		__m128i abs = _mm_and_si128(bits, absMask);
+		__m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(abs, minNormal), _mm_cmplt_epi32(abs, maxNormal));
+		__m128i isTie = _mm_cmpeq_epi32(_mm_and_si128(abs, roundMask), tie);
+		__m128i isZero = _mm_cmpeq_epi32(abs, _mm_setzero_si128());
+		return _mm_or_si128(_mm_andnot_si128(isTie, inRange), isZero);
+	}
+
+	void FromFloatF16C(const float* floats, ushort* halves, size_t count) {
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m128i lo = SameRounding(_mm_loadu_si128((const __m128i*)(floats + i)));
+			__m128i hi = SameRounding(_mm_loadu_si128((const __m128i*)(floats + i + 4)));
+			if (_mm_movemask_epi8(_mm_and_si128(lo, hi)) != 0xFFFF) {
+				FromFloatScalar(floats, halves, i, i + 8);
+				continue;
+			}
+
+			__m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(floats + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128((__m128i*)(halves + i), h);
+		}
+
+		FromFloatScalar(floats, halves, i, count);
+	}
+#endif
+}
+
+
+void HalfFloat::ToFloat(const ushort* halves, float* floats, size_t count) {
+#ifdef HALF_FLOAT_F16C
+	if (hasF16C) {
+		ToFloatF16C(halves, floats, count);
+		return;
+	}
+#endif
+	ToFloatScalar(halves, floats, 0, count);
+}
+
+void HalfFloat::FromFloat(const float* floats, ushort* halves, size_t count) {
+#ifdef HALF_FLOAT_F16C
+	if (hasF16C) {
+		FromFloatF16C(floats, halves, count);
+		return;
+	}
+#endif
+	FromFloatScalar(floats, halves, 0, count);
+}
+
+const char* HalfFloat::GetInstructionSet() {
+	return hasF16C ? "F16C" : "Tables";
+}
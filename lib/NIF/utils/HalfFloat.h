@@ -0,0 +1,23 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "Object3d.h"
+
+// Bulk conversion between half and single precision floats.
+// Uses the F16C instructions if the CPU supports them, otherwise the conversion tables of half.hpp.
+// Results are identical to converting each value with half_float::half.
+namespace HalfFloat {
+	// Converts count half precision values to floats
+	void ToFloat(const ushort* halves, float* floats, size_t count);
+
+	// Converts count floats to half precision, rounding to nearest with ties away from zero
+	void FromFloat(const float* floats, ushort* halves, size_t count);
+
+	// Name of the instruction set the conversions run with on this CPU
+	const char* GetInstructionSet();
+}
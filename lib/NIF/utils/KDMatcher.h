@@ -8,72 +8,158 @@ See the included LICENSE file
 
 #include "Object3d.h"
 #include <algorithm>
+#include <cmath>
 #include <memory>
 
-// A specialized KD tree that finds duplicate vertices in a point cloud.  
-
+// Finds duplicate vertices in a point cloud.
+// All points are sorted into a flat grid of cells at once, so every point is only compared with the points of its own cell
+// and the neighboring cells it is closer than EPSILON to, no matter how the input is ordered.
+// Each point is matched with the first earlier point that is closer than EPSILON on all axes and wasn't matched itself.
 class kd_matcher {
-public:
-	class kd_node {
-	public:
-		std::pair<Vector3*, int> p = std::pair<Vector3*, int>(nullptr, -1);
-		std::unique_ptr<kd_node> less;
-		std::unique_ptr<kd_node> more;
-
-		kd_node(const std::pair<Vector3*, int>& point) {
-			p = point;
-		}
+	struct cell {
+		long long x = 0;
+		long long y = 0;
+		long long z = 0;
+		int first = 0;
+		int count = 0;	// Empty slot if 0
+	};
 
-		std::pair<Vector3*, int> add(const std::pair<Vector3*, int>& point, int depth) {
-			int axis = depth % 3;
-			bool domore = false;
-			float dx = p.first->x - point.first->x;
-			float dy = p.first->y - point.first->y;
-			float dz = p.first->z - point.first->z;
-
-			if (std::fabs(dx) < EPSILON && std::fabs(dy) < EPSILON && std::fabs(dz) < EPSILON)
-				return p;
-
-			switch (axis) {
-			case 0:
-				if (dx > 0) domore = true;
-				break;
-			case 1:
-				if (dy > 0) domore = true;
-				break;
-			case 2:
-				if (dz > 0) domore = true;
-				break;
-			}
-			if (domore) {
-				if (more) return more->add(point, depth + 1);
-				else more = std::make_unique<kd_node>(point);
-			}
-			else {
-				if (less) return less->add(point, depth + 1);
-				else less = std::make_unique<kd_node>(point);
-			}
-			return std::pair<Vector3*, int>(nullptr, -1);
+	// Open addressing hash table of the occupied cells
+	std::vector<cell> cells;
+	size_t cellMask = 0;
+
+	cell& find_slot(long long x, long long y, long long z) {
+		size_t h = (size_t)((x * 73856093LL) ^ (y * 19349663LL) ^ (z * 83492791LL));
+		for (size_t s = h & cellMask;; s = (s + 1) & cellMask) {
+			cell& c = cells[s];
+			if (c.count == 0 || (c.x == x && c.y == y && c.z == z))
+				return c;
 		}
-	};
+	}
+
+	// Points too far out to be represented never match
+	static bool cell_coord(float v, long long& outCell, int& outSide) {
+		// Cells are large enough that most points don't have to look into neighboring cells at all
+		const double cellSize = EPSILON * 8.0;
 
-	std::unique_ptr<kd_node> root;
+		double d = v / cellSize;
+		double f = std::floor(d);
+		if (!(std::fabs(f) < 1e15))
+			return false;
+
+		outCell = (long long)f;
+
+		double pos = (d - f) * cellSize;
+		if (pos < EPSILON)
+			outSide = -1;
+		else if (cellSize - pos < EPSILON)
+			outSide = 1;
+		else
+			outSide = 0;
+
+		return true;
+	}
+
+public:
 	Vector3* points = nullptr;
-	int count;
+	int count = 0;
 	std::vector<std::pair<std::pair<Vector3*, int>, std::pair<Vector3*, int>>> matches;
 
-	kd_matcher(Vector3* points, int count) {
+	kd_matcher(Vector3* points, int count) : points(points), count(count) {
 		if (count <= 0)
 			return;
 
-		std::pair<Vector3*, int> pong;
-		root = std::make_unique<kd_node>(std::pair<Vector3*, int>(&points[0], 0));
-		for (int i = 1; i < count; i++) {
-			std::pair<Vector3*, int> point(&points[i], i);
-			pong = root->add(point, 0);
-			if (pong.first)
-				matches.push_back(std::pair<std::pair<Vector3*, int>, std::pair<Vector3*, int>>(point, pong));
+		size_t tableSize = 16;
+		while (tableSize < (size_t)count * 2)
+			tableSize *= 2;
+
+		cells.resize(tableSize);
+		cellMask = tableSize - 1;
+
+		// Count the points of each cell first, then store the point indices of all cells in one array
+		struct point_cell {
+			long long x, y, z;
+			int sx, sy, sz;
+			bool valid;
+		};
+
+		std::vector<point_cell> pointCells(count);
+		for (int i = 0; i < count; i++) {
+			point_cell& pc = pointCells[i];
+			pc.valid = cell_coord(points[i].x, pc.x, pc.sx)
+				&& cell_coord(points[i].y, pc.y, pc.sy)
+				&& cell_coord(points[i].z, pc.z, pc.sz);
+
+			if (pc.valid) {
+				cell& c = find_slot(pc.x, pc.y, pc.z);
+				c.x = pc.x;
+				c.y = pc.y;
+				c.z = pc.z;
+				c.count++;
+			}
+		}
+
+		// Cells are filled from their end, backwards so the indices end up ascending within each cell
+		int offset = 0;
+		for (auto &c : cells) {
+			offset += c.count;
+			c.first = offset;
+		}
+
+		std::vector<int> cellPoints(offset);
+		for (int i = count - 1; i >= 0; i--) {
+			point_cell& pc = pointCells[i];
+			if (pc.valid) {
+				cell& c = find_slot(pc.x, pc.y, pc.z);
+				cellPoints[--c.first] = i;
+			}
+		}
+
+		std::vector<bool> matched(count, false);
+		for (int i = 0; i < count; i++) {
+			const point_cell& pc = pointCells[i];
+			if (!pc.valid)
+				continue;
+
+			const Vector3& p = points[i];
+			int match = -1;
+
+			for (int n = 0; n < 8; n++) {
+				if (((n & 1) && !pc.sx) || ((n & 2) && !pc.sy) || ((n & 4) && !pc.sz))
+					continue;
+
+				cell& c = find_slot(pc.x + ((n & 1) ? pc.sx : 0), pc.y + ((n & 2) ? pc.sy : 0), pc.z + ((n & 4) ? pc.sz : 0));
+				if (c.count == 0)
+					continue;
+
+				const int* candidates = cellPoints.data() + c.first;
+				for (int k = 0; k < c.count; k++) {
+					int j = candidates[k];
+					if (j >= i || (match != -1 && j >= match))
+						break;
+
+					if (matched[j])
+						continue;
+
+					float dx = points[j].x - p.x;
+					float dy = points[j].y - p.y;
+					float dz = points[j].z - p.z;
+					if (std::fabs(dx) < EPSILON && std::fabs(dy) < EPSILON && std::fabs(dz) < EPSILON) {
+						match = j;
+						break;
+					}
+				}
+			}
+
+			if (match != -1) {
+				matched[i] = true;
+				matches.push_back(std::pair<std::pair<Vector3*, int>, std::pair<Vector3*, int>>(
+					std::pair<Vector3*, int>(&points[i], i), std::pair<Vector3*, int>(&points[match], match)));
+			}
 		}
+
+		cells.clear();
+		cells.shrink_to_fit();
 	}
 };
 
@@ -88,151 +174,188 @@ public:
 };
 
 // More general purpose KD tree that assembles a tree from input points and allows nearest neighbor and radius searches on the data.
+// The tree is balanced by median splits and stored flat in a permuted index array, node of the range [lo, hi) is at its middle.
+// Queries don't modify the tree and can run concurrently, results are written to caller-owned vectors sorted by distance.
 class kd_tree {
-public:
-	class kd_node {
-	public:
-		Vector3* p = nullptr;
-		int p_i = -1;
-		std::unique_ptr<kd_node> less;
-		std::unique_ptr<kd_node> more;
-
-		kd_node(Vector3* point, int point_index) {
-			p = point;
-			p_i = point_index;
+	Vector3* points = nullptr;
+	std::vector<int> order;		// Point indices in tree order
+	std::vector<byte> axes;		// Split axis of the node at the same position
+
+	static float axis_value(const Vector3& v, int axis) {
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	void build(int lo, int hi) {
+		if (hi - lo <= 0)
+			return;
+
+		// Split along the widest extent of the range
+		Vector3 minv = points[order[lo]];
+		Vector3 maxv = minv;
+		for (int i = lo + 1; i < hi; i++) {
+			const Vector3& v = points[order[i]];
+			minv.x = std::min(minv.x, v.x); maxv.x = std::max(maxv.x, v.x);
+			minv.y = std::min(minv.y, v.y); maxv.y = std::max(maxv.y, v.y);
+			minv.z = std::min(minv.z, v.z); maxv.z = std::max(maxv.z, v.z);
 		}
 
-		void add(Vector3* point, int point_index, int depth) {
-			int axis = depth % 3;
-			bool domore = false;
-			float dx = p->x - point->x;
-			float dy = p->y - point->y;
-			float dz = p->z - point->z;
-
-			switch (axis) {
-			case 0:
-				if (dx > 0) domore = true;
-				break;
-			case 1:
-				if (dy > 0) domore = true;
-				break;
-			case 2:
-				if (dz > 0) domore = true;
-				break;
-			}
-			if (domore) {
-				if (more) return more->add(point, point_index, depth + 1);
-				else more = std::make_unique<kd_node>(point, point_index);
+		Vector3 extent = maxv - minv;
+		int axis = 0;
+		if (extent.y > extent.x && extent.y >= extent.z)
+			axis = 1;
+		else if (extent.z > extent.x && extent.z > extent.y)
+			axis = 2;
+
+		int mid = lo + (hi - lo) / 2;
+		std::nth_element(order.begin() + lo, order.begin() + mid, order.begin() + hi, [&](int a, int b) {
+			return axis_value(points[a], axis) < axis_value(points[b], axis);
+		});
+
+		axes[mid] = axis;
+		build(lo, mid);
+		build(mid + 1, hi);
+	}
+
+	void search_radius(const Vector3& querypoint, float radiusSq, int lo, int hi, std::vector<kd_query_result>& outResults) const {
+		while (hi - lo > 0) {
+			int mid = lo + (hi - lo) / 2;
+			int pointIndex = order[mid];
+			Vector3& p = points[pointIndex];
+
+			float distSq = querypoint.DistanceSquaredTo(p);
+			if (distSq <= radiusSq) {
+				kd_query_result kdqr;
+				kdqr.v = &p;
+				kdqr.vertex_index = pointIndex;
+				kdqr.distance = distSq;
+				outResults.push_back(kdqr);
 			}
-			else {
-				if (less) return less->add(point, point_index, depth + 1);
-				else less = std::make_unique<kd_node>(point, point_index);
+
+			int axis = axes[mid];
+			float axisdist = axis_value(querypoint, axis) - axis_value(p, axis);
+
+			// Continue with the side of the query point, the opposite side only if the separating plane is within the radius
+			bool nearLess = axisdist < 0.0f;
+			if (axisdist * axisdist <= radiusSq) {
+				if (nearLess)
+					search_radius(querypoint, radiusSq, mid + 1, hi, outResults);
+				else
+					search_radius(querypoint, radiusSq, lo, mid, outResults);
 			}
+
+			if (nearLess)
+				hi = mid;
+			else
+				lo = mid + 1;
 		}
+	}
+
+	void search_knn(const Vector3& querypoint, int k, int lo, int hi, std::vector<kd_query_result>& heap) const {
+		if (hi - lo <= 0)
+			return;
+
+		int mid = lo + (hi - lo) / 2;
+		int pointIndex = order[mid];
+		Vector3& p = points[pointIndex];
 
-		// Finds the closest point(s) to "querypoint" within the provided radius. If radius is 0, only the single closest point is found.
-		// On first call, "mindist" should be set to FLT_MAX and depth set to 0.
-		void find_closest(Vector3* querypoint, std::vector<kd_query_result>& queryResult, float radius, float& mindist, int depth = 0) {
+		float distSq = querypoint.DistanceSquaredTo(p);
+		if (heap.size() < k || distSq < heap.front().distance) {
 			kd_query_result kdqr;
-			int axis = depth % 3;				// Which separating axis to use based on depth
-			float dx = p->x - querypoint->x;	// Axis sides
-			float dy = p->y - querypoint->y;
-			float dz = p->z - querypoint->z;
-			kd_node* act = less.get();				// Active search branch
-			kd_node* opp = more.get();				// Opposite search branch
-			float axisdist = 0;					// Distance from the query point to the separating axis
-			float pointdist;					// Distance from the query point to the node's point
-
-			switch (axis) {
-			case 0:
-				if (dx > 0)  {
-					act = more.get();
-					opp = less.get();
-				}
-				axisdist = std::fabs(dx);
-				break;
-			case 1:
-				if (dy > 0) {
-					act = more.get();
-					opp = less.get();
-				}
-				axisdist = std::fabs(dy);
-				break;
-			case 2:
-				if (dz > 0)  {
-					act = more.get();
-					opp = less.get();
-				}
-				axisdist = std::fabs(dz);
-				break;
+			kdqr.v = &p;
+			kdqr.vertex_index = pointIndex;
+			kdqr.distance = distSq;
+
+			if (heap.size() == k) {
+				std::pop_heap(heap.begin(), heap.end());
+				heap.pop_back();
 			}
 
-			// The axis choice tells us which branch to search
-			if (act)
-				act->find_closest(querypoint, queryResult, radius, mindist, depth + 1);
+			heap.push_back(kdqr);
+			std::push_heap(heap.begin(), heap.end());
+		}
 
-			// On the way back out check current point to see if it's the closest
-			// Fix? Might want to use squared distance instead... probably unnecessary.
-			pointdist = querypoint->DistanceTo(*p);
+		int axis = axes[mid];
+		float axisdist = axis_value(querypoint, axis) - axis_value(p, axis);
+		bool nearLess = axisdist < 0.0f;
 
-			// No opposites
-			bool notOpp = true;
-			//notOpp = (querypoint->nx * p->nx + querypoint->ny * p->ny + querypoint->nz * p->nz) > 0.0f;
+		if (nearLess)
+			search_knn(querypoint, k, lo, mid, heap);
+		else
+			search_knn(querypoint, k, mid + 1, hi, heap);
 
-			if (pointdist <= mindist && notOpp) {
-				kdqr.v = p;
-				kdqr.vertex_index = p_i;
-				kdqr.distance = pointdist;
-				queryResult.push_back(kdqr);
-				mindist = pointdist;
-			}
-			else if (radius > mindist && notOpp) {	// If there's room between the minimum distance and the search radius
-				if (pointdist <= radius) {			// check to see if the point falls in that space, and if so, add it.
-					kdqr.v = p;
-					kdqr.vertex_index = p_i;
-					kdqr.distance = pointdist;
-					queryResult.push_back(kdqr);	// This is skipped if radius is 0
-				}
-			}
-
-			// Check the opposite branch if it exists
-			if (opp) {
-				if (radius) {
-					if (radius >= axisdist)	// If separating axis is within the check radius
-						opp->find_closest(querypoint, queryResult, radius, mindist, depth + 1);
-				}
-				else  {
-					// If separating axis is closer than the current minimum point
-					// check if a closer point is on the other side of the axis.
-					if (axisdist < mindist)
-						opp->find_closest(querypoint, queryResult, radius, mindist, depth + 1);
-				}
-			}
+		// The far side can only contain closer points if the separating plane is closer than the current k-th point
+		if (heap.size() < k || axisdist * axisdist < heap.front().distance) {
+			if (nearLess)
+				search_knn(querypoint, k, mid + 1, hi, heap);
+			else
+				search_knn(querypoint, k, lo, mid, heap);
 		}
-	};
+	}
 
-	std::unique_ptr<kd_node> root;
-	std::vector<kd_query_result> queryResult;
+	// Searches collect squared distances, results are sorted and converted once at the end
+	static void finish_results(std::vector<kd_query_result>& results, size_t first) {
+		for (size_t i = first; i < results.size(); i++)
+			results[i].distance = std::sqrt(results[i].distance);
 
-	kd_tree(Vector3* points, int count) {
+		std::sort(results.begin() + first, results.end());
+	}
+
+public:
+	kd_tree(Vector3* points, int count) : points(points) {
 		if (count <= 0)
 			return;
 
-		root = std::make_unique<kd_node>(&points[0], 0);
-		for (int i = 1; i < count; i++)
-			root->add(&points[i], i, 0);
+		order.resize(count);
+		for (int i = 0; i < count; i++)
+			order[i] = i;
+
+		axes.resize(count, 0);
+		build(0, count);
+	}
+
+	int size() const {
+		return order.size();
+	}
+
+	// Finds all points within the radius of the query point. If radius is 0, only the single closest point is found.
+	// Results are appended to outResults, the number of results is returned.
+	int kd_nn(const Vector3* querypoint, float radius, std::vector<kd_query_result>& outResults) const {
+		if (order.empty())
+			return 0;
+
+		if (radius == 0.0f)
+			return kd_knn(querypoint, 1, outResults);
+
+		size_t first = outResults.size();
+		search_radius(*querypoint, radius * radius, 0, order.size(), outResults);
+		finish_results(outResults, first);
+		return outResults.size() - first;
 	}
 
-	int kd_nn(Vector3* querypoint, float radius) {
-		float mindist = std::numeric_limits<float>().max();
-		if (radius != 0.0f)
-			mindist = radius;
+	// Finds the k closest points to the query point. Results are appended to outResults, the number of results is returned.
+	int kd_knn(const Vector3* querypoint, int k, std::vector<kd_query_result>& outResults) const {
+		if (order.empty() || k <= 0)
+			return 0;
 
-		queryResult.clear();
-		root->find_closest(querypoint, queryResult, radius, mindist);
-		if (queryResult.size() > 1)
-			std::sort(queryResult.begin(), queryResult.end());
+		std::vector<kd_query_result> heap;
+		heap.reserve(k + 1);
+		search_knn(*querypoint, k, 0, order.size(), heap);
 
-		return queryResult.size();
+		size_t first = outResults.size();
+		outResults.insert(outResults.end(), heap.begin(), heap.end());
+		finish_results(outResults, first);
+		return outResults.size() - first;
+	}
+
+	// Runs kd_nn for the query points in [start, end). onResults(index, results) is called with a scratch vector that is reused for the next point.
+	// Queries don't modify the tree, so callers can run blocks of a range on their own threads.
+	template<typename Func>
+	void kd_nn_each(const Vector3* querypoints, int start, int end, float radius, const Func& onResults) const {
+		std::vector<kd_query_result> results;
+		for (int i = start; i < end; i++) {
+			results.clear();
+			kd_nn(&querypoints[i], radius, results);
+			onResults(i, results);
+		}
 	}
 };
@@ -3,7 +3,7 @@
 
 BoundingSphere::BoundingSphere(const std::vector<Vector3>& vertices) {
 	if (vertices.empty()) {
-		BoundingSphere::BoundingSphere();
+		*this = BoundingSphere();
 		return;
 	}
 
@@ -6,7 +6,11 @@ See the included LICENSE file
 
 #pragma once
 
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <vector>
+#include <utility>
 
 #pragma warning (disable : 4018 4244 4267 4389)
 
@@ -202,14 +206,14 @@ struct Vector3 {
 		return x*other.x + y*other.y + z*other.z;
 	}
 
-	float DistanceTo(const Vector3& target) {
+	float DistanceTo(const Vector3& target) const {
 		float dx = target.x - x;
 		float dy = target.y - y;
 		float dz = target.z - z;
 		return (float)std::sqrt(dx*dx + dy*dy + dz*dz);
 	}
 
-	float DistanceSquaredTo(const Vector3& target) {
+	float DistanceSquaredTo(const Vector3& target) const {
 		float dx = target.x - x;
 		float dy = target.y - y;
 		float dz = target.z - z;
@@ -546,8 +550,8 @@ public:
 	}
 
 	Matrix4& Rotate(float radAngle, float x, float y, float z) {
-		float c = std::cosf(radAngle);
-		float s = std::sinf(radAngle);
+		float c = std::cos(radAngle);
+		float s = std::sin(radAngle);
 
 		float xx = x*x;
 		float xy = x*y;
@@ -866,20 +870,100 @@ struct Edge {
 	}
 };
 
+// Old to new vertex index map for deleting a sorted list of vertex indices, built once per deletion.
+// Deleted vertices map to -1, indices past the highest deleted one are shifted by the number of deleted vertices.
+class IndexCollapse {
+	std::vector<int> newIndices;
+	int remCount = 0;
+
+public:
+	IndexCollapse(const std::vector<ushort>& vertIndices) {
+		if (vertIndices.empty())
+			return;
+
+		newIndices.resize(vertIndices.back() + 1);
+		for (int i = 0, j = 0; i < newIndices.size(); i++) {
+			if (j < vertIndices.size() && vertIndices[j] == i) {	// Found one to remove
+				newIndices[i] = -1;	// Flag delete
+				remCount++;
+				j++;
+			}
+			else
+				newIndices[i] = i - remCount;
+		}
+	}
+
+	int operator[](int index) const {
+		if (index < newIndices.size())
+			return newIndices[index];
+
+		return index - remCount;
+	}
+
+	bool IsDeleted(int index) const {
+		return index < newIndices.size() && newIndices[index] == -1;
+	}
+
+	int RemovedCount() const {
+		return remCount;
+	}
+
+	// Removes the elements of deleted vertices from per-vertex data in a single pass, keeping the order of the rest.
+	template<typename T>
+	void CompactData(std::vector<T>& data) const {
+		if (remCount == 0)
+			return;
+
+		int n = 0;
+		for (int i = 0; i < data.size(); i++) {
+			if (IsDeleted(i))
+				continue;
+
+			if (n != i)
+				data[n] = std::move(data[i]);
+			n++;
+		}
+
+		data.erase(data.begin() + n, data.end());
+	}
+
+	// Removes triangles that use deleted vertices and renumbers the rest in a single pass.
+	// Returns the indices of the removed triangles in ascending order if requested.
+	void CompactTriangles(std::vector<Triangle>& tris, std::vector<uint>* outDeletedTris = nullptr) const {
+		if (remCount == 0)
+			return;
+
+		int n = 0;
+		for (int i = 0; i < tris.size(); i++) {
+			Triangle& t = tris[i];
+			if (IsDeleted(t.p1) || IsDeleted(t.p2) || IsDeleted(t.p3)) {
+				if (outDeletedTris)
+					outDeletedTris->push_back(i);
+				continue;
+			}
+
+			tris[n].set((*this)[t.p1], (*this)[t.p2], (*this)[t.p3]);
+			n++;
+		}
+
+		tris.erase(tris.begin() + n, tris.end());
+	}
+};
+
 namespace std {
-	template<> struct std::hash < Edge > {
+	template<> struct hash < Edge > {
 		std::size_t operator() (const Edge& t) const {
 			return ((t.p2 << 16) | (t.p1 & 0xFFFF));
 		}
 	};
 
-	template <> struct std::equal_to < Edge > {
+	template <> struct equal_to < Edge > {
 		bool operator() (const Edge& t1, const Edge& t2) const {
 			return ((t1.p1 == t2.p1) && (t1.p2 == t2.p2));
 		}
 	};
 
-	template <> struct std::hash < Triangle > {
+	template <> struct hash < Triangle > {
 		std::size_t operator() (const Triangle& t) const {
 			char* d = (char*)&t;
 			std::size_t len = sizeof(Triangle);
@@ -896,7 +980,7 @@ namespace std {
 		}
 	};
 
-	template <> struct std::equal_to < Triangle > {
+	template <> struct equal_to < Triangle > {
 		bool operator() (const Triangle& t1, const Triangle& t2) const {
 			return ((t1.p1 == t2.p1) && (t1.p2 == t2.p2) && (t1.p3 == t2.p3));
 		}
@@ -0,0 +1,33 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <cstddef>
+
+// Case-insensitive string comparisons, portable replacements for _stricmp and _strnicmp of the MSVC CRT.
+// Only ASCII letters are folded, like the CRT does in the "C" locale.
+inline int StrToLowerASCII(int c) {
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+inline int StrNICmp(const char* a, const char* b, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		int ca = StrToLowerASCII((unsigned char)a[i]);
+		int cb = StrToLowerASCII((unsigned char)b[i]);
+		if (ca != cb)
+			return ca - cb;
+
+		if (ca == 0)
+			break;
+	}
+
+	return 0;
+}
+
+inline int StrICmp(const char* a, const char* b) {
+	return StrNICmp(a, b, (size_t)-1);
+}
@@ -82,34 +82,19 @@ void AnimInfo::DeleteVertsForShape(const std::string& shape, const std::vector<u
 	if (indices.empty())
 		return;
 
-	ushort highestRemoved = indices.back();
-	std::vector<int> indexCollapse(highestRemoved + 1, 0);
-
-	int remCount = 0;
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < indices.size() && indices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;						// Flag delete
-			remCount++;
-			j++;
-		}
-		else
-			indexCollapse[i] = remCount;
-	}
+	IndexCollapse indexCollapse(indices);
 
 	auto& skin = shapeSkinning[shape];
 	for (auto &w : skin.boneWeights) {
-		std::unordered_map<ushort, float> indexCopy;
+		std::unordered_map<ushort, float> weights;
+		weights.reserve(w.second.weights.size());
 		for (auto &d : w.second.weights) {
-			if (d.first > highestRemoved)
-				indexCopy.emplace(d.first - remCount, d.second);
-			else if (indexCollapse[d.first] != -1)
-				indexCopy.emplace(d.first - indexCollapse[d.first], d.second);
+			int index = indexCollapse[d.first];
+			if (index != -1)
+				weights.emplace(index, d.second);
 		}
 
-		w.second.weights.clear();
-		w.second.weights.reserve(indexCopy.size());
-		for (auto &copy : indexCopy)
-			w.second.weights[copy.first] = std::move(copy.second);
+		w.second.weights.swap(weights);
 	}
 }
 
@@ -222,33 +222,64 @@ void Automorph::DeleteVerts(const std::string& shapeName, const std::vector<usho
 }
 
 void Automorph::ClearProximityCache() {
-	prox_cache.clear();
+	proximityCaches.clear();
 }
 
-void Automorph::BuildProximityCache(const std::string& shapeName, const float& proximityRadius) {
+void Automorph::BuildProximityCache(const std::string& shapeName, const float& proximityRadius, const int& maxResults) {
 	mesh* m = sourceShapes[shapeName];
-	int maxCount = 0;
-	int minCount = 60000;
-
-	for (int i = 0; i < m->nVerts; i++) {
-		int resultCount;
-		if (foreignShapes.find(shapeName) != foreignShapes.end()) {
-			Vector3 vtmp(m->verts[i].x * -10.0f, m->verts[i].z * 10.0f, m->verts[i].y * 10.0f);
-			resultCount = refTree->kd_nn(&vtmp, proximityRadius);
-		}
-		else
-			resultCount = refTree->kd_nn(&m->verts[i], proximityRadius);
 
-		if (resultCount < minCount)
-			minCount = resultCount;
-		if (resultCount > maxCount)
-			maxCount = resultCount;
+	std::vector<Vector3> foreignVerts;
+	const Vector3* queryVerts = m->verts.get();
+	if (foreignShapes.find(shapeName) != foreignShapes.end()) {
+		foreignVerts.resize(m->nVerts);
+		for (int i = 0; i < m->nVerts; i++)
+			foreignVerts[i] = Vector3(m->verts[i].x * -10.0f, m->verts[i].z * 10.0f, m->verts[i].y * 10.0f);
 
-		std::vector<kd_query_result> indexResults;
-		for (int id = 0; id < resultCount; id++)
-			indexResults.push_back(refTree->queryResult[id]);
+		queryVerts = foreignVerts.data();
+	}
+
+	ProximityCache& cache = proximityCaches[shapeName];
+	cache = ProximityCache();
+	cache.radius = proximityRadius;
+	cache.maxResults = maxResults;
+
+	int nVerts = m->nVerts;
+	int slotCount = std::max(maxResults, 1);
+	if (nVerts <= 0)
+		return;
 
-		prox_cache[i] = indexResults;
+	if (!conformPool)
+		conformPool = std::make_unique<ThreadPool>();
+
+	// Query blocks of vertices in parallel into fixed slots per vertex
+	const int blockSize = 256;
+	std::vector<int> counts(nVerts);
+	std::vector<ushort> slotIndices(nVerts * slotCount);
+	std::vector<float> slotDistances(nVerts * slotCount);
+	conformPool->ParallelFor((nVerts + blockSize - 1) / blockSize, [&](int block) {
+		int start = block * blockSize;
+		int end = std::min(nVerts, start + blockSize);
+		refTree->kd_nn_each(queryVerts, start, end, proximityRadius, [&](int i, const std::vector<kd_query_result>& results) {
+			int count = std::min((int)results.size(), slotCount);
+			for (int j = 0; j < count; j++) {
+				slotIndices[i * slotCount + j] = results[j].vertex_index;
+				slotDistances[i * slotCount + j] = results[j].distance;
+			}
+			counts[i] = count;
+		});
+	});
+
+	// Compact the slots
+	cache.offsets.resize(nVerts + 1);
+	cache.offsets[0] = 0;
+	for (int i = 0; i < nVerts; i++)
+		cache.offsets[i + 1] = cache.offsets[i] + counts[i];
+
+	cache.indices.resize(cache.offsets[nVerts]);
+	cache.distances.resize(cache.offsets[nVerts]);
+	for (int i = 0; i < nVerts; i++) {
+		std::copy_n(slotIndices.begin() + i * slotCount, counts[i], cache.indices.begin() + cache.offsets[i]);
+		std::copy_n(slotDistances.begin() + i * slotCount, counts[i], cache.distances.begin() + cache.offsets[i]);
 	}
 }
 
@@ -259,7 +290,7 @@ void Automorph::GetRawResultDiff(const std::string& shapeName, const std::string
 
 	outDiff.clear();
 
-	std::unordered_map<ushort, Vector3>* set = resultDiffData.GetDiffSet(setName);
+	const std::unordered_map<ushort, Vector3>* set = resultDiffData.GetDiffSet(setName);
 	for (auto &i : *set)
 		outDiff[i.first] = i.second;
 }
@@ -295,7 +326,7 @@ void Automorph::SaveResultDiff(const std::string& shapeName, const std::string&
 	resultDiffData.SaveSet(setName, shapeName, fileName);
 }
 
-void Automorph::SetResultDiff(const std::string& shapeName, const std::string& sliderName, std::unordered_map<ushort, Vector3>& diff) {
+void Automorph::SetResultDiff(const std::string& shapeName, const std::string& sliderName, const std::unordered_map<ushort, Vector3>& diff) {
 	std::string setName = ResultDataName(shapeName, sliderName);
 
 	if (!resultDiffData.TargetMatch(setName, shapeName))
@@ -352,24 +383,85 @@ std::string Automorph::ResultDataName(const std::string& shapeName, const std::s
 	return f->second;
 }
 
+void Automorph::GrowProximityCache(const std::string& shapeName, int maxResults) {
+	auto cache = proximityCaches.find(shapeName);
+	if (cache != proximityCaches.end() && cache->second.maxResults < maxResults)
+		BuildProximityCache(shapeName, cache->second.radius, maxResults);
+}
+
 void Automorph::GenerateResultDiff(const std::string& shapeName, const std::string &sliderName, const std::string& refDataName, const int& maxResults) {
-	std::unordered_map<ushort, Vector3>* diffData = srcDiffData->GetDiffSet(refDataName);
-	if (!diffData)
-		return;
+	GrowProximityCache(shapeName, maxResults);
 
-	mesh* m = sourceShapes[shapeName];
-	if (resultDiffData.TargetMatch(shapeName + sliderName, shapeName)) {
-		if (m->vcolors)
-			resultDiffData.ZeroVertDiff(shapeName + sliderName, m->vcolors.get());
-		else
-			resultDiffData.ClearSet(shapeName + sliderName);
+	std::unordered_map<ushort, Vector3> diff;
+	if (ComputeResultDiff(shapeName, refDataName, maxResults, diff))
+		CommitResultDiff(shapeName, sliderName, diff);
+}
+
+bool Automorph::GenerateResultDiffs(const std::vector<ConformTask>& tasks, const int& maxResults, ConformProgressFunc progress) {
+	if (!conformPool)
+		conformPool = std::make_unique<ThreadPool>();
+
+	// Caches must not change while the tasks read them
+	for (auto &task : tasks)
+		GrowProximityCache(task.shapeName, maxResults);
+
+	std::vector<std::unordered_map<ushort, Vector3>> taskDiffs(tasks.size());
+	std::vector<char> taskValid(tasks.size(), 0);
+	std::atomic<int> doneCount(0);
+	std::atomic<bool> cancelled(false);
+
+	TaskGroup conformTasks;
+	for (int t = 0; t < tasks.size(); t++) {
+		conformPool->Submit(conformTasks, [&, t]() {
+			if (!cancelled)
+				taskValid[t] = ComputeResultDiff(tasks[t].shapeName, tasks[t].refDataName, maxResults, taskDiffs[t]);
+
+			doneCount++;
+		});
 	}
 
-	resultDiffData.AddEmptySet(shapeName + sliderName, shapeName);
+	bool finished = false;
+	while (!finished) {
+		finished = conformPool->WaitFor(conformTasks, 50);
+		if (progress && !progress(doneCount, tasks.size()))
+			cancelled = true;
+	}
 
-	for (int i = 0; i < m->nVerts; i++) {
-		std::vector<kd_query_result>* vertProx = &prox_cache[i];
-		int nValues = vertProx->size();
+	if (cancelled)
+		return false;
+
+	for (int t = 0; t < tasks.size(); t++)
+		if (taskValid[t])
+			CommitResultDiff(tasks[t].shapeName, tasks[t].sliderName, taskDiffs[t]);
+
+	return true;
+}
+
+bool Automorph::ComputeResultDiff(const std::string& shapeName, const std::string& refDataName, int maxResults, std::unordered_map<ushort, Vector3>& outDiff) {
+	const std::unordered_map<ushort, Vector3>* diffData = srcDiffData->GetDiffSet(refDataName);
+	if (!diffData)
+		return false;
+
+	auto shape = sourceShapes.find(shapeName);
+	if (shape == sourceShapes.end())
+		return false;
+
+	mesh* m = shape->second;
+
+	auto cacheIt = proximityCaches.find(shapeName);
+	if (cacheIt == proximityCaches.end())
+		return true;
+
+	const ProximityCache& cache = cacheIt->second;
+
+	// Scratch space reused for all vertices
+	std::vector<double> invDist(std::max(maxResults, 0));
+	std::vector<Vector3> effectVector(std::max(maxResults, 0));
+
+	int cachedVerts = std::min(m->nVerts, (int)cache.offsets.size() - 1);
+	for (int i = 0; i < cachedVerts; i++) {
+		int proxStart = cache.offsets[i];
+		int nValues = cache.offsets[i + 1] - proxStart;
 		if (nValues > maxResults)
 			nValues = maxResults;
 
@@ -378,13 +470,11 @@ void Automorph::GenerateResultDiff(const std::string& shapeName, const std::stri
 
 		double weight;
 		Vector3 totalMove;
-		std::vector<double> invDist(nValues);
-		std::vector<Vector3> effectVector(nValues);
 		for (int j = 0; j < nValues; j++) {
-			ushort vi = (*vertProx)[j].vertex_index;
+			ushort vi = cache.indices[proxStart + j];
 			auto diffItem = diffData->find(vi);
 			if (diffItem != diffData->end()) {
-				weight = (*vertProx)[j].distance;	// "weight" is just a placeholder here...
+				weight = cache.distances[proxStart + j];	// "weight" is just a placeholder here...
 				if (weight == 0.0)
 					invDist[nearMoves] = 1000.0;	// Exact match, choose big nearness weight.
 				else
@@ -416,6 +506,25 @@ void Automorph::GenerateResultDiff(const std::string& shapeName, const std::stri
 		if (totalMove.DistanceTo(Vector3(0.0f, 0.0f, 0.0f)) < EPSILON)
 			continue;
 
-		resultDiffData.UpdateDiff(shapeName + sliderName, shapeName, i, totalMove);
+		outDiff[i] = totalMove;
+	}
+
+	return true;
+}
+
+void Automorph::CommitResultDiff(const std::string& shapeName, const std::string& sliderName, const std::unordered_map<ushort, Vector3>& diff) {
+	mesh* m = sourceShapes[shapeName];
+	if (resultDiffData.TargetMatch(shapeName + sliderName, shapeName)) {
+		if (m && m->vcolors)
+			resultDiffData.ZeroVertDiff(shapeName + sliderName, m->vcolors.get());
+		else
+			resultDiffData.ClearSet(shapeName + sliderName);
+	}
+
+	resultDiffData.AddEmptySet(shapeName + sliderName, shapeName);
+
+	for (auto &d : diff) {
+		Vector3 move = d.second;
+		resultDiffData.UpdateDiff(shapeName + sliderName, shapeName, d.first, move);
 	}
 }
@@ -11,13 +11,34 @@ See the included LICENSE file
 #include "../files/ObjFile.h"
 #include "Mesh.h"
 #include "SliderSet.h"
+#include "../utils/ThreadPool.h"
+
+#include <functional>
+
+// One result diff to generate during a conform pass.
+struct ConformTask {
+	std::string shapeName;
+	std::string sliderName;
+	std::string refDataName;
+};
 
 class Automorph {
+	// Proximity results of all vertices of a shape in flat arrays, vertex i owns the range [offsets[i], offsets[i + 1]).
+	// Results are sorted by distance and truncated to the maximum that conforming uses.
+	struct ProximityCache {
+		float radius = 0.0f;
+		int maxResults = 0;
+		std::vector<int> offsets;
+		std::vector<ushort> indices;
+		std::vector<float> distances;
+	};
+
 	std::unique_ptr<kd_tree> refTree;
 	std::map<std::string, mesh*> sourceShapes;
 	std::map<std::string, mesh*> foreignShapes;	// Meshes linked by LinkSourceShapeMesh loaded and managed outside the.
 	// Class - to prevent AutoMorph from deleting it. Golly, smart pointers would be nice.
-	std::map<int, std::vector<kd_query_result>> prox_cache;
+	std::map<std::string, ProximityCache> proximityCaches;
+	std::unique_ptr<ThreadPool> conformPool;	// Created on first parallel proximity query or conform
 	DiffDataSets __srcDiffData;				// Unternally loaded and stored diff data.diffs loaded from existing reference .bsd files.
 	DiffDataSets* srcDiffData = nullptr;	// Either __srcDiffData or an external linked data set.
 	DiffDataSets resultDiffData;			// Diffs calculated by AutoMorph.
@@ -29,7 +50,19 @@ class Automorph {
 	// doesn't match the format targetname + slidername.
 	std::unordered_map<std::string, std::string> targetSliderDataNames;
 
+	// Rebuilds the proximity cache of the shape if it holds fewer than maxResults results per vertex.
+	void GrowProximityCache(const std::string& shapeName, int maxResults);
+
+	// Calculates a result diff without modifying any state, so it can run concurrently for different tasks.
+	bool ComputeResultDiff(const std::string& shapeName, const std::string& refDataName, int maxResults, std::unordered_map<ushort, Vector3>& outDiff);
+
+	// Replaces the result diff of the shape and slider with a computed one.
+	void CommitResultDiff(const std::string& shapeName, const std::string& sliderName, const std::unordered_map<ushort, Vector3>& diff);
+
 public:
+	// Called on the calling thread with the number of finished tasks, returning false cancels the remaining tasks.
+	typedef std::function<bool(int done, int total)> ConformProgressFunc;
+
 	std::unique_ptr<mesh> morphRef;
 
 	Automorph();
@@ -56,6 +89,10 @@ public:
 	void ApplyResultToVerts(const std::string& sliderName, const std::string& shapeTargetName, std::vector<Vector3>* inOutResult, float strength = 1.0f);
 	void ApplyResultToUVs(const std::string& sliderName, const std::string& shapeTargetName, std::vector<Vector2>* inOutResult, float strength = 1.0f);
 
+	DiffDataSets& ResultDiffData() {
+		return resultDiffData;
+	}
+
 	void SourceShapesFromNif(NifFile& baseNif);
 	void SourceShapesFromObj(ObjFile& baseObj);
 	void LinkSourceShapeMesh(mesh* m, const std::string& shapeName);
@@ -67,19 +104,25 @@ public:
 	void DeleteVerts(const std::string& shapeName, const std::vector<ushort>& indices);
 
 	void ClearProximityCache();
-	void BuildProximityCache(const std::string& shapeName, const float& proximityRadius = 10.0f);
+	void BuildProximityCache(const std::string& shapeName, const float& proximityRadius = 10.0f, const int& maxResults = 10);
 
 	// shapeName = name of the mesh to morph (eg "IronArmor") also known as target name.
 	// sliderName = name of the morph to apply (eg "BreastsSH").
+	// If maxResults is larger than the proximity cache was built with, the cache is rebuilt with the same radius first.
 	void GenerateResultDiff(const std::string& shapeName, const std::string& sliderName, const std::string& refDataName, const int& maxResults = 10);
 
+	// Generates the result diffs of all tasks in parallel. Each task writes to its own buffer, the buffers are merged into
+	// the result data on the calling thread once all tasks finished. Returns false and leaves the results untouched if cancelled.
+	// Proximity caches built with fewer than maxResults results are rebuilt before the tasks start.
+	bool GenerateResultDiffs(const std::vector<ConformTask>& tasks, const int& maxResults = 10, ConformProgressFunc progress = nullptr);
+
 	void SetResultDataName(const std::string& shapeName, const std::string& sliderName, const std::string& dataName);
 	std::string ResultDataName(const std::string& shapeName, const std::string& sliderName);
 
 	void GetRawResultDiff(const std::string& shapeName, const std::string& sliderName, std::unordered_map<ushort, Vector3>& outDiff);
 	int GetResultDiffSize(const std::string& shapeName, const std::string& sliderName);
 
-	void SetResultDiff(const std::string& shapeName, const std::string& sliderName, std::unordered_map<ushort, Vector3>& diff);
+	void SetResultDiff(const std::string& shapeName, const std::string& sliderName, const std::unordered_map<ushort, Vector3>& diff);
 	void UpdateResultDiff(const std::string& shapeName, const std::string& sliderName, std::unordered_map<ushort, Vector3>& diff);
 	void UpdateRefDiff(const std::string& shapeName, const std::string& sliderName, std::unordered_map<ushort, Vector3>& diff);
 	void EmptyResultDiff(const std::string& shapeName, const std::string& sliderName);
@@ -5,8 +5,11 @@ See the included LICENSE file
 */
 
 #include "DiffData.h"
+#include "../utils/MappedFile.h"
+#include "../utils/PlatformUtil.h"
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 
 OSDataFile::OSDataFile() {
@@ -18,40 +21,137 @@ OSDataFile::OSDataFile() {
 OSDataFile::~OSDataFile() {
 }
 
-bool OSDataFile::Read(const std::string& fileName) {
-	std::ifstream file(fileName, std::ios_base::binary);
-	if (!file)
-		return false;
+namespace {
+	// Builds the name to offset table of a mapped OSD file in one pass, offsets point to the diff count of each block
+	bool IndexOSD(const char* data, size_t size, uint& outVersion, std::vector<std::pair<std::string, size_t>>& outOffsets) {
+		if (size < 12)
+			return false;
 
-	file.read((char*)&header, 4);
-	if (header != 'OSD\0')
-		return false;
+		uint header;
+		uint dataCount;
+		memcpy(&header, data, 4);
+		if (header != 'OSD\0')
+			return false;
 
-	file.read((char*)&version, 4);
-	file.read((char*)&dataCount, 4);
+		memcpy(&outVersion, data + 4, 4);
+		memcpy(&dataCount, data + 8, 4);
 
-	byte nameLength;
-	std::string dataName;
-	ushort diffSize;
-	for (int i = 0; i < dataCount; ++i) {
-		file.read((char*)&nameLength, 1);
-		dataName.resize(nameLength, ' ');
-		file.read((char*)&dataName.front(), nameLength);
+		size_t pos = 12;
+		for (uint i = 0; i < dataCount; ++i) {
+			if (pos + 1 > size)
+				return false;
+
+			byte nameLength = data[pos];
+			pos++;
+
+			if (pos + nameLength + 2 > size)
+				return false;
+
+			std::string dataName(data + pos, nameLength);
+			pos += nameLength;
+
+			ushort diffSize;
+			memcpy(&diffSize, data + pos, 2);
+			outOffsets.emplace_back(std::move(dataName), pos);
+
+			pos += 2 + (size_t)diffSize * (2 + sizeof(Vector3));
+			if (pos > size)
+				return false;
+		}
+
+		return true;
+	}
+
+	void DecodeOSDBlock(const char* data, size_t offset, std::unordered_map<ushort, Vector3>& outDiff) {
+		ushort diffSize;
+		memcpy(&diffSize, data + offset, 2);
+
+		const char* entry = data + offset + 2;
+		outDiff.reserve(diffSize);
 
 		ushort index;
 		Vector3 diff;
-		std::unordered_map<ushort, Vector3> diffs;
-
-		file.read((char*)&diffSize, 2);
-		diffs.reserve(diffSize);
 		for (int j = 0; j < diffSize; ++j) {
-			file.read((char*)&index, 2);
-			file.read((char*)&diff, sizeof(Vector3));
+			memcpy(&index, entry, 2);
+			memcpy(&diff, entry + 2, sizeof(Vector3));
 			diff.clampEpsilon();
-			diffs.emplace(index, diff);
+			outDiff.emplace(index, diff);
+			entry += 2 + sizeof(Vector3);
+		}
+	}
+
+	bool DecodeBSD(const char* data, size_t size, std::unordered_map<ushort, Vector3>& outDiff) {
+		if (size < 4)
+			return false;
+
+		int sz;
+		memcpy(&sz, data, 4);
+		if (sz < 0 || 4 + (size_t)sz * (sizeof(int) + sizeof(Vector3)) > size)
+			return false;
+
+		const char* entry = data + 4;
+		outDiff.reserve(sz);
+
+		int idx;
+		Vector3 v;
+		for (int i = 0; i < sz; i++) {
+			memcpy(&idx, entry, sizeof(int));
+			memcpy(&v, entry + sizeof(int), sizeof(Vector3));
+			v.clampEpsilon();
+			outDiff.emplace(idx, v);
+			entry += sizeof(int) + sizeof(Vector3);
 		}
 
-		dataDiffs[dataName] = move(diffs);
+		return true;
+	}
+}
+
+bool OSDataFile::Read(const std::string& fileName) {
+	MappedFile file(fileName);
+	if (!file.IsOpen())
+		return false;
+
+	std::vector<std::pair<std::string, size_t>> offsets;
+	if (!IndexOSD(file.Data(), file.Size(), version, offsets))
+		return false;
+
+	dataCount = offsets.size();
+	for (auto &offset : offsets) {
+		std::unordered_map<ushort, Vector3> diffs;
+		DecodeOSDBlock(file.Data(), offset.second, diffs);
+		dataDiffs[offset.first] = move(diffs);
+	}
+
+	return true;
+}
+
+bool OSDataFile::ReadDataDiffs(const std::string& fileName, Index& index, const std::vector<std::string>& dataNames, std::map<std::string, std::unordered_map<ushort, Vector3>>& outDiffs) {
+	MappedFile file(fileName);
+	if (!file.IsOpen())
+		return false;
+
+	if (index.offsets.empty() || index.fileSize != file.Size()) {
+		uint fileVersion;
+		std::vector<std::pair<std::string, size_t>> offsets;
+		if (!IndexOSD(file.Data(), file.Size(), fileVersion, offsets))
+			return false;
+
+		// Later blocks of the same name replace earlier ones
+		index.offsets.clear();
+		for (auto &offset : offsets)
+			index.offsets[offset.first] = offset.second;
+
+		index.fileSize = file.Size();
+	}
+
+	for (auto &dataName : dataNames) {
+		auto offset = index.offsets.find(dataName);
+		if (offset == index.offsets.end())
+			continue;
+
+		std::unordered_map<ushort, Vector3>& diffs = outDiffs[dataName];
+		diffs.clear();
+		DecodeOSDBlock(file.Data(), offset->second, diffs);
 	}
 
 	return true;
@@ -96,7 +196,7 @@ std::unordered_map<ushort, Vector3>* OSDataFile::GetDataDiff(const std::string&
 	return nullptr;
 }
 
-void OSDataFile::SetDataDiff(const std::string& dataName, std::unordered_map<ushort, Vector3>& inDataDiff) {
+void OSDataFile::SetDataDiff(const std::string& dataName, const std::unordered_map<ushort, Vector3>& inDataDiff) {
 	auto it = dataDiffs.find(dataName);
 	if (it != dataDiffs.end())
 		dataDiffs.erase(dataName);
@@ -106,68 +206,357 @@ void OSDataFile::SetDataDiff(const std::string& dataName, std::unordered_map<ush
 }
 
 
-int DiffDataSets::LoadSet(const std::string& name, const std::string& target, std::unordered_map<ushort, Vector3>& inDiffData) {
-	if (namedSet.find(name) != namedSet.end())
-		namedSet.erase(name);
 
-	namedSet[name] = inDiffData;
-	dataTargets[name] = target;
+PackedDiff::PackedDiff(const std::unordered_map<ushort, Vector3>& diff) {
+	indices.reserve(diff.size());
+	for (auto &d : diff)
+		indices.push_back(d.first);
 
-	return 0;
+	std::sort(indices.begin(), indices.end());
+
+	// Dense storage once the set covers at least half of the vertices up to its highest index
+	int vertCount = indices.empty() ? 0 : indices.back() + 1;
+	dense = !indices.empty() && indices.size() * 2 >= vertCount;
+
+	int valueCount = dense ? vertCount : indices.size();
+	x.resize(valueCount, 0.0f);
+	y.resize(valueCount, 0.0f);
+	z.resize(valueCount, 0.0f);
+
+	for (int i = 0; i < indices.size(); i++) {
+		const Vector3& v = diff.at(indices[i]);
+		int slot = dense ? indices[i] : i;
+		x[slot] = v.x;
+		y[slot] = v.y;
+		z[slot] = v.z;
+	}
 }
 
-int DiffDataSets::LoadSet(const std::string& name, const std::string& target, const std::string& fromFile) {
-	std::ifstream inFile(fromFile, std::ios_base::binary);
-	if (!inFile)
-		return 1;
+void PackedDiff::ApplyDiff(float percent, std::vector<Vector3>& inOutResult) const {
+	int maxidx = inOutResult.size();
+	Vector3* result = inOutResult.data();
+
+	if (dense) {
+		int count = std::min(maxidx, (int)x.size());
+		for (int i = 0; i < count; i++) {
+			result[i].x += x[i] * percent;
+			result[i].y += y[i] * percent;
+			result[i].z += z[i] * percent;
+		}
+		return;
+	}
+
+	for (int i = 0; i < indices.size(); i++) {
+		int idx = indices[i];
+		if (idx >= maxidx)
+			break;
+
+		result[idx].x += x[i] * percent;
+		result[idx].y += y[i] * percent;
+		result[idx].z += z[i] * percent;
+	}
+}
+
+void PackedDiff::ApplyUVDiff(float percent, std::vector<Vector2>& inOutResult) const {
+	int maxidx = inOutResult.size();
+	Vector2* result = inOutResult.data();
+
+	if (dense) {
+		int count = std::min(maxidx, (int)x.size());
+		for (int i = 0; i < count; i++) {
+			result[i].u += x[i] * percent;
+			result[i].v += y[i] * percent;
+		}
+		return;
+	}
+
+	for (int i = 0; i < indices.size(); i++) {
+		int idx = indices[i];
+		if (idx >= maxidx)
+			break;
+
+		result[idx].u += x[i] * percent;
+		result[idx].v += y[i] * percent;
+	}
+}
+
+void PackedDiff::ApplyClamp(std::vector<Vector3>& inOutResult) const {
+	int maxidx = inOutResult.size();
+	for (int i = 0; i < indices.size(); i++) {
+		int idx = indices[i];
+		if (idx >= maxidx)
+			break;
+
+		int slot = dense ? idx : i;
+		inOutResult[idx].x = x[slot];
+		inOutResult[idx].y = y[slot];
+		inOutResult[idx].z = z[slot];
+	}
+}
+
+void PackedDiff::GetIndices(std::vector<ushort>& outIndices, float threshold) const {
+	for (int i = 0; i < indices.size(); i++) {
+		int slot = dense ? indices[i] : i;
+		if (fabs(x[slot]) > threshold ||
+			fabs(y[slot]) > threshold ||
+			fabs(z[slot]) > threshold) {
+			outIndices.push_back(indices[i]);
+		}
+	}
+}
+
+void PackedDiff::GetDiff(std::unordered_map<ushort, Vector3>& outDiff) const {
+	outDiff.reserve(outDiff.size() + indices.size());
+	for (int i = 0; i < indices.size(); i++) {
+		int slot = dense ? indices[i] : i;
+		outDiff[indices[i]] = Vector3(x[slot], y[slot], z[slot]);
+	}
+}
+
+
+DiffDataCache& DiffDataCache::Get() {
+	static DiffDataCache cache;
+	return cache;
+}
+
+std::string DiffDataCache::CanonicalPath(const std::string& fileName) {
+	std::string path;
+	path.reserve(fileName.size());
+
+	for (auto &c : fileName) {
+		char pc = c;
+		if (pc == '/')
+			pc = '\\';
+
+		// Collapse repeated separators that result from joining paths
+		if (pc == '\\' && !path.empty() && path.back() == '\\' && path.size() > 1)
+			continue;
+
+#ifdef _WIN32
+		pc = tolower(pc);
+#endif
+		path.push_back(pc);
+	}
+
+	return path;
+}
+
+bool DiffDataCache::DecodeSets(DiffFileData& fileData, const std::vector<std::string>& dataNames) {
+	std::vector<std::string> decodeNames;
+	for (auto &dataName : dataNames)
+		if (fileData.packedDiffs.find(dataName) == fileData.packedDiffs.end() && fileData.missingDiffs.find(dataName) == fileData.missingDiffs.end())
+			decodeNames.push_back(dataName);
+
+	if (decodeNames.empty())
+		return true;
+
+	std::map<std::string, std::unordered_map<ushort, Vector3>> decoded;
+	const std::string& fileName = fileData.fileName;
+	std::string ext = fileName.size() >= 4 ? fileName.substr(fileName.size() - 4) : "";
+	if (StrNICmp(ext.c_str(), ".bsd", 4) == 0) {
+		MappedFile file(fileName);
+		if (!file.IsOpen())
+			return false;
+
+		if (!DecodeBSD(file.Data(), file.Size(), decoded[""]))
+			return false;
+	}
+	else {
+		if (!OSDataFile::ReadDataDiffs(fileName, fileData.osdIndex, decodeNames, decoded))
+			return false;
+	}
+
+	for (auto &dataName : decodeNames) {
+		auto diff = decoded.find(dataName);
+		if (diff == decoded.end()) {
+			fileData.missingDiffs.insert(dataName);
+			continue;
+		}
+
+		fileData.packedDiffs.emplace(dataName, PackedDiff(diff->second));
+	}
+
+	return true;
+}
+
+std::shared_ptr<DiffFileData> DiffDataCache::GetFile(const std::string& fileName) {
+	long long modifiedTime = 0;
+	long long fileSize = 0;
+	if (!MappedFile::FileStamp(fileName, modifiedTime, fileSize))
+		return nullptr;
+
+	std::string key = CanonicalPath(fileName);
+
+	std::lock_guard<std::mutex> lock(cacheLock);
+	auto cached = files[key].lock();
+	if (cached && cached->modifiedTime == modifiedTime && cached->fileSize == fileSize)
+		return cached;
+
+	// Drop slots of files that aren't in use anymore
+	for (auto it = files.begin(); it != files.end();) {
+		if (it->second.expired() && it->first != key)
+			it = files.erase(it);
+		else
+			++it;
+	}
+
+	// Sets of a changed file stay valid for their current users, new requests get a fresh entry
+	auto fileData = std::make_shared<DiffFileData>();
+	fileData->fileName = fileName;
+	fileData->modifiedTime = modifiedTime;
+	fileData->fileSize = fileSize;
+	files[key] = fileData;
+	return fileData;
+}
+
+bool DiffDataCache::GetSets(const std::string& fileName, const std::vector<std::string>& dataNames, std::map<std::string, CachedDiffSet>& outSets) {
+	auto fileData = GetFile(fileName);
+	if (!fileData)
+		return false;
+
+	// Decoding only blocks other requests for the same file
+	std::lock_guard<std::mutex> lock(fileData->decodeLock);
+	if (!DecodeSets(*fileData, dataNames))
+		return false;
+
+	for (auto &dataName : dataNames) {
+		auto packed = fileData->packedDiffs.find(dataName);
+		if (packed == fileData->packedDiffs.end())
+			continue;
+
+		// Aliasing constructor, the sets keep the whole file entry alive
+		outSets[dataName] = CachedDiffSet(fileData, &packed->second);
+	}
+
+	return true;
+}
+
+
+const std::unordered_map<ushort, Vector3>* DiffDataSets::FindSet(const std::string& name) {
+	auto it = namedSet.find(name);
+	if (it != namedSet.end())
+		return &it->second;
+
+	auto sit = sharedSet.find(name);
+	if (sit == sharedSet.end())
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(copyLock);
+	auto eit = expandedSet.find(name);
+	if (eit != expandedSet.end())
+		return &eit->second;
+
+	auto& expanded = expandedSet[name];
+	sit->second->GetDiff(expanded);
+	return &expanded;
+}
+
+const PackedDiff* DiffDataSets::FindPacked(const std::string& name) {
+	auto sit = sharedSet.find(name);
+	if (sit != sharedSet.end())
+		return sit->second.get();
+
+	auto nit = namedSet.find(name);
+	if (nit == namedSet.end())
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(copyLock);
+	auto it = packedSet.find(name);
+	if (it != packedSet.end())
+		return it->second.get();
 
-	int sz;
-	inFile.read((char*)&sz, 4);
+	auto packed = std::make_shared<const PackedDiff>(nit->second);
+	packedSet[name] = packed;
+	return packed.get();
+}
 
-	std::unordered_map<ushort, Vector3> data;
-	data.reserve(sz);
+std::unordered_map<ushort, Vector3>& DiffDataSets::EditSet(const std::string& name) {
+	packedSet.erase(name);
+	revision++;
 
-	int idx;
-	Vector3 v;
-	for (int i = 0; i < sz; i++) {
-		inFile.read((char*)&idx, sizeof(int));
-		inFile.read((char*)&v, sizeof(Vector3));
-		v.clampEpsilon();
-		data.emplace(idx, v);
+	auto sit = sharedSet.find(name);
+	if (sit != sharedSet.end()) {
+		auto eit = expandedSet.find(name);
+		if (eit != expandedSet.end()) {
+			namedSet[name] = std::move(eit->second);
+			expandedSet.erase(eit);
+		}
+		else
+			sit->second->GetDiff(namedSet[name]);
+
+		sharedSet.erase(sit);
 	}
 
-	inFile.close();
+	return namedSet[name];
+}
 
+int DiffDataSets::LoadSet(const std::string& name, const std::string& target, const std::unordered_map<ushort, Vector3>& inDiffData) {
 	if (namedSet.find(name) != namedSet.end())
 		namedSet.erase(name);
 
-	namedSet.emplace(name, move(data));
+	sharedSet.erase(name);
+	packedSet.erase(name);
+	expandedSet.erase(name);
+	namedSet[name] = inDiffData;
+	dataTargets[name] = target;
+	revision++;
+
+	return 0;
+}
+
+int DiffDataSets::LoadSet(const std::string& name, const std::string& target, std::shared_ptr<const PackedDiff> sharedData) {
+	if (!sharedData)
+		return 1;
+
+	namedSet.erase(name);
+	packedSet.erase(name);
+	expandedSet.erase(name);
+	sharedSet[name] = std::move(sharedData);
+
 	dataTargets[name] = target;
+	revision++;
 
 	return 0;
 }
 
+int DiffDataSets::LoadSet(const std::string& name, const std::string& target, const std::string& fromFile) {
+	std::map<std::string, CachedDiffSet> sets;
+	if (!DiffDataCache::Get().GetSets(fromFile, { "" }, sets))
+		return 1;
+
+	auto set = sets.find("");
+	if (set == sets.end())
+		return 1;
+
+	return LoadSet(name, target, set->second);
+}
+
 bool DiffDataSets::LoadData(const std::map<std::string, std::map<std::string, std::string>>& osdNames) {
 	for (auto &osd : osdNames) {
-		OSDataFile osdFile;
-		if (!osdFile.Read(osd.first))
+		std::vector<std::string> dataNames;
+		for (auto &dataName : osd.second)
+			dataNames.push_back(dataName.first);
+
+		std::map<std::string, CachedDiffSet> sets;
+		if (!DiffDataCache::Get().GetSets(osd.first, dataNames, sets))
 			return false;
 
-		for (auto &dataNames : osd.second) {
-			auto diff = osdFile.GetDataDiff(dataNames.first);
-			if (diff)
-				LoadSet(dataNames.first, dataNames.second, *diff);
-		}
+		for (auto &set : sets)
+			LoadSet(set.first, osd.second.at(set.first), set.second);
 	}
 
 	return true;
 }
 
 int DiffDataSets::SaveSet(const std::string& name, const std::string& target, const std::string& toFile) {
-	std::unordered_map<ushort, Vector3>* data = &namedSet[name];
 	if (!TargetMatch(name, target))
 		return 2;
 
+	const std::unordered_map<ushort, Vector3>* data = FindSet(name);
+	std::unordered_map<ushort, Vector3> empty;
+	if (!data)
+		data = &empty;
+
 	std::ofstream outFile(toFile, std::ios_base::binary);
 	if (!outFile)
 		return 1;
@@ -175,7 +564,8 @@ int DiffDataSets::SaveSet(const std::string& name, const std::string& target, co
 	int sz = data->size();
 	outFile.write((char*)&sz, sizeof(int));
 	for (auto resultIt = data->begin(); resultIt != data->end(); ++resultIt) {
-		outFile.write((char*)&resultIt->first, sizeof(int));
+		int idx = resultIt->first;
+		outFile.write((char*)&idx, sizeof(int));
 		outFile.write((char*)&resultIt->second, sizeof(Vector3));
 	}
 	return 0;
@@ -185,11 +575,14 @@ bool DiffDataSets::SaveData(const std::map<std::string, std::map<std::string, st
 	for (auto &osd : osdNames) {
 		OSDataFile osdFile;
 		for (auto &dataNames : osd.second) {
-			std::unordered_map<ushort, Vector3>* data = &namedSet[dataNames.first];
 			if (!TargetMatch(dataNames.first, dataNames.second))
 				continue;
 
-			osdFile.SetDataDiff(dataNames.first, *data);
+			const std::unordered_map<ushort, Vector3>* data = FindSet(dataNames.first);
+			if (data)
+				osdFile.SetDataDiff(dataNames.first, *data);
+			else
+				osdFile.SetDataDiff(dataNames.first, std::unordered_map<ushort, Vector3>());
 		}
 
 		if (!osdFile.Write(osd.first))
@@ -200,12 +593,24 @@ bool DiffDataSets::SaveData(const std::map<std::string, std::map<std::string, st
 }
 
 void DiffDataSets::RenameSet(const std::string& oldName, const std::string& newName) {
+	packedSet.erase(oldName);
+	packedSet.erase(newName);
+	expandedSet.erase(oldName);
+	expandedSet.erase(newName);
+	revision++;
+
 	if (namedSet.find(oldName) != namedSet.end()) {
 		namedSet.emplace(newName, namedSet[oldName]);
 		namedSet.erase(oldName);
 		dataTargets[newName] = dataTargets[oldName];
 		dataTargets.erase(oldName);
 	}
+	else if (sharedSet.find(oldName) != sharedSet.end()) {
+		sharedSet.emplace(newName, sharedSet[oldName]);
+		sharedSet.erase(oldName);
+		dataTargets[newName] = dataTargets[oldName];
+		dataTargets.erase(oldName);
+	}
 }
 
 void DiffDataSets::DeepRename(const std::string& oldName, const std::string& newName) {
@@ -221,6 +626,10 @@ void DiffDataSets::DeepRename(const std::string& oldName, const std::string& new
 			dt.second = newName;
 		}
 	}
+	packedSet.clear();
+	expandedSet.clear();
+	revision++;
+
 	for (int i = 0; i < oldTargets.size(); i++) {
 		std::string ot = oldTargets[i];
 		std::string nt = newTargets[i];
@@ -232,11 +641,17 @@ void DiffDataSets::DeepRename(const std::string& oldName, const std::string& new
 			namedSet[nt] = move(namedSet[ot]);
 			namedSet.erase(ot);
 		}
+		if (sharedSet.find(ot) != sharedSet.end()) {
+			sharedSet[nt] = move(sharedSet[ot]);
+			sharedSet.erase(ot);
+		}
 	}
 }
 
 void DiffDataSets::AddEmptySet(const std::string& name, const std::string& target) {
-	if (namedSet.find(name) == namedSet.end()) {
+	if (namedSet.find(name) == namedSet.end() && sharedSet.find(name) == sharedSet.end()) {
+		packedSet.erase(name);
+		revision++;
 		std::unordered_map<ushort, Vector3> data;
 		namedSet[name] = data;
 		dataTargets[name] = target;
@@ -244,42 +659,46 @@ void DiffDataSets::AddEmptySet(const std::string& name, const std::string& targe
 }
 
 void DiffDataSets::UpdateDiff(const std::string& name, const std::string& target, ushort index, Vector3 &newdiff) {
-	std::unordered_map<ushort, Vector3>* data = &namedSet[name];
 	if (!TargetMatch(name, target))
 		return;
 
+	std::unordered_map<ushort, Vector3>* data = &EditSet(name);
 	(*data)[index] = newdiff;
 }
 
-void DiffDataSets::SumDiff(const std::string& name, const std::string& target, ushort index, Vector3 &newdiff) {
-	std::unordered_map<ushort, Vector3>* data = &namedSet[name];
+void DiffDataSets::SumDiff(const std::string& name, const std::string& target, ushort index, const Vector3 &newdiff) {
 	if (!TargetMatch(name, target))
 		return;
 
+	std::unordered_map<ushort, Vector3>* data = &EditSet(name);
 	Vector3 v = (*data)[index];
 	v += newdiff;
 	(*data)[index] = v;
 }
 
 void DiffDataSets::ScaleDiff(const std::string& name, const std::string& target, float scalevalue) {
-	std::unordered_map<ushort, Vector3>* data = &namedSet[name];
-
 	if (!TargetMatch(name, target))
 		return;
 
+	std::unordered_map<ushort, Vector3>* data = &EditSet(name);
 	for (auto resultIt = data->begin(); resultIt != data->end(); ++resultIt)
 		resultIt->second *= scalevalue;
 }
 
 void DiffDataSets::OffsetDiff(const std::string& name, const std::string& target, Vector3 &offset) {
-	std::unordered_map<ushort, Vector3>* data = &namedSet[name];
 	if (!TargetMatch(name, target))
 		return;
 
+	std::unordered_map<ushort, Vector3>* data = &EditSet(name);
 	for (auto resultIt = data->begin(); resultIt != data->end(); ++resultIt)
 		resultIt->second += offset;
 }
 
+void DiffDataSets::PackSets() {
+	for (auto &set : namedSet)
+		FindPacked(set.first);
+}
+
 void DiffDataSets::ApplyUVDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector2>* inOutResult) {
 	if (percent == 0)
 		return;
@@ -287,16 +706,9 @@ void DiffDataSets::ApplyUVDiff(const std::string& set, const std::string& target
 	if (!TargetMatch(set, target))
 		return;
 
-	int maxidx = (*inOutResult).size();
-	std::unordered_map<ushort, Vector3>* data = &namedSet[set];
-
-	for (auto resultIt = data->begin(); resultIt != data->end(); ++resultIt) {
-		if (resultIt->first >= maxidx)
-			continue;
-
-		(*inOutResult)[resultIt->first].u += resultIt->second.x * percent;
-		(*inOutResult)[resultIt->first].v += resultIt->second.y * percent;
-	}
+	const PackedDiff* packed = FindPacked(set);
+	if (packed)
+		packed->ApplyUVDiff(percent, *inOutResult);
 }
 
 void DiffDataSets::ApplyDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector3>* inOutResult) {
@@ -306,55 +718,33 @@ void DiffDataSets::ApplyDiff(const std::string& set, const std::string& target,
 	if (!TargetMatch(set, target))
 		return;
 
-	int maxidx = (*inOutResult).size();
-	std::unordered_map<ushort, Vector3>* data = &namedSet[set];
-
-	for (auto resultIt = data->begin(); resultIt != data->end(); ++resultIt) {
-		if (resultIt->first >= maxidx)
-			continue;
-
-		(*inOutResult)[resultIt->first].x += resultIt->second.x * percent;
-		(*inOutResult)[resultIt->first].y += resultIt->second.y * percent;
-		(*inOutResult)[resultIt->first].z += resultIt->second.z * percent;
-	}
+	const PackedDiff* packed = FindPacked(set);
+	if (packed)
+		packed->ApplyDiff(percent, *inOutResult);
 }
 
 void DiffDataSets::ApplyClamp(const std::string& set, const std::string& target, std::vector<Vector3>* inOutResult) {
 	if (!TargetMatch(set, target))
 		return;
 
-	int maxidx = (*inOutResult).size();
-	std::unordered_map<ushort, Vector3>* data = &namedSet[set];
-
-	for (auto resultIt = data->begin(); resultIt != data->end(); ++resultIt) {
-		if (resultIt->first >= maxidx)
-			continue;
-
-		(*inOutResult)[resultIt->first].x = resultIt->second.x;
-		(*inOutResult)[resultIt->first].y = resultIt->second.y;
-		(*inOutResult)[resultIt->first].z = resultIt->second.z;
-	}
+	const PackedDiff* packed = FindPacked(set);
+	if (packed)
+		packed->ApplyClamp(*inOutResult);
 }
 
-std::unordered_map<ushort, Vector3>* DiffDataSets::GetDiffSet(const std::string& targetDataName) {
-	if (namedSet.find(targetDataName) == namedSet.end())
-		return nullptr;
-
-	return &namedSet[targetDataName];
+const std::unordered_map<ushort, Vector3>* DiffDataSets::GetDiffSet(const std::string& targetDataName) {
+	return FindSet(targetDataName);
 }
 
 void DiffDataSets::GetDiffIndices(const std::string& set, const std::string& target, std::vector<ushort>& outIndices, float threshold) {
 	if (!TargetMatch(set, target))
 		return;
 
-	std::unordered_map<ushort, Vector3>* data = &namedSet[set];
-	for (auto resultIt = data->begin(); resultIt != data->end(); ++resultIt) {
-		if (fabs(resultIt->second.x) > threshold ||
-			fabs(resultIt->second.y) > threshold ||
-			fabs(resultIt->second.z) > threshold) {
-			outIndices.push_back(resultIt->first);
-		}
-	}
+	const PackedDiff* packed = FindPacked(set);
+	if (!packed)
+		return;
+
+	packed->GetIndices(outIndices, threshold);
 
 	std::sort(outIndices.begin(), outIndices.end());
 	outIndices.erase(std::unique(outIndices.begin(), outIndices.end()), outIndices.end());
@@ -364,39 +754,40 @@ void DiffDataSets::DeleteVerts(const std::string& target, const std::vector<usho
 	if (indices.empty())
 		return;
 
-	ushort highestRemoved = indices.back();
-	std::vector<int> indexCollapse(highestRemoved + 1, 0);
+	IndexCollapse indexCollapse(indices);
 
-	int remCount = 0;
-	for (int i = 0, j = 0; i < indexCollapse.size(); i++) {
-		if (j < indices.size() && indices[j] == i) {	// Found one to remove
-			indexCollapse[i] = -1;						// Flag delete
-			remCount++;
-			j++;
-		}
-		else
-			indexCollapse[i] = remCount;
-	}
+	// Shared sets of the target get their own copy first
+	std::vector<std::string> sharedNames;
+	for (auto &data : sharedSet)
+		if (TargetMatch(data.first, target))
+			sharedNames.push_back(data.first);
+
+	for (auto &name : sharedNames)
+		EditSet(name);
+
+	packedSet.clear();
+	revision++;
 
 	for (auto &data : namedSet) {
 		if (TargetMatch(data.first, target)) {
-			std::unordered_map<ushort, Vector3> indexCopy;
+			std::unordered_map<ushort, Vector3> diff;
+			diff.reserve(data.second.size());
 			for (auto &d : data.second) {
-				if (d.first > highestRemoved)
-					indexCopy.emplace(d.first - remCount, d.second);
-				else if (indexCollapse[d.first] != -1)
-					indexCopy.emplace(d.first - indexCollapse[d.first], d.second);
+				int index = indexCollapse[d.first];
+				if (index != -1)
+					diff.emplace(index, d.second);
 			}
 
-			data.second.clear();
-			data.second.reserve(indexCopy.size());
-			for (auto &copy : indexCopy)
-				data.second[copy.first] = std::move(copy.second);
+			data.second.swap(diff);
 		}
 	}
 }
 
 void DiffDataSets::ClearSet(const std::string& name) {
 	namedSet.erase(name);
+	sharedSet.erase(name);
+	packedSet.erase(name);
+	expandedSet.erase(name);
 	dataTargets.erase(name);
+	revision++;
 }
@@ -9,7 +9,10 @@ See the included LICENSE file
 #include "../NIF/utils/Object3d.h"
 
 #include <map>
+#include <set>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
 
 class OSDataFile {
 	uint header;
@@ -18,24 +21,116 @@ class OSDataFile {
 	std::map<std::string, std::unordered_map<ushort, Vector3>> dataDiffs;
 
 public:
+	// Offsets of the data blocks of an OSD file by name, so later reads of the same file don't have to walk it again.
+	struct Index {
+		size_t fileSize = 0;
+		std::unordered_map<std::string, size_t> offsets;
+	};
+
 	OSDataFile();
 	~OSDataFile();
 
 	bool Read(const std::string& fileName);
 	bool Write(const std::string& fileName);
 
+	// Maps the file and decodes only the requested data names into outDiffs. Names that aren't part of the file are skipped.
+	// The index is built in one pass on the first read and reused afterwards, it's rebuilt if the file size doesn't match.
+	static bool ReadDataDiffs(const std::string& fileName, Index& index, const std::vector<std::string>& dataNames, std::map<std::string, std::unordered_map<ushort, Vector3>>& outDiffs);
+
 	std::map<std::string, std::unordered_map<ushort, Vector3>> GetDataDiffs();
 	std::unordered_map<ushort, Vector3>* GetDataDiff(const std::string& dataName);
-	void SetDataDiff(const std::string& dataName, std::unordered_map<ushort, Vector3>& inDataDiff);
+	void SetDataDiff(const std::string& dataName, const std::unordered_map<ushort, Vector3>& inDataDiff);
+};
+
+// Structure-of-arrays copy of a diff set sorted by vertex index, so applying it is a linear pass without hash lookups.
+// Sets covering most of the mesh are stored densely and applied as one contiguous loop over all vertices.
+class PackedDiff {
+	std::vector<ushort> indices;	// Sorted vertex indices of the set
+	std::vector<float> x;			// Offsets per entry of indices, or per vertex if dense
+	std::vector<float> y;
+	std::vector<float> z;
+	bool dense = false;
+
+public:
+	PackedDiff() {}
+	PackedDiff(const std::unordered_map<ushort, Vector3>& diff);
+
+	void ApplyDiff(float percent, std::vector<Vector3>& inOutResult) const;
+	void ApplyUVDiff(float percent, std::vector<Vector2>& inOutResult) const;
+	void ApplyClamp(std::vector<Vector3>& inOutResult) const;
+	void GetIndices(std::vector<ushort>& outIndices, float threshold) const;
+
+	// Unpacks the set again, the sorted indices keep every entry of the original set
+	void GetDiff(std::unordered_map<ushort, Vector3>& outDiff) const;
+};
+
+// Sets decoded from an OSD or BSD file so far. BSD files hold a single set stored with an empty name.
+// Sets are only decoded when first requested and never change afterwards. They're only kept packed,
+// users that need the map form unpack their own copy.
+struct DiffFileData {
+	std::string fileName;
+	long long modifiedTime = 0;		// 100 ns units, see MappedFile::FileStamp
+	long long fileSize = 0;
+
+	std::mutex decodeLock;
+	OSDataFile::Index osdIndex;		// Block offsets of an OSD file, built on the first decode
+	std::map<std::string, PackedDiff> packedDiffs;
+	std::set<std::string> missingDiffs;		// Requested names that the file doesn't contain
+};
+
+// Read-only set owned by the DiffDataCache, keeps its file cached while referenced.
+typedef std::shared_ptr<const PackedDiff> CachedDiffSet;
+
+// Process-wide cache of diff data files, keyed by canonical path and validated by modification time and size.
+// Entries are only weakly referenced, they are freed as soon as nobody holds one of their sets anymore.
+class DiffDataCache {
+	std::mutex cacheLock;
+	std::unordered_map<std::string, std::weak_ptr<DiffFileData>> files;
+
+	static bool DecodeSets(DiffFileData& fileData, const std::vector<std::string>& dataNames);
+
+public:
+	static DiffDataCache& Get();
+
+	// Cache key of a file, slashes unified and case folded on Windows
+	static std::string CanonicalPath(const std::string& fileName);
+
+	// Returns the cache entry of the file without decoding anything, a new one if the file changed on disk.
+	std::shared_ptr<DiffFileData> GetFile(const std::string& fileName);
+
+	// Gets read-only views of the named sets, decoding those that weren't requested before. Returns false if the file can't be read.
+	bool GetSets(const std::string& fileName, const std::vector<std::string>& dataNames, std::map<std::string, CachedDiffSet>& outSets);
 };
 
 class DiffDataSets {
 	std::map<std::string, std::unordered_map<ushort, Vector3>> namedSet;
+	std::map<std::string, std::shared_ptr<const PackedDiff>> sharedSet;	// Read-only sets of the DiffDataCache
+	std::map<std::string, std::shared_ptr<const PackedDiff>> packedSet;	// Packed copies of named sets used for applying, dropped on modification
+	std::map<std::string, std::unordered_map<ushort, Vector3>> expandedSet;	// Unpacked copies of shared sets, only made on request
 	std::map<std::string, std::string> dataTargets;
+	uint revision = 0;					// Changes with every modification of the sets
+
+	// Guards the copies that reading functions create on demand, reading can happen from several threads at once
+	std::mutex copyLock;
+
+	// Returns the map form of a set, unpacking a shared set the first time.
+	const std::unordered_map<ushort, Vector3>* FindSet(const std::string& name);
+
+	// Returns the packed form of a set, packing a named set the first time.
+	const PackedDiff* FindPacked(const std::string& name);
+
+	// Returns a set for modification, copying shared data the first time.
+	std::unordered_map<ushort, Vector3>& EditSet(const std::string& name);
 
 public:
+	// Lets cached results built from the sets detect that they are outdated.
+	uint Revision() const {
+		return revision;
+	}
+
 	inline bool TargetMatch(const std::string& set, const std::string& target);
-	int LoadSet(const std::string& name, const std::string& target, std::unordered_map<ushort, Vector3>& inDiffData);
+	int LoadSet(const std::string& name, const std::string& target, const std::unordered_map<ushort, Vector3>& inDiffData);
+	int LoadSet(const std::string& name, const std::string& target, std::shared_ptr<const PackedDiff> sharedData);
 	int LoadSet(const std::string& name, const std::string& target, const std::string& fromFile);
 	int SaveSet(const std::string& name, const std::string& target, const std::string& toFile);
 	bool LoadData(const std::map<std::string, std::map<std::string, std::string>>& osdNames);
@@ -44,13 +139,17 @@ public:
 	void DeepRename(const std::string& oldName, const std::string& newName);
 	void AddEmptySet(const std::string& name, const std::string& target);
 	void UpdateDiff(const std::string& name, const std::string& target, ushort index, Vector3& newdiff);
-	void SumDiff(const std::string& name, const std::string& target, ushort index, Vector3& newdiff);
+	void SumDiff(const std::string& name, const std::string& target, ushort index, const Vector3& newdiff);
 	void ScaleDiff(const std::string& name, const std::string& target, float scalevalue);
 	void OffsetDiff(const std::string& name, const std::string& target, Vector3 &offset);
+	// Packs all sets that weren't applied yet, so applying them later doesn't need to.
+	// Reading functions may be called from several threads at once as long as the sets aren't modified.
+	void PackSets();
+
 	void ApplyDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector3>* inOutResult);
 	void ApplyUVDiff(const std::string& set, const std::string& target, float percent, std::vector<Vector2>* inOutResult);
 	void ApplyClamp(const std::string& set, const std::string& target, std::vector<Vector3>* inOutResult);
-	std::unordered_map<ushort, Vector3>* GetDiffSet(const std::string& targetDataName);
+	const std::unordered_map<ushort, Vector3>* GetDiffSet(const std::string& targetDataName);
 	void GetDiffIndices(const std::string& set, const std::string& target, std::vector<ushort>& outIndices, float threshold = 0.0f);
 
 	void DeleteVerts(const std::string& target, const std::vector<ushort>& indices);
@@ -59,19 +158,24 @@ public:
 		if (!TargetMatch(set, target))
 			return;
 
+		sharedSet.erase(set);
+		packedSet.erase(set);
+		expandedSet.erase(set);
 		namedSet[set].clear();
+		revision++;
 	}
 
 
 	void ZeroVertDiff(const std::string& set, Vector3* vColorMask) {
-		for (auto &ns : namedSet[set]) {
+		auto& data = EditSet(set);
+		for (auto &ns : data) {
 			float f = vColorMask[ns.first].x;
 			if (f == 1.0f)
 				continue;
 			else if (f == 0.0f)
-				namedSet[set][ns.first] *= 0.0f;
+				ns.second *= 0.0f;
 			else
-				namedSet[set][ns.first] *= f;
+				ns.second *= f;
 		}
 	}
 
@@ -81,18 +185,19 @@ public:
 		if (!TargetMatch(set, target))
 			return;
 
+		auto& data = EditSet(set);
 		std::vector<ushort> v;
 		if (vertSet) {
 			v = (*vertSet);
 		}
 		else {
-			for (auto &diff : namedSet[set])
+			for (auto &diff : data)
 				v.push_back(diff.first);
 		}
 
 		for (auto &i : v) {
-			auto d = namedSet[set].find(i);
-			if (d == namedSet[set].end())
+			auto d = data.find(i);
+			if (d == data.end())
 				continue;
 
 			float f = 0.0f;
@@ -106,16 +211,20 @@ public:
 				continue;
 
 			if (f == 0.0f) {
-				namedSet[set].erase(i);
+				data.erase(d);
 				continue;
 			}
-			namedSet[set][i] *= f;
+			d->second *= f;
 		}
 	}
 
 	void Clear() {
 		namedSet.clear();
+		sharedSet.clear();
+		packedSet.clear();
+		expandedSet.clear();
 		dataTargets.clear();
+		revision++;
 	}
 };
 
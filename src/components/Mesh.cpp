@@ -192,6 +192,7 @@ void mesh::ScaleVertices(const Vector3& center, const float& factor) {
 	for (int i = 0; i < nVerts; i++)
 		verts[i] = center + (verts[i] - center) * factor;
 
+	ResetWeldVerts();
 	CreateBVH();
 	queueUpdate[UpdateType::Position] = true;
 }
@@ -330,73 +331,118 @@ void mesh::SetSmoothThreshold(float degrees) {
 	smoothThresh = degrees * DEG2RAD;
 }
 
-void mesh::SmoothNormals(const std::set<int>& vertices) {
-	// Zero old normals
-	for (int i = 0; i < nVerts; i++) {
-		if (!vertices.empty() && vertices.find(i) == vertices.end())
-			continue;
+void mesh::BuildWeldVerts() {
+	if (weldVertsBuilt)
+		return;
 
-		Vector3& pn = norms[i];
-		pn.Zero();
-	}
+	weldVertsBuilt = true;
+	if (!weldVerts.empty())
+		return;
 
-	// Face normals
-	Vector3 tn;
-	for (int t = 0; t < nTris; t++) {
-		bool bn1 = (vertices.empty() || vertices.find(tris[t].p1) != vertices.end());
-		bool bn2 = (vertices.empty() || vertices.find(tris[t].p2) != vertices.end());
-		bool bn3 = (vertices.empty() || vertices.find(tris[t].p3) != vertices.end());
+	// Virtually weld verts across UV seams
+	kd_matcher matcher(verts.get(), nVerts);
+	for (int i = 0; i < matcher.matches.size(); i++) {
+		std::pair<Vector3*, int>& a = matcher.matches[i].first;
+		std::pair<Vector3*, int>& b = matcher.matches[i].second;
+		weldVerts[a.second].push_back(b.second);
+		weldVerts[b.second].push_back(a.second);
+	}
+}
 
-		// None of the three normals should change
-		if (!bn1 && !bn2 && !bn3)
-			continue;
+void mesh::ResetWeldVerts() {
+	weldVerts.clear();
+	weldVertsBuilt = false;
+}
 
-		tris[t].trinormal(verts.get(), &tn);
-		Vector3& pn1 = norms[tris[t].p1];
-		Vector3& pn2 = norms[tris[t].p2];
-		Vector3& pn3 = norms[tris[t].p3];
+void mesh::SmoothNormals(const std::set<int>& vertices) {
+	if (smoothSeamNormals)
+		BuildWeldVerts();
+
+	if (vertices.empty()) {
+		FacetNormals();
+
+		// Smooth normals
+		if (smoothSeamNormals && !weldVerts.empty()) {
+			std::vector<Vector3> faceNorms(norms.get(), norms.get() + nVerts);
+			for (auto &wv : weldVerts) {
+				Vector3& pn = norms[wv.first];
+				for (auto &w : wv.second)
+					if (faceNorms[wv.first].angle(faceNorms[w]) < smoothThresh)
+						pn += faceNorms[w];
+
+				pn.Normalize();
+			}
+		}
 
-		if (bn1)
-			pn1 += tn;
-		if (bn2)
-			pn2 += tn;
-		if (bn3)
-			pn3 += tn;
+		queueUpdate[UpdateType::Normals] = true;
+		return;
 	}
 
-	for (int i = 0; i < nVerts; i++) {
-		Vector3& pn = norms[i];
-		pn.Normalize();
+	if (!vertTris)
+		BuildTriAdjacency();
+
+	// Moving a vertex changes the normals of every vertex that shares a triangle with it
+	std::unordered_set<int> affected;
+	for (auto &v : vertices) {
+		for (auto &t : vertTris[v]) {
+			affected.insert(tris[t].p1);
+			affected.insert(tris[t].p2);
+			affected.insert(tris[t].p3);
+		}
 	}
 
-	// Smooth normals
-	if (smoothSeamNormals) {
-		kd_matcher matcher(verts.get(), nVerts);
-		for (int i = 0; i < matcher.matches.size(); i++) {
-			std::pair<Vector3*, int>& a = matcher.matches[i].first;
-			std::pair<Vector3*, int>& b = matcher.matches[i].second;
+	if (smoothSeamNormals && !weldVerts.empty()) {
+		std::vector<int> welded;
+		for (auto &v : affected) {
+			auto wv = weldVerts.find(v);
+			if (wv != weldVerts.end())
+				welded.insert(welded.end(), wv->second.begin(), wv->second.end());
+		}
+		affected.insert(welded.begin(), welded.end());
+	}
 
-			if (!vertices.empty()) {
-				if (vertices.find(a.second) == vertices.end() ||
-					vertices.find(b.second) == vertices.end())
-					continue;
-			}
+	// Face normals, only summing the triangles around each affected vertex
+	std::unordered_map<int, Vector3> faceNorms;
+	auto faceNormal = [&](int v) -> const Vector3& {
+		auto fn = faceNorms.find(v);
+		if (fn != faceNorms.end())
+			return fn->second;
 
-			Vector3& an = norms[a.second];
-			Vector3& bn = norms[b.second];
-			if (an.angle(bn) < smoothThresh) {
-				Vector3 anT = an;
-				an += bn;
-				bn += anT;
+		Vector3 pn;
+		Vector3 tn;
+		for (auto &t : vertTris[v]) {
+			tris[t].trinormal(verts.get(), &tn);
+			pn += tn;
+		}
+		pn.Normalize();
+		return faceNorms.emplace(v, pn).first->second;
+	};
+
+	std::vector<std::pair<int, Vector3>> results;
+	results.reserve(affected.size());
+	for (auto &v : affected) {
+		const Vector3& fn = faceNormal(v);
+		Vector3 pn = fn;
+
+		// Smooth normals
+		if (smoothSeamNormals) {
+			auto wv = weldVerts.find(v);
+			if (wv != weldVerts.end()) {
+				for (auto &w : wv->second) {
+					const Vector3& wn = faceNormal(w);
+					if (fn.angle(wn) < smoothThresh)
+						pn += wn;
+				}
+				pn.Normalize();
 			}
 		}
 
-		for (int i = 0; i < nVerts; i++) {
-			Vector3& pn = norms[i];
-			pn.Normalize();
-		}
+		results.emplace_back(v, pn);
 	}
 
+	for (auto &r : results)
+		norms[r.first] = r.second;
+
 	queueUpdate[UpdateType::Normals] = true;
 }
 
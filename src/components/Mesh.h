@@ -77,6 +77,7 @@ public:
 	std::unique_ptr<std::vector<int>[]> vertTris;				// Map of triangles for which each vert is a member.
 	std::unique_ptr<std::vector<int>[]> vertEdges;				// Map of edges for which each vert is a member.
 	std::unordered_map<int, std::vector<int>> weldVerts;		// Verts that are duplicated for UVs but are in the same position.
+	bool weldVertsBuilt = false;
 
 	RenderMode rendermode = RenderMode::Normal;
 	bool modelSpace = false;
@@ -108,6 +109,8 @@ public:
 
 	void BuildTriAdjacency();	// Triangle adjacency optional to reduce overhead when it's not needed.
 	void BuildEdgeList();		// Edge list optional to reduce overhead when it's not needed.
+	void BuildWeldVerts();		// Weld map is built once per topology and reused by every normal update.
+	void ResetWeldVerts();		// Call after moving vertices apart or replacing them, the weld map is rebuilt on the next use.
 
 	void CreateBuffers();
 	void UpdateBuffers();
@@ -120,10 +123,17 @@ public:
 	float GetSmoothThreshold();
 
 	void FacetNormals();
+
+	// Recalculates the normals of the mesh or only the ones changed by moving the specified vertices.
+	// Adjacency and weld map are built on first use, call BuildTriAdjacency and BuildWeldVerts
+	// beforehand when updating normals of the same mesh from several threads.
 	void SmoothNormals(const std::set<int>& vertices = std::set<int>());
 	static void SmoothNormalsStatic(mesh* m) {
 		m->SmoothNormals();
 	}
+	static void SmoothNormalsStaticSet(mesh* m, const std::set<int>& vertices) {
+		m->SmoothNormals(vertices);
+	}
 	static void SmoothNormalsStaticArray(mesh* m, int* vertices, int nVertices) {
 		std::set<int> verts;
 		for (int i = 0; i < nVertices; i++)
@@ -0,0 +1,116 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "MorphEvaluator.h"
+
+#include <cstring>
+
+namespace {
+	template<typename T>
+	bool SameData(const std::vector<T>& a, const std::vector<T>& b) {
+		if (a.size() != b.size())
+			return false;
+
+		return a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+	}
+
+	// Applies the strength changes between the applied and the wanted strengths and stores the wanted ones as applied.
+	template<typename ApplyFunc>
+	bool ApplyChanges(std::map<std::string, float>& applied, const std::map<std::string, float>& wanted, ApplyFunc apply) {
+		bool changed = false;
+		auto a = applied.begin();
+		for (auto &w : wanted) {
+			while (a != applied.end() && a->first < w.first) {
+				apply(a->first, -a->second);
+				changed = true;
+				++a;
+			}
+
+			float old = 0.0f;
+			if (a != applied.end() && a->first == w.first) {
+				old = a->second;
+				++a;
+			}
+
+			if (w.second != old) {
+				apply(w.first, w.second - old);
+				changed = true;
+			}
+		}
+
+		for (; a != applied.end(); ++a) {
+			apply(a->first, -a->second);
+			changed = true;
+		}
+
+		applied = wanted;
+		return changed;
+	}
+}
+
+void MorphEvaluator::Evaluate(const std::string& shapeName, DiffDataSets& data, const std::string& target,
+	const std::vector<Vector3>& baseVerts, const std::vector<Vector2>* baseUVs, const std::vector<MorphTerm>& terms,
+	std::vector<Vector3>& outVerts, std::vector<Vector2>* outUVs) {
+
+	ShapeMorphs& morphs = shapes[shapeName];
+
+	bool recompute = morphs.data != &data
+		|| morphs.revision != data.Revision()
+		|| morphs.target != target
+		|| morphs.incrementalUpdates >= maxIncrementalUpdates
+		|| !SameData(morphs.baseVerts, baseVerts)
+		|| (baseUVs && !SameData(morphs.baseUVs, *baseUVs));
+
+	if (recompute) {
+		morphs.data = &data;
+		morphs.revision = data.Revision();
+		morphs.target = target;
+		morphs.baseVerts = baseVerts;
+		morphs.verts = baseVerts;
+		if (baseUVs) {
+			morphs.baseUVs = *baseUVs;
+			morphs.uvs = *baseUVs;
+		}
+		else {
+			// The UVs aren't reset to their base here, so the next evaluation with UVs has to start over
+			morphs.baseUVs.clear();
+			morphs.uvs.clear();
+		}
+		morphs.appliedVerts.clear();
+		morphs.appliedUVs.clear();
+		morphs.incrementalUpdates = 0;
+	}
+
+	// Sum up strengths per data set, zero strengths don't have to be applied
+	std::map<std::string, float> wantedVerts;
+	std::map<std::string, float> wantedUVs;
+	for (auto &term : terms) {
+		if (term.value == 0.0f)
+			continue;
+
+		if (term.uv)
+			wantedUVs[term.dataName] += term.value;
+		else
+			wantedVerts[term.dataName] += term.value;
+	}
+
+	bool changed = ApplyChanges(morphs.appliedVerts, wantedVerts, [&](const std::string& dataName, float delta) {
+		data.ApplyDiff(dataName, target, delta, &morphs.verts);
+	});
+
+	if (baseUVs) {
+		changed |= ApplyChanges(morphs.appliedUVs, wantedUVs, [&](const std::string& dataName, float delta) {
+			data.ApplyUVDiff(dataName, target, delta, &morphs.uvs);
+		});
+	}
+
+	if (changed && !recompute)
+		morphs.incrementalUpdates++;
+
+	outVerts = morphs.verts;
+	if (outUVs && baseUVs)
+		(*outUVs) = morphs.uvs;
+}
@@ -0,0 +1,63 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "DiffData.h"
+
+// A diff set applied to a shape with the given strength.
+struct MorphTerm {
+	std::string dataName;
+	float value = 0.0f;
+	bool uv = false;
+
+	MorphTerm(const std::string& inDataName, float inValue, bool inUV = false)
+		: dataName(inDataName), value(inValue), uv(inUV) {}
+};
+
+// Keeps the morphed vertices and UVs of shapes between evaluations.
+// Each evaluation only applies the difference of the strengths that changed since the last one,
+// so moving a single slider costs one diff set instead of the whole slider stack.
+// Results are recomputed from the base data if the base data or the diff data sets changed.
+// Clamps and zaps aren't linear and have to be applied to the results by the caller.
+class MorphEvaluator {
+	struct ShapeMorphs {
+		const DiffDataSets* data = nullptr;
+		uint revision = 0;
+		std::string target;
+
+		std::vector<Vector3> baseVerts;
+		std::vector<Vector2> baseUVs;
+		std::vector<Vector3> verts;
+		std::vector<Vector2> uvs;
+
+		// Strengths currently applied per data name
+		std::map<std::string, float> appliedVerts;
+		std::map<std::string, float> appliedUVs;
+
+		int incrementalUpdates = 0;
+	};
+
+	std::unordered_map<std::string, ShapeMorphs> shapes;
+
+	// Applying differences accumulates rounding errors, results are recomputed after this many updates
+	static const int maxIncrementalUpdates = 500;
+
+public:
+	// Writes the base data of the shape with all terms applied to outVerts and outUVs.
+	// Shapes are cached by name, target is the shape target of the data sets.
+	void Evaluate(const std::string& shapeName, DiffDataSets& data, const std::string& target,
+		const std::vector<Vector3>& baseVerts, const std::vector<Vector2>* baseUVs, const std::vector<MorphTerm>& terms,
+		std::vector<Vector3>& outVerts, std::vector<Vector2>* outUVs = nullptr);
+
+	void ClearShape(const std::string& shapeName) {
+		shapes.erase(shapeName);
+	}
+
+	void Clear() {
+		shapes.clear();
+	}
+};
@@ -0,0 +1,535 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "OutfitBuilder.h"
+#include "../utils/PlatformUtil.h"
+
+#include <wx/filename.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+
+#include <atomic>
+#include <mutex>
+#include <regex>
+#include <set>
+
+OutfitBuilder::OutfitBuilder(SliderManager& sliders, const BuildOptions& buildOptions) : options(buildOptions), sliderManager(sliders) {
+	pool = std::make_unique<ThreadPool>(buildOptions.threadCount);
+}
+
+void OutfitBuilder::SetOptions(const BuildOptions& buildOptions) {
+	if (buildOptions.threadCount != options.threadCount)
+		pool = std::make_unique<ThreadPool>(buildOptions.threadCount);
+
+	options = buildOptions;
+}
+
+float OutfitBuilder::GetSliderValue(const SliderData& slider, bool big) {
+	float value;
+	std::vector<Slider>* sliders;
+	if (big) {
+		value = sliderManager.GetBigPresetValue(options.presetName, slider.name, slider.defBigValue / 100.0f);
+		sliders = &sliderManager.slidersBig;
+	}
+	else {
+		value = sliderManager.GetSmallPresetValue(options.presetName, slider.name, slider.defSmallValue / 100.0f);
+		sliders = &sliderManager.slidersSmall;
+	}
+
+	// Values changed in the UI take precedence over the preset
+	for (auto &s : *sliders) {
+		if (s.name == slider.name && s.changed && !s.clamp) {
+			value = s.value;
+			break;
+		}
+	}
+
+	return value;
+}
+
+bool OutfitBuilder::BuildOutfit(const std::string& outfit, const std::string& sourceFile, std::string& outError) {
+	/* Load set */
+	SliderSet currentSet;
+
+	SliderSetFile sliderDoc;
+	sliderDoc.Open(sourceFile);
+	if (!sliderDoc.fail()) {
+		if (sliderDoc.GetSet(outfit, currentSet)) {
+			outError = _("Unable to get slider set from file: ") + sourceFile;
+			return false;
+		}
+	}
+	else {
+		outError = _("Unable to open slider set file: ") + sourceFile;
+		return false;
+	}
+
+	currentSet.SetBaseDataPath(options.shapeDataPath);
+	return BuildSet(currentSet, outError);
+}
+
+bool OutfitBuilder::BuildSet(SliderSet& currentSet, std::string& outError) {
+	DiffDataSets currentDiffs;
+
+	// ALT key
+	if (options.clean) {
+		bool genWeights = currentSet.GenWeights();
+
+		std::string removePath = options.dataPath + currentSet.GetOutputFilePath();
+		std::string removeHigh = removePath + ".nif";
+		if (genWeights)
+			removeHigh = removePath + "_1.nif";
+
+		if (wxFileName::FileExists(removeHigh))
+			wxRemoveFile(removeHigh);
+
+		if (!genWeights)
+			return true;
+
+		std::string removeLow = removePath + "_0.nif";
+		if (wxFileName::FileExists(removeLow))
+			wxRemoveFile(removeLow);
+
+		return true;
+	}
+
+	/* Load input NIFs */
+	NifFile nifBig;
+	NifFile nifSmall;
+	if (nifBig.Load(currentSet.GetInputFileName())) {
+		outError = _("Unable to load input nif: ") + currentSet.GetInputFileName();
+		return false;
+	}
+
+	// Both weights start out identical, clone the parsed file instead of reading it again
+	if (currentSet.GenWeights())
+		nifSmall.CopyFrom(nifBig);
+
+	currentSet.LoadSetDiffData(currentDiffs);
+
+	/* Shape the NIF files */
+	bool genWeights = currentSet.GenWeights();
+
+	// Slider values are the same for all shapes
+	std::vector<float> valuesBig(currentSet.size());
+	std::vector<float> valuesSmall(currentSet.size());
+	for (int s = 0; s < currentSet.size(); s++) {
+		valuesBig[s] = GetSliderValue(currentSet[s], true);
+		if (genWeights)
+			valuesSmall[s] = GetSliderValue(currentSet[s], false);
+
+		if (currentSet[s].bInvert) {
+			valuesBig[s] = 1.0f - valuesBig[s];
+			valuesSmall[s] = 1.0f - valuesSmall[s];
+		}
+	}
+
+	currentDiffs.PackSets();
+
+	auto applySliders = [&](ShapeTask& task) {
+		std::vector<int> clamps;
+
+		for (int s = 0; s < currentSet.size(); s++) {
+			std::string dn = currentSet[s].TargetDataName(task.target);
+			if (dn.empty())
+				continue;
+
+			if (currentSet[s].bClamp)  {
+				clamps.push_back(s);
+				continue;
+			}
+
+			if (currentSet[s].bZap && !currentSet[s].bUV) {
+				if (valuesBig[s] > 0.0f)
+					currentDiffs.GetDiffIndices(dn, task.target, task.zapBig);
+				continue;
+			}
+
+			if (currentSet[s].bUV)
+				currentDiffs.ApplyUVDiff(dn, task.target, valuesBig[s], &task.uvsBig);
+			else
+				currentDiffs.ApplyDiff(dn, task.target, valuesBig[s], &task.vertsBig);
+
+			if (genWeights) {
+				if (currentSet[s].bUV)
+					currentDiffs.ApplyUVDiff(dn, task.target, valuesSmall[s], &task.uvsSmall);
+				else
+					currentDiffs.ApplyDiff(dn, task.target, valuesSmall[s], &task.vertsSmall);
+			}
+		}
+
+		for (auto &c : clamps) {
+			std::string dn = currentSet[c].TargetDataName(task.target);
+			if (currentSet[c].defBigValue > 0)
+				currentDiffs.ApplyClamp(dn, task.target, &task.vertsBig);
+
+			if (genWeights)
+				if (currentSet[c].defSmallValue > 0)
+					currentDiffs.ApplyClamp(dn, task.target, &task.vertsSmall);
+		}
+
+		// Both weights use the zapped vertices of the big preset
+		task.zapSmall = task.zapBig;
+	};
+
+	std::vector<ShapeTask> shapeTasks;
+	ShapeNifs(currentSet, nifBig, genWeights ? &nifSmall : nullptr, applySliders, shapeTasks);
+
+	std::unordered_map<std::string, std::vector<ushort>> zapIdxAll;
+	for (auto &task : shapeTasks)
+		if (task.valid)
+			zapIdxAll[task.shapeName] = task.zapBig;
+
+	currentDiffs.Clear();
+
+	/* Create directory for the outfit */
+	wxString dir = ToOSSlashes(options.dataPath + currentSet.GetOutputPath());
+	bool success = wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+	if (!success) {
+		outError = _("Unable to create destination directory: ") + dir.ToStdString();
+		return false;
+	}
+
+	std::string outFileNameSmall = options.dataPath + currentSet.GetOutputFilePath();
+	std::string outFileNameBig = outFileNameSmall;
+
+	/* Add TRI path for in-game morphs */
+	bool triEnd = options.tri;
+	if (triEnd) {
+		std::string triPath = currentSet.GetOutputFilePath() + ".tri";
+		std::string triPathTrimmed = triPath;
+		triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex("/+|\\\\+"), "\\");									// Replace multiple slashes or forward slashes with one backslash
+		triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex(".*meshes\\\\", std::regex_constants::icase), "");	// Remove everything before and including the meshes path
+
+		if (!WriteMorphTRI(outFileNameBig, currentSet, nifBig, zapIdxAll))
+			wxLogError("Failed to create TRI file to '%s'!", triPath);
+
+		if (!options.triOnRoot) {
+			for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it) {
+				std::string triShapeLink = it->second;
+				if (triEnd && nifBig.GetVertCountForShape(triShapeLink) > 0) {
+					nifBig.AddStringExtraData(triShapeLink, "BODYTRI", triPathTrimmed);
+					if (currentSet.GenWeights())
+						nifSmall.AddStringExtraData(triShapeLink, "BODYTRI", triPathTrimmed);
+					triEnd = false;
+				}
+			}
+		}
+		else {
+			nifBig.AddStringExtraData(nifBig.GetNodeName(nifBig.GetRootNodeID()), "BODYTRI", triPathTrimmed, true);
+			if (currentSet.GenWeights())
+				nifSmall.AddStringExtraData(nifBig.GetNodeName(nifBig.GetRootNodeID()), "BODYTRI", triPathTrimmed, true);
+		}
+
+		// Set all shapes to dynamic/mutable
+		for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it) {
+			nifBig.SetShapeDynamic(it->second);
+			if (currentSet.GenWeights())
+				nifSmall.SetShapeDynamic(it->second);
+		}
+	}
+	else {
+		std::string triPath = outFileNameBig + ".tri";
+		if (wxFileName::FileExists(triPath))
+			wxRemoveFile(triPath);
+	}
+
+	/* Set filenames for the outfit */
+	if (currentSet.GenWeights()) {
+		outFileNameSmall += "_0.nif";
+		outFileNameBig += "_1.nif";
+
+		if (nifBig.Save(outFileNameBig, false)) {
+			outError = _("Unable to save nif file: ") + outFileNameBig;
+			return false;
+		}
+
+		if (nifSmall.Save(outFileNameSmall, false)) {
+			outError = _("Unable to save nif file: ") + outFileNameSmall;
+			return false;
+		}
+	}
+	else {
+		outFileNameBig += ".nif";
+
+		if (nifBig.Save(outFileNameBig, false)) {
+			outError = _("Unable to save nif file: ") + outFileNameBig;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void OutfitBuilder::ShapeNifs(SliderSet& currentSet, NifFile& nifBig, NifFile* nifSmall, const ShapeFunc& applySliders, std::vector<ShapeTask>& outTasks) {
+	outTasks.clear();
+	for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it) {
+		outTasks.emplace_back();
+		outTasks.back().target = it->first;
+		outTasks.back().shapeName = it->second;
+	}
+
+	// Only touches the blocks of its own shape
+	auto shapeTask = [&](ShapeTask& task) {
+		if (!nifBig.GetVertsForShape(task.shapeName, task.vertsBig))
+			return;
+
+		nifBig.GetUvsForShape(task.shapeName, task.uvsBig);
+
+		if (nifSmall) {
+			if (!nifSmall->GetVertsForShape(task.shapeName, task.vertsSmall))
+				return;
+
+			nifSmall->GetUvsForShape(task.shapeName, task.uvsSmall);
+		}
+
+		task.valid = true;
+		applySliders(task);
+
+		nifBig.SetVertsForShape(task.shapeName, task.vertsBig);
+		nifBig.SetUvsForShape(task.shapeName, task.uvsBig);
+		nifBig.CalcNormalsForShape(task.shapeName);
+		nifBig.CalcTangentsForShape(task.shapeName);
+
+		if (nifSmall) {
+			nifSmall->SetVertsForShape(task.shapeName, task.vertsSmall);
+			nifSmall->SetUvsForShape(task.shapeName, task.uvsSmall);
+			nifSmall->CalcNormalsForShape(task.shapeName);
+			nifSmall->CalcTangentsForShape(task.shapeName);
+		}
+	};
+
+	// Block holding the vertices of the shape, shapes can share their NiGeometryData
+	auto dataBlock = [](NifFile& nif, const std::string& shapeName) -> NiObject* {
+		NiShape* shape = nif.FindShapeByName(shapeName);
+		if (!shape)
+			return nullptr;
+
+		int dataRef = shape->GetDataRef();
+		if (dataRef != 0xFFFFFFFF)
+			return nif.GetHeader().GetBlock<NiObject>(dataRef);
+
+		return shape;
+	};
+
+	// Blocks are only compared and never accessed through these pointers, deleting zapped blocks between rounds doesn't matter
+	std::vector<std::pair<NiObject*, NiObject*>> taskBlocks(outTasks.size());
+	for (int i = 0; i < outTasks.size(); i++) {
+		taskBlocks[i].first = dataBlock(nifBig, outTasks[i].shapeName);
+		if (nifSmall)
+			taskBlocks[i].second = dataBlock(*nifSmall, outTasks[i].shapeName);
+	}
+
+	// Targets writing the same block have to see the results of the previous ones, they're shaped in later rounds
+	std::vector<bool> done(outTasks.size(), false);
+	int remaining = outTasks.size();
+	while (remaining > 0) {
+		std::vector<int> round;
+		std::set<NiObject*> roundBlocks;
+		for (int i = 0; i < outTasks.size(); i++) {
+			if (done[i])
+				continue;
+
+			NiObject* blockBig = taskBlocks[i].first;
+			NiObject* blockSmall = taskBlocks[i].second;
+			if ((blockBig && roundBlocks.count(blockBig)) || (blockSmall && roundBlocks.count(blockSmall)))
+				continue;
+
+			if (blockBig)
+				roundBlocks.insert(blockBig);
+			if (blockSmall)
+				roundBlocks.insert(blockSmall);
+
+			round.push_back(i);
+		}
+
+		pool->ParallelFor(round.size(), [&](int r) {
+			shapeTask(outTasks[round[r]]);
+		});
+
+		for (auto &i : round) {
+			ShapeTask& task = outTasks[i];
+			if (task.valid) {
+				nifBig.DeleteVertsForShape(task.shapeName, task.zapBig);
+				if (nifSmall)
+					nifSmall->DeleteVertsForShape(task.shapeName, task.zapSmall);
+			}
+
+			done[i] = true;
+		}
+
+		remaining -= round.size();
+	}
+}
+
+int OutfitBuilder::BuildList(const std::vector<std::string>& outfitList, const std::map<std::string, std::string>& outfitSources,
+	std::map<std::string, std::string>& failedOutfits, ProgressFunc progress) {
+
+	// Failure reasons are written to one slot per outfit and progress is counted atomically, so workers never wait on each other
+	std::vector<std::string> failReasons(outfitList.size());
+	std::atomic<int> startedCount(0);
+	std::atomic<int> lastStarted(0);
+
+	// Load all sets up front so that every slider set file is only parsed once
+	std::vector<SliderSet> outfitSets(outfitList.size());
+	std::vector<bool> setLoaded(outfitList.size(), false);
+	std::map<std::string, std::vector<int>> sourceOutfits;
+	for (int i = 0; i < outfitList.size(); i++) {
+		auto outfitSource = outfitSources.find(outfitList[i]);
+		if (outfitSource != outfitSources.end())
+			sourceOutfits[outfitSource->second].push_back(i);
+		else
+			failReasons[i] = _("No recorded outfit name source");
+	}
+
+	for (auto &source : sourceOutfits) {
+		SliderSetFile sliderDoc;
+		sliderDoc.Open(source.first);
+		for (auto &i : source.second) {
+			if (sliderDoc.fail()) {
+				failReasons[i] = _("Unable to open slider set file: ") + source.first;
+				continue;
+			}
+
+			if (sliderDoc.GetSet(outfitList[i], outfitSets[i])) {
+				failReasons[i] = _("Unable to get slider set from file: ") + source.first;
+				continue;
+			}
+
+			outfitSets[i].SetBaseDataPath(options.shapeDataPath);
+			setLoaded[i] = true;
+		}
+	}
+
+	// Count the outfits using each diff data file, the file is kept cached until the last of them is built
+	std::vector<std::vector<std::string>> outfitDiffFiles(outfitList.size());
+	std::map<std::string, int> diffFileUsers;
+	if (!options.clean) {
+		for (int i = 0; i < outfitList.size(); i++) {
+			if (!setLoaded[i])
+				continue;
+
+			outfitSets[i].GetDiffFileNames(outfitDiffFiles[i]);
+			for (auto &file : outfitDiffFiles[i])
+				diffFileUsers[DiffDataCache::CanonicalPath(file)]++;
+		}
+	}
+
+	std::mutex pinLock;
+	std::map<std::string, std::shared_ptr<DiffFileData>> pinnedFiles;
+
+	auto buildOutfit = [&](int outfitIndex) {
+		const std::string& outfit = outfitList[outfitIndex];
+
+		int count = ++startedCount;
+		lastStarted = outfitIndex;
+		wxLogMessage("Processing '%s' (%d of %d)...", outfit, count, outfitList.size());
+
+		if (!setLoaded[outfitIndex])
+			return;
+
+		for (auto &file : outfitDiffFiles[outfitIndex]) {
+			auto fileData = DiffDataCache::Get().GetFile(file);
+
+			std::lock_guard<std::mutex> lock(pinLock);
+			pinnedFiles.emplace(DiffDataCache::CanonicalPath(file), fileData);
+		}
+
+		std::string error;
+		if (!BuildSet(outfitSets[outfitIndex], error))
+			failReasons[outfitIndex] = error;
+
+		outfitSets[outfitIndex].Clear();
+
+		std::lock_guard<std::mutex> lock(pinLock);
+		for (auto &file : outfitDiffFiles[outfitIndex]) {
+			std::string key = DiffDataCache::CanonicalPath(file);
+			if (--diffFileUsers[key] <= 0)
+				pinnedFiles.erase(key);
+		}
+	};
+
+	TaskGroup buildTasks;
+	for (int i = 0; i < outfitList.size(); i++)
+		pool->Submit(buildTasks, [&buildOutfit, i]() { buildOutfit(i); });
+
+	// Only the calling thread reports progress and flushes the log
+	bool finished = false;
+	while (!finished) {
+		finished = pool->WaitFor(buildTasks, 100);
+
+		int count = startedCount;
+		if (progress && count > 0)
+			progress(count, outfitList.size(), outfitList[lastStarted]);
+
+		wxLog::FlushActive();
+	}
+
+	for (int i = 0; i < outfitList.size(); i++)
+		if (!failReasons[i].empty())
+			failedOutfits[outfitList[i]] = failReasons[i];
+
+	if (failedOutfits.size() > 0)
+		return 3;
+
+	return 0;
+}
+
+bool OutfitBuilder::WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices) {
+	DiffDataSets currentDiffs;
+	sliderSet.LoadSetDiffData(currentDiffs);
+
+	TriFile tri;
+	std::string triFilePath = triPath + ".tri";
+
+	for (auto shape = sliderSet.TargetShapesBegin(); shape != sliderSet.TargetShapesEnd(); ++shape) {
+		for (int s = 0; s < sliderSet.size(); s++) {
+			std::string dn = sliderSet[s].TargetDataName(shape->first);
+			std::string target = shape->first;
+			if (dn.empty())
+				continue;
+
+			if (!sliderSet[s].bUV && !sliderSet[s].bClamp && !sliderSet[s].bZap) {
+				MorphDataPtr morph = std::make_shared<MorphData>();
+				morph->name = sliderSet[s].name;
+
+				const std::vector<ushort>& shapeZapIndices = zapIndices[shape->second];
+
+				std::vector<Vector3> verts;
+				int shapeVertCount = nif.GetVertCountForShape(shape->second);
+				shapeVertCount += shapeZapIndices.size();
+				if (shapeVertCount > 0)
+					verts.resize(shapeVertCount);
+				else
+					continue;
+
+				currentDiffs.ApplyDiff(dn, target, 1.0f, &verts);
+
+				if (shapeZapIndices.size() > 0 && shapeZapIndices.back() >= verts.size())
+					continue;
+
+				int i = 0;
+				for (auto &v : verts) {
+					if (!v.IsZero(true))
+						morph->offsets.emplace(i, v);
+					i++;
+				}
+
+				if (morph->offsets.size() > 0)
+					tri.AddMorph(shape->second, morph);
+			}
+		}
+
+		// Zapped verts are removed from all morphs of the shape at once
+		tri.DeleteVerts(shape->second, zapIndices[shape->second]);
+	}
+
+	if (!tri.Write(triFilePath))
+		return false;
+
+	return true;
+}
@@ -0,0 +1,88 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "../NIF/NifFile.h"
+#include "../files/TriFile.h"
+#include "../utils/ThreadPool.h"
+#include "SliderManager.h"
+
+#include <functional>
+
+// Settings shared by all outfits of a batch build.
+struct BuildOptions {
+	std::string dataPath;			// Output root, either the game data path or a custom target directory
+	std::string shapeDataPath;		// Base path of the slider data
+	std::string presetName;			// Preset providing the slider values
+	bool clean = false;				// Remove the output files instead of building them
+	bool tri = false;				// Write TRI files for in-game morphs
+	bool triOnRoot = false;			// Add the BODYTRI extra data to the root node (FO4) instead of the first shape
+	int threadCount = 0;			// Worker threads, zero or less uses all hardware threads
+};
+
+// Geometry of one target shape while it is being shaped.
+struct ShapeTask {
+	std::string target;				// Target name of the slider data
+	std::string shapeName;			// Shape in the NIF files
+	bool valid = false;				// The shape was found and shaped
+
+	std::vector<Vector3> vertsBig;
+	std::vector<Vector3> vertsSmall;
+	std::vector<Vector2> uvsBig;
+	std::vector<Vector2> uvsSmall;
+
+	// Vertices deleted from the shape after shaping
+	std::vector<ushort> zapBig;
+	std::vector<ushort> zapSmall;
+};
+
+// Build pipeline that turns slider sets into output NIF and TRI files.
+// It only depends on the NIF library and the slider components and is used by both BodySlide and the headless builder.
+class OutfitBuilder {
+public:
+	// Called on the thread running BuildList with the number of started outfits and the latest one
+	typedef std::function<void(int count, int total, const std::string& outfit)> ProgressFunc;
+
+	// Applies the sliders to the vertices and UVs of a shape task and fills its zap indices.
+	// Called concurrently for different shapes, so it may only read shared data (see DiffDataSets::PackSets).
+	typedef std::function<void(ShapeTask& task)> ShapeFunc;
+
+private:
+	BuildOptions options;
+	SliderManager& sliderManager;
+
+	// Runs the outfits of a batch and the shapes of each outfit, shapes are nested tasks of their outfit.
+	// Kept across builds and only recreated when the thread count changes.
+	std::unique_ptr<ThreadPool> pool;
+
+	float GetSliderValue(const SliderData& slider, bool big);
+
+public:
+	OutfitBuilder(SliderManager& sliders, const BuildOptions& buildOptions);
+
+	// Replaces the options of the following builds, the thread pool is kept unless the thread count changed.
+	void SetOptions(const BuildOptions& buildOptions);
+
+	// Builds (or cleans) a single outfit of the slider set file. Returns false and sets the reason on failure.
+	bool BuildOutfit(const std::string& outfit, const std::string& sourceFile, std::string& outError);
+
+	// Builds (or cleans) an already loaded slider set.
+	bool BuildSet(SliderSet& currentSet, std::string& outError);
+
+	// Shapes all target shapes of the set in nifBig and nifSmall (if not null) and returns the tasks in the order of the targets.
+	// Each shape is read, shaped and gets its normals and tangents recalculated in a parallel task.
+	// Targets whose shapes write the same geometry data block are shaped one after another.
+	// Deleting the zapped vertices can remove blocks, so it's done serially once all tasks are done.
+	void ShapeNifs(SliderSet& currentSet, NifFile& nifBig, NifFile* nifSmall, const ShapeFunc& applySliders, std::vector<ShapeTask>& outTasks);
+
+	// Builds all listed outfits in parallel. Returns 0 on success and 3 if any outfit failed.
+	// Diff data files shared by several outfits are read once and released after the last outfit using them is done.
+	int BuildList(const std::vector<std::string>& outfitList, const std::map<std::string, std::string>& outfitSources,
+		std::map<std::string, std::string>& failedOutfits, ProgressFunc progress = nullptr);
+
+	static bool WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices);
+};
@@ -5,6 +5,7 @@ See the included LICENSE file
 */
 
 #include "SliderData.h"
+#include "../utils/PlatformUtil.h"
 
 #include <wx/dir.h>
 #include <wx/tokenzr.h>
@@ -39,12 +40,12 @@ int SliderData::LoadSliderData(XMLElement* element, bool genWeights) {
 
 	name = element->Attribute("name");
 	if (element->Attribute("invert"))
-		bInvert = (_strnicmp(element->Attribute("invert"), "true", 4) == 0);
+		bInvert = (StrNICmp(element->Attribute("invert"), "true", 4) == 0);
 	else
 		bInvert = false;
 
 	if (element->Attribute("uv"))
-		bUV = (_strnicmp(element->Attribute("uv"), "true", 4) == 0);
+		bUV = (StrNICmp(element->Attribute("uv"), "true", 4) == 0);
 	else
 		bUV = false;
 
@@ -61,22 +62,22 @@ int SliderData::LoadSliderData(XMLElement* element, bool genWeights) {
 	}
 
 	if (element->Attribute("hidden"))
-		bHidden = (_strnicmp(element->Attribute("hidden"), "true", 4) == 0);
+		bHidden = (StrNICmp(element->Attribute("hidden"), "true", 4) == 0);
 	else
 		bHidden = false;
 
 	if (element->Attribute("zap"))
-		bZap = (_strnicmp(element->Attribute("zap"), "true", 4) == 0);
+		bZap = (StrNICmp(element->Attribute("zap"), "true", 4) == 0);
 	else
 		bZap = false;
 
 	if (element->Attribute("uv"))
-		bUV = (_strnicmp(element->Attribute("uv"), "true", 4) == 0);
+		bUV = (StrNICmp(element->Attribute("uv"), "true", 4) == 0);
 	else
 		bUV = false;
 
 	if (element->Attribute("clamp"))
-		bClamp = (_strnicmp(element->Attribute("clamp"), "true", 4) == 0);
+		bClamp = (StrNICmp(element->Attribute("clamp"), "true", 4) == 0);
 	else
 		bClamp = false;
 
@@ -93,7 +94,7 @@ int SliderData::LoadSliderData(XMLElement* element, bool genWeights) {
 		tmpDataFile.targetName = datafile->Attribute("target");
 
 		if (datafile->Attribute("local"))
-			tmpDataFile.bLocal = (_strnicmp(datafile->Attribute("local"), "true", 4) == 0);
+			tmpDataFile.bLocal = (StrNICmp(datafile->Attribute("local"), "true", 4) == 0);
 		else
 			tmpDataFile.bLocal = false;
 
@@ -137,6 +137,22 @@ void SliderManager::SetClampSlider(const std::string& slider) {
 			slidersSmall[i].clamp = true;
 }
 
+Slider* SliderManager::GetSmallSlider(int bigIndex) {
+	if (bigIndex < 0 || bigIndex >= slidersBig.size())
+		return nullptr;
+
+	// Both lists are filled in the same order, only fall back to searching if they ever differ
+	const std::string& name = slidersBig[bigIndex].name;
+	if (bigIndex < slidersSmall.size() && slidersSmall[bigIndex].name == name)
+		return &slidersSmall[bigIndex];
+
+	for (auto &s : slidersSmall)
+		if (s.name == name)
+			return &s;
+
+	return nullptr;
+}
+
 void SliderManager::AddSliderLink(const std::string& slider, const std::string& dataSetName) {
 	for (int i = 0; i < slidersBig.size(); i++)
 		if (slidersBig[i].name == slider)
@@ -96,6 +96,9 @@ public:
 	void SetClampSlider(const std::string& slider);
 	void AddSliderLink(const std::string& slider, const std::string& dataSetName);
 
+	// Returns the low weight slider with the name of the high weight slider at the index, nullptr if there is none.
+	Slider* GetSmallSlider(int bigIndex);
+
 	float GetSlider(const std::string& slider, bool isSmall);
 	std::vector<std::string> GetSliderZapToggles(const std::string& slider);
 	void SetSlider(const std::string& slider, bool isSmall, float val);
@@ -6,6 +6,7 @@ See the included LICENSE file
 
 #include "../TinyXML-2/tinyxml2.h"
 #include "SliderPresets.h"
+#include "../utils/PlatformUtil.h"
 
 #include <wx/dir.h>
 
@@ -206,7 +207,7 @@ int PresetCollection::SavePreset(const std::string& filePath, const std::string&
 		presetElem = slidersNode->FirstChildElement("Preset");
 		while (presetElem) {
 			// Replace preset if found in file.
-			if (_stricmp(presetElem->Attribute("name"), presetName.c_str()) == 0) {
+			if (StrICmp(presetElem->Attribute("name"), presetName.c_str()) == 0) {
 				XMLElement* tmpElem = presetElem;
 				presetElem = presetElem->NextSiblingElement("Preset");
 				slidersNode->DeleteChild(tmpElem);
@@ -7,6 +7,7 @@ See the included LICENSE file
 #pragma once
 
 #include <map>
+#include <string>
 #include <vector>
 
 class SliderPreset {
@@ -5,6 +5,7 @@ See the included LICENSE file
 */
 
 #include "SliderSet.h"
+#include "../utils/PlatformUtil.h"
 
 SliderSet::SliderSet() {
 }
@@ -75,7 +76,7 @@ int SliderSet::LoadSliderSet(XMLElement* element) {
 		outputfile = tmpElement->GetText();
 		if (tmpElement->Attribute("GenWeights")) {
 			std::string gw = tmpElement->Attribute("GenWeights");
-			if (_strnicmp(gw.c_str(), "false", 5) == 0) {
+			if (StrNICmp(gw.c_str(), "false", 5) == 0) {
 				genWeights = false;
 			}
 		}
@@ -131,18 +132,43 @@ int SliderSet::LoadSliderSet(XMLElement* element) {
 	return 0;
 }
 
+std::string SliderSet::GetDiffDataPath(const DiffInfo& ddf) {
+	std::string fullFilePath = baseDataPath + "\\";
+	if (ddf.bLocal)
+		fullFilePath += datafolder + "\\";
+	else
+		fullFilePath += targetdatafolders[ddf.targetName] + "\\";
+
+	fullFilePath += ddf.fileName;
+	return ToOSSlashes(fullFilePath);
+}
+
+void SliderSet::GetDiffFileNames(std::vector<std::string>& outFileNames) {
+	for (auto &slider : sliders) {
+		for (auto &ddf : slider.dataFiles) {
+			std::string fullFilePath = GetDiffDataPath(ddf);
+
+			// OSD paths end with the data name inside of the file
+			if (ddf.fileName.compare(ddf.fileName.size() - 4, ddf.fileName.size(), ".bsd") != 0) {
+				int split = fullFilePath.find_last_of(PathSepChar);
+				if (split < 0)
+					continue;
+
+				fullFilePath = fullFilePath.substr(0, split);
+			}
+
+			if (find(outFileNames.begin(), outFileNames.end(), fullFilePath) == outFileNames.end())
+				outFileNames.push_back(fullFilePath);
+		}
+	}
+}
+
 void SliderSet::LoadSetDiffData(DiffDataSets& inDataStorage) {
 	std::map<std::string, std::map<std::string, std::string>> osdNames;
 
 	for (auto &slider : sliders) {
 		for (auto &ddf : slider.dataFiles) {
-			std::string fullFilePath = baseDataPath + "\\";
-			if (ddf.bLocal)
-				fullFilePath += datafolder + "\\";
-			else
-				fullFilePath += targetdatafolders[ddf.targetName] + "\\";
-
-			fullFilePath += ddf.fileName;
+			std::string fullFilePath = GetDiffDataPath(ddf);
 
 			// BSD format
 			if (ddf.fileName.compare(ddf.fileName.size() - 4, ddf.fileName.size(), ".bsd") == 0) {
@@ -151,7 +177,7 @@ void SliderSet::LoadSetDiffData(DiffDataSets& inDataStorage) {
 			// OSD format
 			else {
 				// Split file name to get file and data name in it
-				int split = fullFilePath.find_last_of('\\');
+				int split = fullFilePath.find_last_of(PathSepChar);
 				if (split < 0)
 					continue;
 
@@ -263,11 +289,11 @@ std::string SliderSet::GetInputFileName() {
 	o = baseDataPath + "\\";
 	o += datafolder + "\\";
 	o += inputfile;
-	return o;
+	return ToOSSlashes(o);
 }
 
 std::string SliderSet::GetOutputFilePath() {
-	return outputpath + "\\" + outputfile;
+	return ToOSSlashes(outputpath + "\\" + outputfile);
 }
 
 bool SliderSet::GenWeights() {
@@ -29,6 +29,8 @@ class SliderSet
 
 	SliderData Empty;
 
+	std::string GetDiffDataPath(const DiffInfo& ddf);
+
 public:
 	SliderSet();
 	SliderSet(XMLElement* sliderSetSource);
@@ -75,6 +77,9 @@ public:
 	int LoadSliderSet(XMLElement* sliderSetSource);
 	void LoadSetDiffData(DiffDataSets& inDataStorage);
 
+	// Gets the full paths of all BSD and OSD files the sliders of the set read their data from.
+	void GetDiffFileNames(std::vector<std::string>& outFileNames);
+
 	// Add an empty set.
 	int CreateSlider(const std::string& setName);
 
@@ -89,6 +89,7 @@ void TweakStroke::RestoreStartState(mesh* m) {
 	}
 
 	if (refBrush->Type() != TBT_MASK && refBrush->Type() != TBT_WEIGHT) {
+		m->ResetWeldVerts();
 		m->SmoothNormals();
 
 		if (startBVH[m] == endBVH[m]) {
@@ -115,6 +116,7 @@ void TweakStroke::RestoreEndState(mesh* m) {
 	}
 
 	if (refBrush->Type() != TBT_MASK && refBrush->Type() != TBT_WEIGHT) {
+		m->ResetWeldVerts();
 		m->SmoothNormals();
 
 		if (startBVH[m] == endBVH[m]) {
@@ -137,6 +139,12 @@ void TweakStroke::beginStroke(TweakPickInfo& pickInfo) {
 	for (auto &m : refMeshes) {
 		startBVH[m] = m->bvh;
 
+		// Normal updates of the stroke run asynchronously and share the adjacency of the mesh
+		if (!m->vertTris)
+			m->BuildTriAdjacency();
+		if (m->smoothSeamNormals)
+			m->BuildWeldVerts();
+
 		pts1[m] = (int*)malloc(m->nVerts * sizeof(int));
 		if (refBrush->isMirrored())
 			pts2[m] = (int*)malloc(m->nVerts * sizeof(int));
@@ -222,11 +230,12 @@ void TweakStroke::updateStroke(TweakPickInfo& pickInfo) {
 			}
 
 			if (refBrush->LiveNormals() && brushType != TBT_WEIGHT && brushType != TBT_MASK) {
-				auto pending1 = std::async(std::launch::async, mesh::SmoothNormalsStaticArray, m, pts1[m], nPts1);
-				normalUpdates.push_back(std::move(pending1));
+				// Both sides in one task, so mirrored points near the center aren't updated twice at the same time
+				std::set<int> points(pts1[m], pts1[m] + nPts1);
+				points.insert(pts2[m], pts2[m] + nPts2);
 
-				auto pending2 = async(std::launch::async, mesh::SmoothNormalsStaticArray, m, pts2[m], nPts2);
-				normalUpdates.push_back(std::move(pending2));
+				auto pending = std::async(std::launch::async, mesh::SmoothNormalsStaticSet, m, std::move(points));
+				normalUpdates.push_back(std::move(pending));
 			}
 		}
 	}
@@ -289,6 +298,10 @@ void TweakStroke::endStroke() {
 		pts2.clear();
 
 		endBVH[m] = m->bvh;
+
+		// Welded vertices may have moved apart during the stroke
+		if (refBrush->Type() != TBT_MASK && refBrush->Type() != TBT_WEIGHT)
+			m->ResetWeldVerts();
 	}
 }
 
@@ -11,6 +11,7 @@ See the included LICENSE file
 #include "../FSEngine/FSEngine.h"
 
 #include <wx/filename.h>
+#include <wx/file.h>
 #include <wx/log.h>
 
 ResourceLoader::ResourceLoader() {
@@ -32,9 +33,14 @@ GLuint ResourceLoader::LoadTexture(const std::string& inFileName, bool isCubeMap
 	wxString fileExt = fileName.GetExt().Lower();
 	std::string fileExtStr = std::string(fileExt.c_str());
 
+	// Largest width or height of the textures, larger mips are left out (0 loads all mips)
+	int maxSize = Config.GetIntValue("Rendering/TextureMaxSize");
+	if (maxSize < 0)
+		maxSize = 0;
+
 	// All textures (GLI)
 	if (!textureID && fileExtStr == "dds" || fileExtStr == "ktx")
-		textureID = GLI_load_texture(inFileName);
+		textureID = GLI_load_texture(inFileName, maxSize);
 
 	// Cubemap fallback (SOIL)
 	if (!textureID && isCubeMap)
@@ -54,26 +60,17 @@ GLuint ResourceLoader::LoadTexture(const std::string& inFileName, bool isCubeMap
 		wxString texFile = inFileName;
 		texFile.Replace(wxString(Config["GameDataPath"]).MakeLower(), "");
 		texFile.Replace("\\", "/");
-		for (FSArchiveFile *archive : FSManager::archiveList()) {
-			if (archive) {
-				if (archive->hasFile(texFile.ToStdString())) {
-					wxMemoryBuffer outData;
-					archive->fileContents(texFile.ToStdString(), outData);
-
-					if (!outData.IsEmpty()) {
-						data = std::move(outData);
-						break;
-					}
-				}
-			}
-		}
+		if (fileExtStr == "dds")
+			FSManager::textureContents(texFile.ToStdString(), data, maxSize);
+		else
+			FSManager::fileContents(texFile.ToStdString(), data);
 
 		if (!data.IsEmpty()) {
 			byte* texBuffer = static_cast<byte*>(data.GetData());
 
 			// All textures (GLI)
 			if (!textureID && fileExtStr == "dds" || fileExtStr == "ktx")
-				textureID = GLI_load_texture_from_memory((char*)texBuffer, data.GetDataLen());
+				textureID = GLI_load_texture_from_memory((char*)texBuffer, data.GetDataLen(), maxSize);
 
 			// Cubemap fallback (SOIL)
 			if (!textureID && isCubeMap)
@@ -281,22 +278,160 @@ GLuint ResourceLoader::GLI_create_texture(gli::texture& texture) {
 	return textureID;
 }
 
-GLuint ResourceLoader::GLI_load_texture(const std::string& fileName) {
-	gli::texture texture = gli::load(fileName);
+GLuint ResourceLoader::GLI_load_texture(const std::string& fileName, unsigned int maxSize) {
+	gli::texture texture;
+	std::vector<char> dds;
+
+	wxFile file;
+	if (maxSize > 0 && file.Open(fileName)) {
+		auto read = [&file](size_t offset, void* buffer, size_t size) {
+			return file.Seek(offset) != wxInvalidOffset && static_cast<size_t>(file.Read(buffer, size)) == size;
+		};
+
+		if (DDS_load_mips(read, file.Length(), maxSize, dds))
+			texture = gli::load(dds.data(), dds.size());
+	}
+
+	if (dds.empty())
+		texture = gli::load(fileName);
+
 	if (texture.empty())
 		return 0;
 
 	return GLI_create_texture(texture);
 }
 
-GLuint ResourceLoader::GLI_load_texture_from_memory(const char* buffer, size_t size) {
-	gli::texture texture = gli::load(buffer, size);
+GLuint ResourceLoader::GLI_load_texture_from_memory(const char* buffer, size_t size, unsigned int maxSize) {
+	gli::texture texture;
+	std::vector<char> dds;
+
+	auto read = [buffer, size](size_t offset, void* dst, size_t dstSize) {
+		if (offset > size || dstSize > size - offset)
+			return false;
+
+		memcpy(dst, buffer + offset, dstSize);
+		return true;
+	};
+
+	if (DDS_load_mips(read, size, maxSize, dds))
+		texture = gli::load(dds.data(), dds.size());
+	else
+		texture = gli::load(buffer, size);
+
 	if (texture.empty())
 		return 0;
 
 	return GLI_create_texture(texture);
 }
 
+bool ResourceLoader::DDS_load_mips(const DDSReader& read, size_t size, unsigned int maxSize, std::vector<char>& dds) {
+	if (maxSize == 0 || size < sizeof(gli::detail::FOURCC_DDS) + sizeof(gli::detail::dds_header))
+		return false;
+
+	char magic[sizeof(gli::detail::FOURCC_DDS)];
+	if (!read(0, magic, sizeof(magic)) || strncmp(magic, gli::detail::FOURCC_DDS, sizeof(magic)) != 0)
+		return false;
+
+	gli::detail::dds_header header;
+	if (!read(sizeof(magic), &header, sizeof(header)))
+		return false;
+
+	size_t offset = sizeof(magic) + sizeof(header);
+
+	gli::detail::dds_header10 header10;
+	bool hasHeader10 = (header.Format.flags & gli::dx::DDPF_FOURCC) && (header.Format.fourCC == gli::dx::D3DFMT_DX10 || header.Format.fourCC == gli::dx::D3DFMT_GLI1);
+	if (hasHeader10) {
+		if (size < offset + sizeof(header10) || !read(offset, &header10, sizeof(header10)))
+			return false;
+
+		offset += sizeof(header10);
+	}
+
+	// Slices of volume textures are stored within each mip, they're always loaded whole
+	if (header.Flags & gli::detail::DDSD_DEPTH || header.CubemapFlags & gli::detail::DDSCAPS2_VOLUME || header10.ResourceDimension == gli::detail::D3D10_RESOURCE_DIMENSION_TEXTURE3D)
+		return false;
+
+	size_t levels = (header.Flags & gli::detail::DDSD_MIPMAPCOUNT) ? header.MipMapLevels : 1;
+	auto levelWidth = [&header](size_t level) { return (header.Width >> level) > 0 ? header.Width >> level : 1; };
+	auto levelHeight = [&header](size_t level) { return (header.Height >> level) > 0 ? header.Height >> level : 1; };
+
+	size_t firstLevel = 0;
+	while (firstLevel + 1 < levels && (levelWidth(firstLevel) > maxSize || levelHeight(firstLevel) > maxSize))
+		firstLevel++;
+
+	if (firstLevel == 0)
+		return false;
+
+	// Same order of format detection as gli::load_dds
+	size_t blockSize = 0;
+	gli::ivec3 blockExtent(1);
+	if (header.Format.flags & (gli::dx::DDPF_RGB | gli::dx::DDPF_ALPHAPIXELS | gli::dx::DDPF_ALPHA | gli::dx::DDPF_YUV | gli::dx::DDPF_LUMINANCE) && header.Format.bpp != 0) {
+		blockSize = header.Format.bpp / 8;
+	}
+	else {
+		gli::dx dxTable;
+		gli::format texFormat = static_cast<gli::format>(gli::FORMAT_INVALID);
+		if (hasHeader10)
+			texFormat = dxTable.find(header.Format.fourCC, header10.Format);
+		else if (header.Format.flags & gli::dx::DDPF_FOURCC)
+			texFormat = dxTable.find(gli::detail::remap_four_cc(header.Format.fourCC));
+
+		if (texFormat == static_cast<gli::format>(gli::FORMAT_INVALID))
+			return false;
+
+		blockSize = gli::block_size(texFormat);
+		blockExtent = gli::block_extent(texFormat);
+	}
+
+	if (blockSize == 0)
+		return false;
+
+	auto levelPitch = [&](size_t level) { return (levelWidth(level) + blockExtent.x - 1) / blockExtent.x * blockSize; };
+
+	std::vector<size_t> levelSize(levels);
+	size_t chainSize = 0;
+	for (size_t level = 0; level < levels; level++) {
+		levelSize[level] = levelPitch(level) * ((levelHeight(level) + blockExtent.y - 1) / blockExtent.y);
+		chainSize += levelSize[level];
+	}
+
+	size_t skipSize = 0;
+	for (size_t level = 0; level < firstLevel; level++)
+		skipSize += levelSize[level];
+
+	size_t faces = 1;
+	if (header.CubemapFlags & gli::detail::DDSCAPS2_CUBEMAP)
+		faces = glm::bitCount(header.CubemapFlags & gli::detail::DDSCAPS2_CUBEMAP_ALLFACES);
+
+	size_t layers = hasHeader10 && header10.ArraySize > 1 ? header10.ArraySize : 1;
+	size_t chains = layers * faces;
+	if (size < offset + chains * chainSize)
+		return false;
+
+	// The header describes the remaining mips, the first one becomes the base level
+	header.Width = levelWidth(firstLevel);
+	header.Height = levelHeight(firstLevel);
+	header.MipMapLevels = static_cast<std::uint32_t>(levels - firstLevel);
+	header.Pitch = static_cast<std::uint32_t>(header.Flags & gli::detail::DDSD_LINEARSIZE ? levelSize[firstLevel] : levelPitch(firstLevel));
+
+	size_t keepSize = chainSize - skipSize;
+	dds.resize(offset + chains * keepSize);
+	memcpy(&dds[0], magic, sizeof(magic));
+	memcpy(&dds[sizeof(magic)], &header, sizeof(header));
+	if (hasHeader10)
+		memcpy(&dds[sizeof(magic) + sizeof(header)], &header10, sizeof(header10));
+
+	// Each face of each layer has its own mip chain, only the end of each chain is read
+	for (size_t chain = 0; chain < chains; chain++) {
+		if (!read(offset + chain * chainSize + skipSize, &dds[offset + chain * keepSize], keepSize)) {
+			dds.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
 GLMaterial* ResourceLoader::AddMaterial(const std::vector<std::string>& textureFiles, const std::string& vShaderFile, const std::string& fShaderFile) {
 	auto texFiles = textureFiles;
 	for (auto &f : texFiles)
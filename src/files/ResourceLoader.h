@@ -6,6 +6,7 @@ See the included LICENSE file
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -71,8 +72,13 @@ public:
 private:
 	static bool extChecked;
 	GLuint GLI_create_texture(gli::texture& texture);
-	GLuint GLI_load_texture(const std::string& fileName);
-	GLuint GLI_load_texture_from_memory(const char* buffer, size_t size);
+	GLuint GLI_load_texture(const std::string& fileName, unsigned int maxSize = 0);
+	GLuint GLI_load_texture_from_memory(const char* buffer, size_t size, unsigned int maxSize = 0);
+
+	// Reads a DDS texture through the reader, leaving out all mips larger than maxSize without reading them.
+	// Returns false if the texture has no mips to leave out or can't be trimmed, it's then loaded whole.
+	typedef std::function<bool(size_t offset, void* buffer, size_t size)> DDSReader;
+	static bool DDS_load_mips(const DDSReader& read, size_t size, unsigned int maxSize, std::vector<char>& dds);
 
 	// If N3983 gets accepted into a future C++ standard then
 	// we wouldn't have to explicitly define our own hash here.
@@ -192,6 +192,30 @@ void TriFile::DeleteMorphs(std::string shapeName) {
 			shape->second.clear();
 }
 
+void TriFile::DeleteVerts(std::string shapeName, const std::vector<ushort>& indices) {
+	if (indices.empty())
+		return;
+
+	auto shape = shapeMorphs.find(shapeName);
+	if (shape == shapeMorphs.end())
+		return;
+
+	IndexCollapse indexCollapse(indices);
+	for (auto &morph : shape->second) {
+		// Renumbering keeps the order, so offsets are appended at the end of the map
+		std::map<int, Vector3> offsets;
+		for (auto &o : morph->offsets) {
+			int index = indexCollapse[o.first];
+			if (index != -1)
+				offsets.emplace_hint(offsets.end(), index, o.second);
+		}
+
+		morph->offsets.swap(offsets);
+	}
+
+	shape->second.erase(std::remove_if(shape->second.begin(), shape->second.end(), [](MorphDataPtr data) { return data->offsets.empty(); }), shape->second.end());
+}
+
 void TriFile::DeleteMorphFromAll(std::string morphName) {
 	for (auto shape = shapeMorphs.begin(); shape != shapeMorphs.end();) {
 		auto morph = find_if(shape->second.begin(), shape->second.end(), [&](MorphDataPtr searchData){ if (searchData->name == morphName) return true; return false; });
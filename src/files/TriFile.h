@@ -32,6 +32,10 @@ public:
 	void DeleteMorphs(std::string shapeName);
 	void DeleteMorphFromAll(std::string morphName);
 
+	// Removes the offsets of the sorted vertex indices from all morphs of the shape and renumbers the rest.
+	// Morphs without any offsets left are deleted.
+	void DeleteVerts(std::string shapeName, const std::vector<ushort>& indices);
+
 	MorphDataPtr GetMorph(std::string shapeName, std::string morphName);
 	std::map<std::string, std::vector<MorphDataPtr>> GetMorphs();
 };
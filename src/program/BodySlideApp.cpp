@@ -19,13 +19,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "BodySlideApp.h"
 #include "..\Files\wxDDSImage.h"
 
-#ifdef WIN64
-	#include <ppl.h>
-	#include <concurrent_unordered_map.h>
-#else
-	#undef _PPL_H
-#endif
-
 ConfigurationManager Config;
 
 const wxString TargetGames[] = { "Fallout3", "FalloutNewVegas", "Skyrim", "Fallout4", "SkyrimSpecialEdition" };
@@ -84,6 +77,7 @@ BodySlideApp::~BodySlideApp() {
 	locale = nullptr;
 
 	FSManager::del();
+	FSManager::setParallelFor(nullptr);
 }
 
 bool BodySlideApp::OnInit() {
@@ -223,10 +217,20 @@ void BodySlideApp::OnFatalException() {
 void BodySlideApp::InitArchives() {
 	// Auto-detect archives
 	FSManager::del();
+	FSManager::setIndexCacheDir(Config["ArchiveCachePath"]);
+
+	if (!archivePool) {
+		archivePool = std::make_unique<ThreadPool>();
+		ThreadPool* pool = archivePool.get();
+		FSManager::setParallelFor([pool](int count, const std::function<void(int)>& func) {
+			pool->ParallelFor(count, func);
+		});
+	}
 
 	std::vector<std::string> fileList;
 	GetArchiveFiles(fileList);
 
+	// Archives are only opened on the first lookup
 	FSManager::addArchives(fileList);
 }
 
@@ -623,59 +627,48 @@ void BodySlideApp::ApplySliders(const std::string& targetShape, std::vector<Slid
 				dataSets.ApplyClamp(slider.linkedDataSets[j], targetShape, &verts);
 }
 
-int BodySlideApp::WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices) {
-	DiffDataSets currentDiffs;
-	sliderSet.LoadSetDiffData(currentDiffs);
-
-	TriFile tri;
-	std::string triFilePath = triPath + ".tri";
+void BodySlideApp::ApplyPreviewSliders(const std::string& targetShape, float weight,
+	const std::vector<Vector3>& baseVerts, const std::vector<Vector2>& baseUVs,
+	std::vector<Vector3>& verts, std::vector<ushort>& ZapIdx, std::vector<Vector2>& uvs) {
 
-	for (auto shape = sliderSet.TargetShapesBegin(); shape != sliderSet.TargetShapesEnd(); ++shape) {
-		for (int s = 0; s < sliderSet.size(); s++) {
-			std::string dn = sliderSet[s].TargetDataName(shape->first);
-			std::string target = shape->first;
-			if (dn.empty())
-				continue;
-
-			if (!sliderSet[s].bUV && !sliderSet[s].bClamp && !sliderSet[s].bZap) {
-				MorphDataPtr morph = std::make_shared<MorphData>();
-				morph->name = sliderSet[s].name;
-
-				const std::vector<ushort>& shapeZapIndices = zapIndices[shape->second];
-
-				std::vector<Vector3> verts;
-				int shapeVertCount = nif.GetVertCountForShape(shape->second);
-				shapeVertCount += shapeZapIndices.size();
-				if (shapeVertCount > 0)
-					verts.resize(shapeVertCount);
-				else
-					continue;
+	// Without low weight the low result is the base shape
+	bool genWeights = activeSet.GenWeights();
 
-				currentDiffs.ApplyDiff(dn, target, 1.0f, &verts);
-
-				if (shapeZapIndices.size() > 0 && shapeZapIndices.back() >= verts.size())
-					continue;
-
-				for (int i = shapeZapIndices.size() - 1; i >= 0; i--)
-					verts.erase(verts.begin() + shapeZapIndices[i]);
-				
-				int i = 0;
-				for (auto &v : verts) {
-					if (!v.IsZero(true))
-						morph->offsets.emplace(i, v);
-					i++;
-				}
+	std::vector<MorphTerm> terms;
+	for (int i = 0; i < sliderManager.slidersBig.size(); i++) {
+		Slider& sliderBig = sliderManager.slidersBig[i];
+		Slider* sliderSmall = sliderManager.GetSmallSlider(i);
 
-				if (morph->offsets.size() > 0)
-					tri.AddMorph(shape->second, morph);
+		float valHigh = sliderBig.value;
+		float valLow = genWeights && sliderSmall ? sliderSmall->value : 0.0f;
+		if (sliderBig.zap && !sliderBig.uv) {
+			if (valHigh > 0 || valLow > 0)
+				for (int j = 0; j < sliderBig.linkedDataSets.size(); j++)
+					dataSets.GetDiffIndices(sliderBig.linkedDataSets[j], targetShape, ZapIdx);
+		}
+		else {
+			if (sliderBig.invert) {
+				valHigh = 1.0f - valHigh;
+				if (genWeights && sliderSmall)
+					valLow = 1.0f - valLow;
 			}
+
+			float val = valHigh * weight + valLow * (1.0f - weight);
+			for (int j = 0; j < sliderBig.linkedDataSets.size(); j++)
+				terms.emplace_back(sliderBig.linkedDataSets[j], val, sliderBig.uv);
 		}
 	}
 
-	if (!tri.Write(triFilePath))
-		return false;
+	previewMorphs.Evaluate(targetShape, dataSets, targetShape, baseVerts, &baseUVs, terms, verts, &uvs);
 
-	return true;
+	// Clamps replace positions, they are applied to the result instead of the cached morphs
+	for (int i = 0; i < sliderManager.slidersBig.size(); i++) {
+		Slider& sliderBig = sliderManager.slidersBig[i];
+		Slider* sliderSmall = sliderManager.GetSmallSlider(i);
+		if (sliderBig.clamp && (sliderBig.value > 0 || (genWeights && sliderSmall && sliderSmall->value > 0)))
+			for (int j = 0; j < sliderBig.linkedDataSets.size(); j++)
+				dataSets.ApplyClamp(sliderBig.linkedDataSets[j], targetShape, &verts);
+	}
 }
 
 void BodySlideApp::CopySliderValues(bool toHigh) {
@@ -738,20 +731,22 @@ void BodySlideApp::InitPreview() {
 
 	if (!previewBaseNif) {
 		previewBaseNif = new NifFile();
-		previewBaseNif->Load(inputFileName);
-		if (PreviewMod.Load(inputFileName))
+		if (previewBaseNif->Load(inputFileName))
 			return;
 
+		PreviewMod.CopyFrom(*previewBaseNif);
+
 		freshLoad = true;
 		sliderManager.FlagReload(false);
 	}
 	else if (previewBaseName != inputFileName || previewSetName != inputSetName || sliderManager.NeedReload()) {
 		delete previewBaseNif;
 		previewBaseNif = new NifFile();
-		previewBaseNif->Load(inputFileName);
-		if (PreviewMod.Load(inputFileName) != 0)
+		if (previewBaseNif->Load(inputFileName))
 			return;
 
+		PreviewMod.CopyFrom(*previewBaseNif);
+
 		freshLoad = true;
 		sliderManager.FlagReload(false);
 	}
@@ -782,12 +777,9 @@ void BodySlideApp::InitPreview() {
 		}
 		else if (zapIdx.size() > 0) {
 			// Preview Window has been opened for this shape before, zap the diff verts before applying them to the shape
-			for (int z = zapIdx.size() - 1; z >= 0; z--) {
-				if (zapIdx[z] >= verts.size())
-					continue;
-				verts.erase(verts.begin() + zapIdx[z]);
-				uvs.erase(uvs.begin() + zapIdx[z]);
-			}
+			IndexCollapse indexCollapse(zapIdx);
+			indexCollapse.CompactData(verts);
+			indexCollapse.CompactData(uvs);
 			PreviewMod.SetVertsForShape(it->second, verts);
 			PreviewMod.SetUvsForShape(it->second, uvs);
 		}
@@ -819,40 +811,24 @@ void BodySlideApp::UpdatePreview() {
 	if (!previewBaseNif)
 		return;
 	
-	int weight = preview->GetWeight();
-	std::vector<Vector3> verts, vertsLow, vertsHigh;
-	std::vector<Vector2> uvs, uvsLow, uvsHigh;
+	float weight = preview->GetWeight() / 100.0f;
+	std::vector<Vector3> baseVerts, verts;
+	std::vector<Vector2> baseUVs, uvs;
 	std::vector<ushort> zapIdx;
 	for (auto it = activeSet.TargetShapesBegin(); it != activeSet.TargetShapesEnd(); ++it) {
 		zapIdx.clear();
-		if (!previewBaseNif->GetVertsForShape(it->second, verts))
+		if (!previewBaseNif->GetVertsForShape(it->second, baseVerts))
 			continue;
 
-		previewBaseNif->GetUvsForShape(it->second, uvs);
-		vertsHigh = verts;
-		vertsLow = verts;
-		uvsHigh = uvs;
-		uvsLow = uvs;
+		previewBaseNif->GetUvsForShape(it->second, baseUVs);
 
-		ApplySliders(it->first, sliderManager.slidersBig, vertsHigh, zapIdx, &uvsHigh);
-		if (activeSet.GenWeights())
-			ApplySliders(it->first, sliderManager.slidersSmall, vertsLow, zapIdx, &uvsLow);
-
-		// Calculate result of weight
-		for (int i = 0; i < verts.size(); i++) {
-			verts[i] = (vertsHigh[i] / 100.0f * weight) + (vertsLow[i] / 100.0f * (100.0f - weight));
-			uvs[i] = (uvsHigh[i] / 100.0f * weight) + (uvsLow[i] / 100.0f * (100.0f - weight));
-		}
+		ApplyPreviewSliders(it->first, weight, baseVerts, baseUVs, verts, zapIdx, uvs);
 
 		// Zap deleted verts before applying to the shape
 		if (zapIdx.size() > 0) {
-			for (int z = zapIdx.size() - 1; z >= 0; z--) {
-				if (zapIdx[z] >= verts.size())
-					continue;
-
-				verts.erase(verts.begin() + zapIdx[z]);
-				uvs.erase(uvs.begin() + zapIdx[z]);
-			}
+			IndexCollapse indexCollapse(zapIdx);
+			indexCollapse.CompactData(verts);
+			indexCollapse.CompactData(uvs);
 		}
 		preview->Update(it->second, &verts, &uvs);
 	}
@@ -863,6 +839,8 @@ void BodySlideApp::UpdatePreview() {
 }
 
 void BodySlideApp::CleanupPreview() {
+	previewMorphs.Clear();
+
 	if (!preview)
 		return;
 
@@ -876,33 +854,20 @@ void BodySlideApp::RebuildPreviewMeshes() {
 	if (!previewBaseNif)
 		return;
 
-	int weight = preview->GetWeight();
+	float weight = preview->GetWeight() / 100.0f;
 	PreviewMod.CopyFrom((*previewBaseNif));
 	
-	std::vector<Vector3> verts, vertsLow, vertsHigh;
-	std::vector<Vector2> uvs, uvsLow, uvsHigh;
+	std::vector<Vector3> baseVerts, verts;
+	std::vector<Vector2> baseUVs, uvs;
 	std::vector<ushort> zapIdx;
-	Vector3 v;
 	for (auto it = activeSet.TargetShapesBegin(); it != activeSet.TargetShapesEnd(); ++it) {
 		zapIdx.clear();
-		if (!previewBaseNif->GetVertsForShape(it->second, verts))
+		if (!previewBaseNif->GetVertsForShape(it->second, baseVerts))
 			continue;
 
-		previewBaseNif->GetUvsForShape(it->second, uvs);
-		vertsHigh = verts;
-		vertsLow = verts;
-		uvsHigh = uvs;
-		uvsLow = uvs;
-
-		ApplySliders(it->first, sliderManager.slidersBig, vertsHigh, zapIdx, &uvsHigh);
-		if (activeSet.GenWeights())
-			ApplySliders(it->first, sliderManager.slidersSmall, vertsLow, zapIdx, &uvsLow);
-		
-		// Calculate result of weight
-		for (int i = 0; i < verts.size(); i++) {
-			verts[i] = (vertsHigh[i] / 100.0f * weight) + (vertsLow[i] / 100.0f * (100.0f - weight));
-			uvs[i] = (uvsHigh[i] / 100.0f * weight) + (uvsLow[i] / 100.0f * (100.0f - weight));
-		}
+		previewBaseNif->GetUvsForShape(it->second, baseUVs);
+
+		ApplyPreviewSliders(it->first, weight, baseVerts, baseUVs, verts, zapIdx, uvs);
 
 		// Zap deleted verts before preview
 		if (zapIdx.size() > 0) {
@@ -934,6 +899,7 @@ bool BodySlideApp::SetDefaultConfig() {
 	currentTarget = Config.GetIntValue("TargetGame");
 
 	Config.SetDefaultValue("ShapeDataPath", wxGetCwd().ToStdString() + "\\ShapeData");
+	Config.SetDefaultValue("ArchiveCachePath", wxGetCwd().ToStdString() + "\\ArchiveCache");
 	Config.SetDefaultValue("WarnMissingGamePath", "true");
 	Config.SetDefaultValue("WarnBatchBuildOverride", "true");
 	Config.SetDefaultValue("BSATextureScan", "true");
@@ -959,6 +925,7 @@ bool BodySlideApp::SetDefaultConfig() {
 	Config.SetDefaultValue("Lights/Directional2.x", 30);
 	Config.SetDefaultValue("Lights/Directional2.y", 20);
 	Config.SetDefaultValue("Lights/Directional2.z", -100);
+	Config.SetDefaultValue("Rendering/TextureMaxSize", 0);
 	Config.SetDefaultValue("BodySlideFrame.width", 800);
 	Config.SetDefaultValue("BodySlideFrame.height", 600);
 	Config.SetDefaultValue("BodySlideFrame.x", 100);
@@ -1272,7 +1239,7 @@ int BodySlideApp::SaveGroupList(const std::string& fileName, const std::string&
 	outfile.GetGroupNames(existing);
 	bool found = false;
 	for (auto &e : existing) {
-		if (_stricmp(e.c_str(), groupName.c_str()) == 0) {
+		if (StrICmp(e.c_str(), groupName.c_str()) == 0) {
 			found = true;
 			break;
 		}
@@ -1395,6 +1362,15 @@ void BodySlideApp::LoadPresets(const std::string& sliderSet) {
 	sliderManager.LoadPresets("SliderPresets", outfit, groups_and_aliases, groups_and_aliases.empty());
 }
 
+OutfitBuilder& BodySlideApp::GetOutfitBuilder(const BuildOptions& options) {
+	if (!outfitBuilder)
+		outfitBuilder = std::make_unique<OutfitBuilder>(sliderManager, options);
+	else
+		outfitBuilder->SetOptions(options);
+
+	return *outfitBuilder;
+}
+
 int BodySlideApp::BuildBodies(bool localPath, bool clean, bool tri) {
 	std::string inputFileName = activeSet.GetInputFileName();
 	NifFile nifSmall;
@@ -1483,52 +1459,30 @@ int BodySlideApp::BuildBodies(bool localPath, bool clean, bool tri) {
 		return 1;
 	}
 
+	// Both weights start out identical, clone the parsed file instead of reading it again
 	if (activeSet.GenWeights())
-		if (nifSmall.Load(inputFileName))
-			return 1;
+		nifSmall.CopyFrom(nifBig);
 
-	std::vector<Vector3> vertsLow;
-	std::vector<Vector3> vertsHigh;
-	std::vector<Vector2> uvsLow;
-	std::vector<Vector2> uvsHigh;
-	std::vector<ushort> zapIdx;
-	std::unordered_map<std::string, std::vector<ushort>> zapIdxAll;
+	BuildOptions options;
+	options.threadCount = Config.GetIntValue("BuildThreads", 0);
 
-	for (auto it = activeSet.TargetShapesBegin(); it != activeSet.TargetShapesEnd(); ++it) {
-		if (!nifBig.GetVertsForShape(it->second, vertsHigh))
-			continue;
-
-		nifBig.GetUvsForShape(it->second, uvsHigh);
+	// The shapes are shaped in parallel, applying the sliders must not pack sets on the fly
+	dataSets.PackSets();
 
-		if (activeSet.GenWeights()) {
-			if (!nifSmall.GetVertsForShape(it->second, vertsLow))
-				continue;
-
-			nifSmall.GetUvsForShape(it->second, uvsLow);
-		}
+	bool genWeights = activeSet.GenWeights();
+	std::vector<ShapeTask> shapeTasks;
 
-		zapIdxAll.emplace(it->second, std::vector<ushort>());
-
-		ApplySliders(it->first, sliderManager.slidersBig, vertsHigh, zapIdx, &uvsHigh);
-		nifBig.SetVertsForShape(it->second, vertsHigh);
-		nifBig.SetUvsForShape(it->second, uvsHigh);
-		nifBig.CalcNormalsForShape(it->second);
-		nifBig.CalcTangentsForShape(it->second);
-		nifBig.DeleteVertsForShape(it->second, zapIdx);
-
-		if (activeSet.GenWeights()) {
-			zapIdx.clear();
-			ApplySliders(it->first, sliderManager.slidersSmall, vertsLow, zapIdx, &uvsLow);
-			nifSmall.SetVertsForShape(it->second, vertsLow);
-			nifSmall.SetUvsForShape(it->second, uvsLow);
-			nifSmall.CalcNormalsForShape(it->second);
-			nifSmall.CalcTangentsForShape(it->second);
-			nifSmall.DeleteVertsForShape(it->second, zapIdx);
-		}
+	OutfitBuilder& builder = GetOutfitBuilder(options);
+	builder.ShapeNifs(activeSet, nifBig, genWeights ? &nifSmall : nullptr, [&](ShapeTask& task) {
+		ApplySliders(task.target, sliderManager.slidersBig, task.vertsBig, task.zapBig, &task.uvsBig);
+		if (genWeights)
+			ApplySliders(task.target, sliderManager.slidersSmall, task.vertsSmall, task.zapSmall, &task.uvsSmall);
+	}, shapeTasks);
 
-		zapIdxAll[it->second] = zapIdx;
-		zapIdx.clear();
-	}
+	std::unordered_map<std::string, std::vector<ushort>> zapIdxAll;
+	for (auto &task : shapeTasks)
+		if (task.valid)
+			zapIdxAll[task.shapeName] = genWeights ? task.zapSmall : task.zapBig;
 
 	/* Add TRI path for in-game morphs */
 	if (tri) {
@@ -1537,7 +1491,7 @@ int BodySlideApp::BuildBodies(bool localPath, bool clean, bool tri) {
 		triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex("/+|\\\\+"), "\\");									// Replace multiple slashes or forward slashes with one backslash
 		triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex(".*meshes\\\\", std::regex_constants::icase), "");	// Remove everything before and including the meshes path
 
-		if (!WriteMorphTRI(outFileNameBig, activeSet, nifBig, zapIdxAll)) {
+		if (!OutfitBuilder::WriteMorphTRI(outFileNameBig, activeSet, nifBig, zapIdxAll)) {
 			wxLogError("Failed to write TRI file to '%s'!", triPath);
 			wxMessageBox(wxString().Format(_("Failed to write TRI file to the following location\n\n%s"), triPath), _("Unable to process"), wxOK | wxICON_ERROR);
 		}
@@ -1741,304 +1695,30 @@ int BodySlideApp::BuildListBodies(std::vector<std::string>& outfitList, std::map
 	progWnd = new wxProgressDialog(_("Processing Outfits"), _("Starting..."), 1000, nullptr, wxPD_AUTO_HIDE | wxPD_APP_MODAL | wxPD_SMOOTH | wxPD_ELAPSED_TIME);
 	progWnd->SetSize(400, 150);
 	float progstep = 1000.0f / outfitList.size();
-	int count = 1;
+
+	BuildOptions options;
+	options.dataPath = datapath;
+	options.shapeDataPath = Config["ShapeDataPath"];
+	options.presetName = activePreset;
+	options.clean = clean && custPath.empty();
+	options.tri = tri;
+	options.triOnRoot = targetGame >= FO4;
+	options.threadCount = Config.GetIntValue("BuildThreads", 0);
 
 	// Multi-threading for 64-bit only due to memory limits of 32-bit builds
-#ifdef _PPL_H
-	concurrency::critical_section critical;
-	concurrency::concurrent_unordered_map<std::string, std::string> failedOutfitsCon;
-	concurrency::parallel_for_each(outfitList.begin(), outfitList.end(), [&](const std::string& outfit)
-#else
-	#define return continue
-	std::unordered_map<std::string, std::string> failedOutfitsCon;
-	for (auto &outfit : outfitList)
-#endif
-	{
-#ifdef _PPL_H
-		critical.lock();
-#endif
+	if (sizeof(void*) < 8)
+		options.threadCount = 1;
 
-		wxString progMsg = wxString::Format(_("Processing '%s' (%d of %d)..."), outfit, count, outfitList.size());
+	OutfitBuilder& builder = GetOutfitBuilder(options);
+	int ret = builder.BuildList(outfitList, outfitNameSource, failedOutfits, [&](int count, int total, const std::string& outfit) {
+		wxString progMsg = wxString::Format(_("Processing '%s' (%d of %d)..."), outfit, count, total);
 		progWnd->Update((int)(count * progstep) - 1, progMsg);
-		count++;
-
-#ifdef _PPL_H
-		critical.unlock();
-#endif
-
-		wxLogMessage(progMsg);
-		wxLog::FlushActive();
-
-		/* Load set */
-		if (outfitNameSource.find(outfit) == outfitNameSource.end()) {
-			failedOutfitsCon[outfit] = _("No recorded outfit name source");
-			return;
-		}
-
-		SliderSet currentSet;
-		DiffDataSets currentDiffs;
-
-		SliderSetFile sliderDoc;
-		sliderDoc.Open(outfitNameSource[outfit]);
-		if (!sliderDoc.fail()) {
-			if (sliderDoc.GetSet(outfit, currentSet)) {
-				failedOutfitsCon[outfit] = _("Unable to get slider set from file: ") + outfitNameSource[outfit];
-				return;
-			}
-		}
-		else {
-			failedOutfitsCon[outfit] = _("Unable to open slider set file: ") + outfitNameSource[outfit];
-			return;
-		}
-
-		currentSet.SetBaseDataPath(Config["ShapeDataPath"]);
-
-		// ALT key
-		if (clean && custPath.empty()) {
-			bool genWeights = currentSet.GenWeights();
-
-			std::string removePath = datapath + currentSet.GetOutputFilePath();
-			std::string removeHigh = removePath + ".nif";
-			if (genWeights)
-				removeHigh = removePath + "_1.nif";
-
-			if (wxFileName::FileExists(removeHigh))
-				wxRemoveFile(removeHigh);
-
-			if (!genWeights)
-				return;
-
-			std::string removeLow = removePath + "_0.nif";
-			if (wxFileName::FileExists(removeLow))
-				wxRemoveFile(removeLow);
-
-			return;
-		}
-
-		/* Load input NIFs */
-		NifFile nifBig;
-		NifFile nifSmall;
-		if (nifBig.Load(currentSet.GetInputFileName())) {
-			failedOutfitsCon[outfit] = _("Unable to load input nif: ") + currentSet.GetInputFileName();
-			return;
-		}
-
-		if (currentSet.GenWeights())
-			if (nifSmall.Load(currentSet.GetInputFileName()))
-				return;
-
-		currentSet.LoadSetDiffData(currentDiffs);
-
-		/* Shape the NIF files */
-		std::vector<Vector3> vertsLow;
-		std::vector<Vector3> vertsHigh;
-		std::vector<Vector2> uvsLow;
-		std::vector<Vector2> uvsHigh;
-		std::vector<ushort> zapIdx;
-		std::unordered_map<std::string, std::vector<ushort>> zapIdxAll;
-
-		for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it) {
-			if (!nifBig.GetVertsForShape(it->second, vertsHigh))
-				continue;
-
-			nifBig.GetUvsForShape(it->second, uvsHigh);
-
-			if (currentSet.GenWeights()) {
-				if (!nifSmall.GetVertsForShape(it->second, vertsLow))
-					continue;
-
-				nifSmall.GetUvsForShape(it->second, uvsLow);
-			}
-
-			float vbig = 0.0f;
-			float vsmall = 0.0f;
-			std::vector<int> clamps;
-			zapIdxAll.emplace(it->second, std::vector<ushort>());
-
-			for (int s = 0; s < currentSet.size(); s++) {
-				std::string dn = currentSet[s].TargetDataName(it->first);
-				std::string target = it->first;
-				if (dn.empty())
-					continue;
-
-				if (currentSet[s].bClamp)  {
-					clamps.push_back(s);
-					continue;
-				}
-
-				vbig = sliderManager.GetBigPresetValue(activePreset, currentSet[s].name, currentSet[s].defBigValue / 100.0f);
-				for (auto &sliderBig : sliderManager.slidersBig) {
-					if (sliderBig.name == currentSet[s].name && sliderBig.changed && !sliderBig.clamp) {
-						vbig = sliderBig.value;
-						break;
-					}
-				}
-
-				if (currentSet.GenWeights()) {
-					vsmall = sliderManager.GetSmallPresetValue(activePreset, currentSet[s].name, currentSet[s].defSmallValue / 100.0f);
-					for (auto &sliderSmall : sliderManager.slidersSmall) {
-						if (sliderSmall.name == currentSet[s].name && sliderSmall.changed && !sliderSmall.clamp) {
-							vsmall = sliderSmall.value;
-							break;
-						}
-					}
-				}
-
-				if (currentSet[s].bInvert) {
-					vbig = 1.0f - vbig;
-					if (currentSet.GenWeights())
-						vsmall = 1.0f - vsmall;
-				}
-
-				if (currentSet[s].bZap && !currentSet[s].bUV) {
-					if (vbig > 0.0f) {
-						currentDiffs.GetDiffIndices(dn, target, zapIdx);
-						zapIdxAll[it->second] = zapIdx;
-					}
-					continue;
-				}
-
-				if (currentSet[s].bUV)
-					currentDiffs.ApplyUVDiff(dn, target, vbig, &uvsHigh);
-				else
-					currentDiffs.ApplyDiff(dn, target, vbig, &vertsHigh);
-
-				if (currentSet.GenWeights()) {
-					if (currentSet[s].bUV)
-						currentDiffs.ApplyUVDiff(dn, target, vsmall, &uvsLow);
-					else
-						currentDiffs.ApplyDiff(dn, target, vsmall, &vertsLow);
-				}
-			}
-
-			if (!clamps.empty()) {
-				for (auto &c : clamps) {
-					std::string dn = currentSet[c].TargetDataName(it->first);
-					std::string target = it->first;
-					if (currentSet[c].defBigValue > 0)
-						currentDiffs.ApplyClamp(dn, target, &vertsHigh);
-
-					if (currentSet.GenWeights())
-						if (currentSet[c].defSmallValue > 0)
-							currentDiffs.ApplyClamp(dn, target, &vertsLow);
-				}
-			}
-
-			nifBig.SetVertsForShape(it->second, vertsHigh);
-			nifBig.SetUvsForShape(it->second, uvsHigh);
-			nifBig.CalcNormalsForShape(it->second);
-			nifBig.CalcTangentsForShape(it->second);
-			nifBig.DeleteVertsForShape(it->second, zapIdx);
-
-			if (currentSet.GenWeights()) {
-				nifSmall.SetVertsForShape(it->second, vertsLow);
-				nifSmall.SetUvsForShape(it->second, uvsLow);
-				nifSmall.CalcNormalsForShape(it->second);
-				nifSmall.CalcTangentsForShape(it->second);
-				nifSmall.DeleteVertsForShape(it->second, zapIdx);
-			}
-
-			zapIdx.clear();
-		}
-
-		currentDiffs.Clear();
-
-		/* Create directory for the outfit */
-		wxString dir = datapath + currentSet.GetOutputPath();
-		bool success = wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
-
-		if (!success) {
-			failedOutfitsCon[outfit] = _("Unable to create destination directory: ") + dir.ToStdString();
-			return;
-		}
-
-		std::string outFileNameSmall = datapath + currentSet.GetOutputFilePath();
-		std::string outFileNameBig = outFileNameSmall;
-
-		/* Add TRI path for in-game morphs */
-		bool triEnd = tri;
-		if (triEnd) {
-			std::string triPath = currentSet.GetOutputFilePath() + ".tri";
-			std::string triPathTrimmed = triPath;
-			triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex("/+|\\\\+"), "\\");									// Replace multiple slashes or forward slashes with one backslash
-			triPathTrimmed = std::regex_replace(triPathTrimmed, std::regex(".*meshes\\\\", std::regex_constants::icase), "");	// Remove everything before and including the meshes path
-
-			if (!WriteMorphTRI(outFileNameBig, currentSet, nifBig, zapIdxAll)) {
-				wxLogError("Failed to create TRI file to '%s'!", triPath);
-				wxLog::FlushActive();
-			}
-
-			if (targetGame < FO4) {
-				for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it) {
-					std::string triShapeLink = it->second;
-					if (triEnd && nifBig.GetVertCountForShape(triShapeLink) > 0) {
-						nifBig.AddStringExtraData(triShapeLink, "BODYTRI", triPathTrimmed);
-						if (currentSet.GenWeights())
-							nifSmall.AddStringExtraData(triShapeLink, "BODYTRI", triPathTrimmed);
-						triEnd = false;
-					}
-				}
-			}
-			else {
-				nifBig.AddStringExtraData(nifBig.GetNodeName(nifBig.GetRootNodeID()), "BODYTRI", triPathTrimmed, true);
-				if (currentSet.GenWeights())
-					nifSmall.AddStringExtraData(nifBig.GetNodeName(nifBig.GetRootNodeID()), "BODYTRI", triPathTrimmed, true);
-			}
-
-			// Set all shapes to dynamic/mutable
-			for (auto it = currentSet.TargetShapesBegin(); it != currentSet.TargetShapesEnd(); ++it) {
-				nifBig.SetShapeDynamic(it->second);
-				if (currentSet.GenWeights())
-					nifSmall.SetShapeDynamic(it->second);
-			}
-		}
-		else {
-			std::string triPath = outFileNameBig + ".tri";
-			if (wxFileName::FileExists(triPath))
-				wxRemoveFile(triPath);
-		}
-
-		/* Set filenames for the outfit */
-		if (currentSet.GenWeights()) {
-			outFileNameSmall += "_0.nif";
-			outFileNameBig += "_1.nif";
-
-			if (nifBig.Save(outFileNameBig, false)) {
-				failedOutfitsCon[outfit] = _("Unable to save nif file: ") + outFileNameBig;
-				return;
-			}
-
-			if (nifSmall.Save(outFileNameSmall, false)) {
-				failedOutfitsCon[outfit] = _("Unable to save nif file: ") + outFileNameSmall;
-				return;
-			}
-		}
-		else {
-			outFileNameBig += ".nif";
-
-			if (nifBig.Save(outFileNameBig, false)) {
-				failedOutfitsCon[outfit] = _("Unable to save nif file: ") + outFileNameBig;
-				return;
-			}
-		}
-
-		return;
-#ifdef _PPL_H
 	});
-#else
-	}
-#undef return
-#endif
 
 	progWnd->Update(1000);
 	delete progWnd;
 
-	failedOutfits.insert(failedOutfitsCon.begin(), failedOutfitsCon.end());
-
-	if (failedOutfits.size() > 0)
-		return 3;
-
-	return 0;
+	return ret;
 }
 
 void BodySlideApp::GroupBuild(const std::string& group) {
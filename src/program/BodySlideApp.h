@@ -26,8 +26,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../components/SliderManager.h"
 #include "../components/SliderGroup.h"
 #include "../components/SliderCategories.h"
+#include "../components/OutfitBuilder.h"
+#include "../components/MorphEvaluator.h"
 #include "../files/TriFile.h"
 #include "../utils/Log.h"
+#include "../utils/ThreadPool.h"
 
 #include "../FSEngine/FSManager.h"
 #include "../FSEngine/FSEngine.h"
@@ -90,8 +93,12 @@ class BodySlideApp : public wxApp {
 	std::string previewSetName;
 	NifFile* previewBaseNif = nullptr;
 	NifFile PreviewMod;
+	MorphEvaluator previewMorphs;		// Preview shapes morphed with the blended slider values, updated by changes only
+	std::unique_ptr<OutfitBuilder> outfitBuilder;	// Kept across builds, so its thread pool isn't started again for every build
+	std::unique_ptr<ThreadPool> archivePool;	// Decompresses the chunks of large archived textures in parallel
 
 	int CreateSetSliders(const std::string& outfit);
+	OutfitBuilder& GetOutfitBuilder(const BuildOptions& options);
 
 public:
 	virtual ~BodySlideApp();
@@ -174,7 +181,12 @@ public:
 	void LaunchOutfitStudio();
 
 	void ApplySliders(const std::string& targetShape, std::vector<Slider>& sliderSet, std::vector<Vector3>& verts, std::vector<ushort>& zapidx, std::vector<Vector2>* uvs = nullptr);
-	int WriteMorphTRI(const std::string& triPath, SliderSet& sliderSet, NifFile& nif, std::unordered_map<std::string, std::vector<ushort>>& zapIndices);
+
+	// Applies low and high weight sliders blended by the weight (0 = low, 1 = high) in a single pass.
+	// Only the blended values that changed since the last preview update of the shape are applied.
+	void ApplyPreviewSliders(const std::string& targetShape, float weight,
+		const std::vector<Vector3>& baseVerts, const std::vector<Vector2>& baseUVs,
+		std::vector<Vector3>& verts, std::vector<ushort>& zapidx, std::vector<Vector2>& uvs);
 
 	void CopySliderValues(bool toHigh);
 	void ShowPreview();
@@ -188,6 +200,7 @@ public:
 	}
 	void PreviewClosed() {
 		preview = nullptr;
+		previewMorphs.Clear();
 	}
 
 	void CloseOutfitStudio(bool force = false) {
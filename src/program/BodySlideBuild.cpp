@@ -0,0 +1,173 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "BodySlideBuild.h"
+
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include <cstdio>
+
+ConfigurationManager Config;
+
+// Config names of the games, in the order of TargetGame
+static const std::string TargetGames[] = { "Fallout3", "FalloutNewVegas", "Skyrim", "Fallout4", "SkyrimSpecialEdition" };
+
+wxIMPLEMENT_APP_CONSOLE(BodySlideBuildApp);
+
+bool BodySlideBuildApp::OnInit() {
+	if (!wxAppConsole::OnInit())
+		return false;
+
+	if (Config.LoadConfig(cmdConfig.ToStdString()) != 0) {
+		wxLogError("Failed to load configuration file '%s'.", cmdConfig);
+		return false;
+	}
+
+	// Keep stdout free for progress lines
+	int logLevel = Config.GetIntValue("LogLevel", -1);
+	if (logLevel >= 0) {
+		wxLog* log = new wxLogStderr();
+		log->SetLogLevel(logLevel);
+		delete wxLog::SetActiveTarget(log);
+	}
+	else
+		wxLog::EnableLogging(false);
+
+	Config.SetDefaultValue("ShapeDataPath", wxGetCwd().ToStdString() + wxFILE_SEP_PATH + "ShapeData");
+	return true;
+}
+
+void BodySlideBuildApp::OnInitCmdLine(wxCmdLineParser& parser) {
+	parser.SetDesc(g_buildCmdLineDesc);
+}
+
+bool BodySlideBuildApp::OnCmdLineParsed(wxCmdLineParser& parser) {
+	parser.Found("gbuild", &cmdGroupBuild);
+	parser.Found("t", &cmdTargetDir);
+	parser.Found("p", &cmdPreset);
+	parser.Found("g", &cmdGame);
+	parser.Found("j", &cmdThreads);
+	parser.Found("cfg", &cmdConfig);
+	cmdTri = parser.Found("tri");
+	cmdClean = parser.Found("clean");
+
+	for (int i = 0; i < parser.GetParamCount(); i++)
+		cmdOutfits.push_back(parser.GetParam(i).ToStdString());
+
+	if (cmdGroupBuild.IsEmpty() && cmdOutfits.empty()) {
+		parser.Usage();
+		return false;
+	}
+
+	return true;
+}
+
+int BodySlideBuildApp::LoadSliderSets() {
+	wxLogMessage("Loading all slider sets...");
+	outfitNameSource.clear();
+
+	wxArrayString files;
+	wxDir::GetAllFiles("SliderSets", &files, "*.osp");
+	wxDir::GetAllFiles("SliderSets", &files, "*.xml");
+
+	for (auto &file : files) {
+		SliderSetFile sliderDoc;
+		sliderDoc.Open(file.ToStdString());
+		if (sliderDoc.fail())
+			continue;
+
+		std::vector<std::string> outfitNames;
+		sliderDoc.GetSetNamesUnsorted(outfitNames, false);
+		for (auto &outfit : outfitNames)
+			outfitNameSource[outfit] = file.ToStdString();
+	}
+
+	return outfitNameSource.size();
+}
+
+int BodySlideBuildApp::OnRun() {
+	int configGame = Config.GetIntValue("TargetGame", -1);
+	int targetGame = cmdGame >= 0 ? cmdGame : configGame;
+	if (targetGame < FO3 || targetGame > SKYRIMSE) {
+		wxLogError("Target game not configured.");
+		return 1;
+	}
+
+	// Data path of the selected game, the general one only belongs to the configured game
+	std::string dataPath = cmdTargetDir.ToStdString();
+	if (dataPath.empty())
+		dataPath = Config["GameDataPaths/" + TargetGames[targetGame]];
+	if (dataPath.empty() && targetGame == configGame)
+		dataPath = Config["GameDataPath"];
+
+	if (dataPath.empty()) {
+		wxLogError("Neither target directory nor game data path configured.");
+		return 1;
+	}
+
+	if (dataPath.back() != '\\' && dataPath.back() != '/')
+		dataPath += wxFILE_SEP_PATH;
+
+	wxLogMessage("Loading all slider groups...");
+	gCollection.LoadGroups("SliderGroups");
+	LoadSliderSets();
+
+	std::vector<std::string> outfits = cmdOutfits;
+	if (!cmdGroupBuild.IsEmpty()) {
+		std::string group = cmdGroupBuild.ToStdString();
+		for (auto &o : outfitNameSource) {
+			std::vector<std::string> groups;
+			gCollection.GetOutfitGroups(o.first, groups);
+			if (find(groups.begin(), groups.end(), group) != groups.end())
+				outfits.push_back(o.first);
+		}
+	}
+
+	std::string preset = cmdPreset.IsEmpty() ? Config["SelectedPreset"] : cmdPreset.ToStdString();
+
+	// Presets aren't filtered by group, the chosen one has to apply to every set of the build
+	std::vector<std::string> groupFilter;
+	sliderManager.LoadPresets("SliderPresets", "", groupFilter, true);
+
+	BuildOptions options;
+	options.dataPath = dataPath;
+	options.shapeDataPath = Config["ShapeDataPath"];
+	options.presetName = preset;
+	options.clean = cmdClean && cmdTargetDir.IsEmpty();
+	options.tri = cmdTri;
+	options.triOnRoot = targetGame >= FO4;
+	options.threadCount = cmdThreads >= 0 ? cmdThreads : Config.GetIntValue("BuildThreads", 0);
+
+	wxLogMessage("Started batch build of %d sets with options: Target Path = %s, Preset = %s, Cleaning = %s, TRI = %s",
+		outfits.size(), dataPath, preset, options.clean ? "True" : "False", options.tri ? "True" : "False");
+
+	std::map<std::string, std::string> failedOutfits;
+	OutfitBuilder builder(sliderManager, options);
+	int lastCount = 0;
+	builder.BuildList(outfits, outfitNameSource, failedOutfits, [&](int count, int total, const std::string& outfit) {
+		if (count == lastCount)
+			return;
+
+		lastCount = count;
+		printf("PROGRESS %d %d %s\n", count, total, outfit.c_str());
+		fflush(stdout);
+	});
+
+	for (auto &f : failedOutfits)
+		printf("FAILED %s: %s\n", f.first.c_str(), f.second.c_str());
+
+	printf("DONE %d %d\n", (int)(outfits.size() - failedOutfits.size()), (int)failedOutfits.size());
+	fflush(stdout);
+
+	wxLog::FlushActive();
+
+	if (failedOutfits.size() > 0)
+		return 3;
+
+	return 0;
+}
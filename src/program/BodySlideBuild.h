@@ -0,0 +1,59 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "../components/OutfitBuilder.h"
+#include "../components/SliderGroup.h"
+#include "../utils/ConfigurationManager.h"
+
+#include <wx/app.h>
+#include <wx/cmdline.h>
+
+static const wxCmdLineEntryDesc g_buildCmdLineDesc[] = {
+	{ wxCMD_LINE_OPTION, "gbuild", "groupbuild", "builds all sets of the specified group", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "t", "targetdir", "build target directory, defaults to game data path", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "p", "preset", "preset used for the build, defaults to last used preset", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_OPTION, "g", "game", "target game (0 = FO3, 1 = FONV, 2 = SKYRIM, 3 = FO4, 4 = SKYRIMSE), defaults to configured game", wxCMD_LINE_VAL_NUMBER },
+	{ wxCMD_LINE_OPTION, "j", "threads", "number of build threads, 0 uses all hardware threads", wxCMD_LINE_VAL_NUMBER },
+	{ wxCMD_LINE_OPTION, "cfg", "config", "configuration file, defaults to Config.xml", wxCMD_LINE_VAL_STRING },
+	{ wxCMD_LINE_SWITCH, "tri", "trimorphs", "enables tri morph output" },
+	{ wxCMD_LINE_SWITCH, "clean", "clean", "removes the output files instead of building them" },
+	{ wxCMD_LINE_PARAM, nullptr, nullptr, "set names to build", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE },
+	{ wxCMD_LINE_NONE }
+};
+
+// Console batch builder running the same pipeline as BodySlide's batch build without any UI.
+// Only needs wxBase, CMakeLists.txt builds it on other platforms than Windows as well.
+// Progress is written to stdout as one line per event, log output goes to stderr.
+//   PROGRESS <count> <total> <set name>
+//   FAILED <set name>: <reason>
+//   DONE <built> <failed>
+class BodySlideBuildApp : public wxAppConsole {
+	/* Command-Line Arguments */
+	wxString cmdGroupBuild;
+	wxString cmdTargetDir;
+	wxString cmdPreset;
+	wxString cmdConfig = "Config.xml";
+	long cmdGame = -1;
+	long cmdThreads = -1;
+	bool cmdTri = false;
+	bool cmdClean = false;
+	std::vector<std::string> cmdOutfits;
+
+	/* Data Managers */
+	SliderManager sliderManager;
+	SliderSetGroupCollection gCollection;
+	std::map<std::string, std::string> outfitNameSource;
+
+	int LoadSliderSets();
+
+public:
+	virtual bool OnInit();
+	virtual void OnInitCmdLine(wxCmdLineParser& parser);
+	virtual bool OnCmdLineParsed(wxCmdLineParser& parser);
+	virtual int OnRun();
+};
@@ -247,7 +247,7 @@ bool OutfitProject::SaveSliderData(const wxString& fileName, bool copyRef) {
 				targSlider = activeSet[i].TargetDataName(targ);
 				if (baseDiffData.GetDiffSet(targSlider) && baseDiffData.GetDiffSet(targSlider)->size() > 0) {
 					if (activeSet[i].IsLocalData(targSlider)) {
-						std::unordered_map<ushort, Vector3>* diff = baseDiffData.GetDiffSet(targSlider);
+						const std::unordered_map<ushort, Vector3>* diff = baseDiffData.GetDiffSet(targSlider);
 						osdDiffs.LoadSet(targSlider, targ, *diff);
 						osdNames[fileName.ToStdString()][targSlider] = targ;
 					}
@@ -830,7 +830,7 @@ void OutfitProject::SetSliderFromBSD(const std::string& sliderName, const std::s
 	else {
 		DiffDataSets tmpSet;
 		tmpSet.LoadSet(sliderName, target, fileName);
-		std::unordered_map<ushort, Vector3>* diff = tmpSet.GetDiffSet(sliderName);
+		const std::unordered_map<ushort, Vector3>* diff = tmpSet.GetDiffSet(sliderName);
 		morpher.SetResultDiff(target, sliderName, (*diff));
 	}
 }
@@ -938,39 +938,33 @@ int OutfitProject::GetVertexCount(const std::string& shapeName) {
 }
 
 void OutfitProject::GetLiveVerts(const std::string& shapeName, std::vector<Vector3>& outVerts, std::vector<Vector2>* outUVs) {
-	workNif.GetVertsForShape(shapeName, outVerts);
+	std::vector<Vector3> baseVerts;
+	std::vector<Vector2> baseUVs;
+	workNif.GetVertsForShape(shapeName, baseVerts);
 	if (outUVs)
-		workNif.GetUvsForShape(shapeName, *outUVs);
+		workNif.GetUvsForShape(shapeName, baseUVs);
 
 	std::string target = ShapeToTarget(shapeName);
-	if (IsBaseShape(shapeName)) {
-		for (int i = 0; i < activeSet.size(); i++) {
-			if (activeSet[i].bShow && activeSet[i].curValue != 0.0f) {
+	bool isBase = IsBaseShape(shapeName);
+
+	std::vector<MorphTerm> terms;
+	for (int i = 0; i < activeSet.size(); i++) {
+		if (activeSet[i].bShow && activeSet[i].curValue != 0.0f) {
+			if (isBase) {
 				std::string targetData = activeSet.ShapeToDataName(i, shapeName);
 				if (targetData == "")
 					continue;
 
-				if (activeSet[i].bUV) {
-					if (outUVs)
-						baseDiffData.ApplyUVDiff(targetData, target, activeSet[i].curValue, outUVs);
-				}
-				else
-					baseDiffData.ApplyDiff(targetData, target, activeSet[i].curValue, &outVerts);
-			}
-		}
-	}
-	else {
-		for (int i = 0; i < activeSet.size(); i++) {
-			if (activeSet[i].bShow && activeSet[i].curValue != 0.0f) {
-				if (activeSet[i].bUV) {
-					if (outUVs)
-						morpher.ApplyResultToUVs(activeSet[i].name, target, outUVs, activeSet[i].curValue);
-				}
-				else
-					morpher.ApplyResultToVerts(activeSet[i].name, target, &outVerts, activeSet[i].curValue);
+				terms.emplace_back(targetData, activeSet[i].curValue, activeSet[i].bUV);
 			}
+			else
+				terms.emplace_back(morpher.ResultDataName(target, activeSet[i].name), activeSet[i].curValue, activeSet[i].bUV);
 		}
 	}
+
+	// Only the sliders that changed since the last call are applied
+	DiffDataSets& diffData = isBase ? baseDiffData : morpher.ResultDiffData();
+	liveMorphs.Evaluate(shapeName, diffData, target, baseVerts, outUVs ? &baseUVs : nullptr, terms, outVerts, outUVs);
 }
 
 const std::string& OutfitProject::ShapeToTarget(const std::string& shapeName) {
@@ -1052,19 +1046,7 @@ void OutfitProject::SetTextures(const std::string& shapeName, const std::vector<
 			if (mat.Failed()) {
 				// Search for material file in archives
 				wxMemoryBuffer data;
-				for (FSArchiveFile *archive : FSManager::archiveList()) {
-					if (archive) {
-						if (archive->hasFile(matFile.ToStdString())) {
-							wxMemoryBuffer outData;
-							archive->fileContents(matFile.ToStdString(), outData);
-
-							if (!outData.IsEmpty()) {
-								data = std::move(outData);
-								break;
-							}
-						}
-					}
-				}
+				FSManager::fileContents(matFile.ToStdString(), data);
 
 				if (!data.IsEmpty()) {
 					std::string content((char*)data.GetData(), data.GetDataLen());
@@ -1229,7 +1211,7 @@ void OutfitProject::CopyBoneWeights(const std::string& destShape, const float& p
 
 	InitConform();
 	morpher.LinkRefDiffData(&dds);
-	morpher.BuildProximityCache(destShape, proximityRadius);
+	morpher.BuildProximityCache(destShape, proximityRadius, maxResults);
 
 	int step = 40 / boneList->size();
 	int prog = 40;
@@ -1867,15 +1849,30 @@ void OutfitProject::InitConform() {
 }
 
 void OutfitProject::ConformShape(const std::string& shapeName) {
-	if (!workNif.IsValid() || baseShape.empty())
-		return;
+	ConformShapes({ shapeName });
+}
 
-	morpher.BuildProximityCache(shapeName);
+bool OutfitProject::ConformShapes(const std::vector<std::string>& shapeNames, const float& proximityRadius, const int& maxResults, Automorph::ConformProgressFunc progress) {
+	if (!workNif.IsValid() || baseShape.empty())
+		return true;
 
 	std::string refTarget = ShapeToTarget(baseShape);
-	for (int i = 0; i < activeSet.size(); i++)
-		if (SliderShow(i) && !SliderZap(i) && !SliderUV(i))
-			morpher.GenerateResultDiff(shapeName, activeSet[i].name, activeSet[i].TargetDataName(refTarget));
+	std::vector<ConformTask> tasks;
+	for (auto &shapeName : shapeNames) {
+		morpher.BuildProximityCache(shapeName, proximityRadius, maxResults);
+
+		for (int i = 0; i < activeSet.size(); i++) {
+			if (SliderShow(i) && !SliderZap(i) && !SliderUV(i)) {
+				ConformTask task;
+				task.shapeName = shapeName;
+				task.sliderName = activeSet[i].name;
+				task.refDataName = activeSet[i].TargetDataName(refTarget);
+				tasks.push_back(task);
+			}
+		}
+	}
+
+	return morpher.GenerateResultDiffs(tasks, maxResults, progress);
 }
 
 void OutfitProject::DeleteVerts(const std::string& shapeName, const std::unordered_map<ushort, float>& mask) {
@@ -1910,6 +1907,7 @@ void OutfitProject::DuplicateShape(const std::string& sourceShape, const std::st
 }
 
 void OutfitProject::DeleteShape(const std::string& shapeName) {
+	liveMorphs.ClearShape(shapeName);
 	workAnim.ClearShape(shapeName);
 	workNif.DeleteShape(shapeName);
 	owner->glView->DeleteMesh(shapeName);
@@ -1921,6 +1919,7 @@ void OutfitProject::DeleteShape(const std::string& shapeName) {
 }
 
 void OutfitProject::RenameShape(const std::string& shapeName, const std::string& newShapeName) {
+	liveMorphs.ClearShape(shapeName);
 	workNif.RenameShape(shapeName, newShapeName);
 	workAnim.RenameShape(shapeName, newShapeName);
 	activeSet.RenameShape(shapeName, newShapeName);
@@ -9,6 +9,7 @@ See the included LICENSE file
 #include "../components/Automorph.h"
 #include "../components/Mesh.h"
 #include "../components/Anim.h"
+#include "../components/MorphEvaluator.h"
 #include "OutfitStudio.h"
 
 #include <wx/arrstr.h>
@@ -22,6 +23,7 @@ class OutfitProject {
 	NifFile workNif;
 	AnimInfo workAnim;
 	std::string baseShape;
+	MorphEvaluator liveMorphs;		// Shapes with the current slider values applied
 
 	// All cloth data blocks that have been loaded during work
 	std::unordered_map<std::string, BSClothExtraData*> clothData;
@@ -131,6 +133,9 @@ public:
 	void InitConform();
 	void ConformShape(const std::string& shapeName);
 
+	// Conforms all sliders of all listed shapes in one parallel pass. Returns false if cancelled through the progress callback.
+	bool ConformShapes(const std::vector<std::string>& shapeNames, const float& proximityRadius = 10.0f, const int& maxResults = 10, Automorph::ConformProgressFunc progress = nullptr);
+
 	const std::string& ShapeToTarget(const std::string& shapeName);
 	int GetVertexCount(const std::string& shapeName);
 	void GetLiveVerts(const std::string& shapeName, std::vector<Vector3>& outVerts, std::vector<Vector2>* outUVs = nullptr);
@@ -505,11 +505,11 @@ std::string OutfitStudio::NewSlider(const std::string& suggestedName, bool skipP
 		namebase = suggestedName;
 	}
 	char thename[256];
-	_snprintf_s(thename, 256, 256, "%s", namebase.c_str());
+	snprintf(thename, 256, "%s", namebase.c_str());
 	int count = 1;
 
 	while (sliderDisplays.find(thename) != sliderDisplays.end())
-		_snprintf_s(thename, 256, 256, "%s%d", namebase.c_str(), count++);
+		snprintf(thename, 256, "%s%d", namebase.c_str(), count++);
 	std::string finalName;
 	if (!skipPrompt) {
 		finalName = wxGetTextFromUser(_("Enter a name for the new slider:"), _("Create New Slider"), thename, this);
@@ -2036,10 +2036,10 @@ void OutfitStudio::OnMakeConvRef(wxCommandEvent& WXUNUSED(event)) {
 
 	std::string namebase = "ConvertToBase";
 	char thename[256];
-	_snprintf_s(thename, 256, 256, "%s", namebase.c_str());
+	snprintf(thename, 256, "%s", namebase.c_str());
 	int count = 1;
 	while (sliderDisplays.find(thename) != sliderDisplays.end())
-		_snprintf_s(thename, 256, 256, "%s%d", namebase.c_str(), count++);
+		snprintf(thename, 256, "%s%d", namebase.c_str(), count++);
 
 	std::string finalName = wxGetTextFromUser(_("Create a conversion slider for the current slider settings with the following name: "), _("Create New Conversion Slider"), thename, this);
 	if (finalName == "")
@@ -4514,11 +4514,11 @@ void OutfitStudio::OnNewZapSlider(wxCommandEvent& WXUNUSED(event)) {
 
 	std::string namebase = "NewZap";
 	char thename[256];
-	_snprintf_s(thename, 256, 256, "%s", namebase.c_str());
+	snprintf(thename, 256, "%s", namebase.c_str());
 	int count = 1;
 
 	while (sliderDisplays.find(thename) != sliderDisplays.end())
-		_snprintf_s(thename, 256, 256, "%s%d", namebase.c_str(), count++);
+		snprintf(thename, 256, "%s%d", namebase.c_str(), count++);
 
 	std::string finalName = wxGetTextFromUser(_("Enter a name for the new zap:"), _("Create New Zap"), thename, this);
 	if (finalName.empty())
@@ -4541,11 +4541,11 @@ void OutfitStudio::OnNewZapSlider(wxCommandEvent& WXUNUSED(event)) {
 void OutfitStudio::OnNewCombinedSlider(wxCommandEvent& WXUNUSED(event)) {
 	std::string namebase = "NewSlider";
 	char thename[256];
-	_snprintf_s(thename, 256, 256, "%s", namebase.c_str());
+	snprintf(thename, 256, "%s", namebase.c_str());
 	int count = 1;
 
 	while (sliderDisplays.find(thename) != sliderDisplays.end())
-		_snprintf_s(thename, 256, 256, "%s%d", namebase.c_str(), count++);
+		snprintf(thename, 256, "%s%d", namebase.c_str(), count++);
 
 	std::string finalName = wxGetTextFromUser(_("Enter a name for the new slider:"), _("Create New Slider"), thename, this);
 	if (finalName.empty())
@@ -4725,7 +4725,7 @@ void OutfitStudio::OnSliderProperties(wxCommandEvent& WXUNUSED(event)) {
 	}
 }
 
-void OutfitStudio::OnSliderConformAll(wxCommandEvent& event) {
+void OutfitStudio::OnSliderConformAll(wxCommandEvent& WXUNUSED(event)) {
 	std::vector<std::string> shapes;
 
 	wxTreeItemId curItem;
@@ -4736,24 +4736,27 @@ void OutfitStudio::OnSliderConformAll(wxCommandEvent& event) {
 
 	wxLogMessage("Conforming all shapes...");
 	StartProgress(_("Conforming all shapes..."));
-	int inc = 100 / shapes.size() - 1;
-	int pos = 0;
 
 	auto selectedItemsSave = selectedItems;
 
+	// All shapes are conformed together in one parallel pass
+	selectedItems.clear();
 	curItem = outfitShapes->GetFirstChild(outfitRoot, cookie);
 	while (curItem.IsOk()) {
-		selectedItems.clear();
 		selectedItems.push_back((ShapeItemData*)outfitShapes->GetItemData(curItem));
-		UpdateProgress(pos * inc, _("Conforming: ") + selectedItems.front()->shapeName);
-		StartSubProgress(pos * inc, pos * inc + inc);
-		OnSliderConform(event);
 		curItem = outfitShapes->GetNextChild(outfitRoot, cookie);
-		pos++;
 	}
 
+	StartSubProgress(0, 100);
+	bool conformed = ConformSelectedShapes();
+
 	selectedItems = selectedItemsSave;
 
+	if (!conformed) {
+		EndProgress(_("Conforming cancelled."));
+		return;
+	}
+
 	if (statusBar)
 		statusBar->SetStatusText(_("All shapes conformed."));
 
@@ -4763,39 +4766,57 @@ void OutfitStudio::OnSliderConformAll(wxCommandEvent& event) {
 }
 
 void OutfitStudio::OnSliderConform(wxCommandEvent& WXUNUSED(event)) {
+	ConformSelectedShapes();
+}
+
+bool OutfitStudio::ConformSelectedShapes() {
 	StartProgress(_("Conforming..."));
 	if (project->GetBaseShape().empty()) {
 		EndProgress();
-		return;
+		return false;
 	}
 
 	wxLogMessage("Conforming...");
 	ZeroSliders();
 
+	UpdateProgress(1, _("Initializing data..."));
+	project->InitConform();
+
+	std::vector<std::string> shapes;
 	for (auto &i : selectedItems) {
 		if (project->IsBaseShape(i->shapeName))
 			continue;
 
 		wxLogMessage("Conforming '%s'...", i->shapeName);
-		UpdateProgress(1, _("Initializing data..."));
-		project->InitConform();
+		project->morpher.CopyMeshMask(glView->GetMesh(i->shapeName), i->shapeName);
+		shapes.push_back(i->shapeName);
+	}
 
-		UpdateProgress(50, _("Conforming: ") + i->shapeName);
+	UpdateProgress(10, _("Initializing proximity data..."));
 
-		project->morpher.CopyMeshMask(glView->GetMesh(i->shapeName), i->shapeName);
-		project->ConformShape(i->shapeName);
+	// Sliders of all shapes are conformed in parallel, progress is reported from this thread
+	bool conformed = project->ConformShapes(shapes, 10.0f, 10, [&](int done, int total) {
+		if (total > 0)
+			return UpdateProgress(20 + done * 79 / total, _("Conforming... (Esc to cancel)"));
 
-		UpdateProgress(99);
-	}
+		return UpdateProgress(20, _("Conforming... (Esc to cancel)"));
+	});
 
 	project->morpher.ClearProximityCache();
 
+	if (!conformed) {
+		wxLogMessage("Conforming cancelled.");
+		EndProgress(_("Conforming cancelled."));
+		return false;
+	}
+
 	if (statusBar)
 		statusBar->SetStatusText(_("Shape(s) conformed."));
 
-	wxLogMessage("%d shape(s) conformed.", selectedItems.size());
+	wxLogMessage("%d shape(s) conformed.", shapes.size());
 	UpdateProgress(100, _("Finished"));
 	EndProgress();
+	return true;
 }
 
 void OutfitStudio::OnInvertUV(wxCommandEvent& event) {
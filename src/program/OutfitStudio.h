@@ -35,10 +35,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <wx/splitter.h>
 #include <wx/collpane.h>
 
-enum TargetGame {
-	FO3, FONV, SKYRIM, FO4, SKYRIMSE
-};
-
 
 class ShapeItemData : public wxTreeItemData  {
 public:
@@ -776,9 +772,10 @@ public:
 		}
 	}
 
-	void UpdateProgress(int val, const wxString& msg = "") {
+	// Returns false once Escape is held down, so long running operations that support it can be cancelled.
+	bool UpdateProgress(int val, const wxString& msg = "") {
 		if (progressStack.empty())
-			return;
+			return true;
 
 		int range = progressStack.back().second - progressStack.back().first;
 		float div = val / 100.0f;
@@ -790,6 +787,7 @@ public:
 
 		statusBar->SetStatusText(msg);
 		progressBar->SetValue(progressVal);
+		return !wxGetKeyState(WXK_ESCAPE);
 	}
 
 private:
@@ -917,6 +915,8 @@ private:
 	void OnSavePreset(wxCommandEvent& event);
 	void OnSliderConform(wxCommandEvent& event);
 	void OnSliderConformAll(wxCommandEvent& event);
+	// Conforms the sliders of the selected shapes, returns false if there's no base shape or the user cancelled
+	bool ConformSelectedShapes();
 	void OnSliderImportBSD(wxCommandEvent& event);
 	void OnSliderImportOBJ(wxCommandEvent& event);
 	void OnSliderImportOSD(wxCommandEvent& event);
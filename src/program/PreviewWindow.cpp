@@ -216,19 +216,7 @@ void PreviewWindow::AddNifShapeTextures(NifFile* fromNif, const std::string& sha
 		if (mat.Failed()) {
 			// Search for material file in archives
 			wxMemoryBuffer data;
-			for (FSArchiveFile *archive : FSManager::archiveList()) {
-				if (archive) {
-					if (archive->hasFile(matFile.ToStdString())) {
-						wxMemoryBuffer outData;
-						archive->fileContents(matFile.ToStdString(), outData);
-
-						if (!outData.IsEmpty()) {
-							data = std::move(outData);
-							break;
-						}
-					}
-				}
-			}
+			FSManager::fileContents(matFile.ToStdString(), data);
 
 			if (!data.IsEmpty()) {
 				std::string content((char*)data.GetData(), data.GetDataLen());
@@ -1020,32 +1020,11 @@ void GLSurface::AddMeshFromNif(NifFile* nif, std::string shapeName, Vector3* col
 		for (int t = 0; t < m->nTris; t++)
 			m->tris[t] = nifTris[t];
 
-		// Face normals
-		m->FacetNormals();
-
-		// Smooth normals
-		if (smoothNormalSeams) {
-			kd_matcher matcher(m->verts.get(), m->nVerts);
-			for (int i = 0; i < matcher.matches.size(); i++) {
-				std::pair<Vector3*, int>& a = matcher.matches[i].first;
-				std::pair<Vector3*, int>& b = matcher.matches[i].second;
-				m->weldVerts[a.second].push_back(b.second);
-				m->weldVerts[b.second].push_back(a.second);
-
-				Vector3& an = m->norms[a.second];
-				Vector3& bn = m->norms[b.second];
-				if (an.angle(bn) < 60.0f * DEG2RAD) {
-					Vector3 anT = an;
-					an += bn;
-					bn += anT;
-				}
-			}
+		// Virtually weld verts across UV seams
+		m->BuildWeldVerts();
 
-			for (int i = 0; i < m->nVerts; i++) {
-				Vector3& pn = m->norms[i];
-				pn.Normalize();
-			}
-		}
+		// Face normals, smoothed across the welded seams
+		m->SmoothNormals();
 	}
 	else {
 		// Already have normals, just copy the data over.
@@ -1062,13 +1041,7 @@ void GLSurface::AddMeshFromNif(NifFile* nif, std::string shapeName, Vector3* col
 		}
 
 		// Virtually weld verts across UV seams
-		kd_matcher matcher(m->verts.get(), m->nVerts);
-		for (int i = 0; i < matcher.matches.size(); i++) {
-			std::pair<Vector3*, int>& a = matcher.matches[i].first;
-			std::pair<Vector3*, int>& b = matcher.matches[i].second;
-			m->weldVerts[a.second].push_back(b.second);
-			m->weldVerts[b.second].push_back(a.second);
-		}
+		m->BuildWeldVerts();
 	}
 
 	m->CreateBVH();
@@ -1462,6 +1435,7 @@ void GLSurface::Update(int shapeIndex, std::vector<Vector3>* vertices, std::vect
 			(*changed).insert(i);
 	}
 
+	m->ResetWeldVerts();
 	m->QueueUpdate(mesh::UpdateType::Position);
 	if (uvs)
 		m->QueueUpdate(mesh::UpdateType::TextureCoordinates);
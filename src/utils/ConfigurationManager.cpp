@@ -6,6 +6,8 @@ See the included LICENSE file
 
 #include "ConfigurationManager.h"
 
+#include <cstdio>
+
 ConfigurationItem::~ConfigurationItem() {
 	for (auto &it : properties)
 		delete it;
@@ -423,13 +425,13 @@ void ConfigurationManager::SetValue(const std::string& inName, const std::string
 
 void ConfigurationManager::SetValue(const std::string& inName, int newValue, bool flagDefault) {
 	char intStr[24];
-	_snprintf_s(intStr, 24, 24, "%d", newValue);
+	snprintf(intStr, 24, "%d", newValue);
 	SetValue(inName, std::string(intStr), flagDefault);
 }
 
 void ConfigurationManager::SetValue(const std::string& inName, float newValue, bool flagDefault) {
 	char intStr[24];
-	_snprintf_s(intStr, 24, 24, "%0.5f", newValue);
+	snprintf(intStr, 24, "%0.5f", newValue);
 	SetValue(inName, std::string(intStr), flagDefault);
 }
 
@@ -437,7 +439,7 @@ bool ConfigurationManager::MatchValue(const std::string& inName, const std::stri
 	ConfigurationItem* itemFound = FindCI(inName);
 	if (itemFound) {
 		if (!useCase) {
-			if (!_stricmp(itemFound->value.c_str(), val.c_str()))
+			if (!StrICmp(itemFound->value.c_str(), val.c_str()))
 				return true;
 		}
 		else {
@@ -7,6 +7,7 @@ See the included LICENSE file
 #pragma once
 
 #include "../TinyXML-2/tinyxml2.h"
+#include "PlatformUtil.h"
 
 #include <vector>
 #include <unordered_map>
@@ -14,6 +15,10 @@ See the included LICENSE file
 
 using namespace tinyxml2;
 
+enum TargetGame {
+	FO3, FONV, SKYRIM, FO4, SKYRIMSE
+};
+
 class ConfigurationItem {
 	std::vector<ConfigurationItem*> children;
 	std::vector<ConfigurationItem*> properties;
@@ -62,7 +67,7 @@ public:
 	ConfigurationItem* FindProperty(const std::string& inName);
 
 	bool Match(const std::string& otherName) {
-		return (!_stricmp(otherName.c_str(), name.c_str()));
+		return (!StrICmp(otherName.c_str(), name.c_str()));
 	}
 };
 
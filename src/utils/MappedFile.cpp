@@ -0,0 +1,139 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& fileName) {
+	Close();
+
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	isOpen = true;
+
+	// Empty files can't be mapped
+	if (fileSize.QuadPart == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		Close();
+		return false;
+	}
+
+	mappingHandle = mapping;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		Close();
+		return false;
+	}
+
+	data = (const char*)view;
+	size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (data)
+		UnmapViewOfFile(data);
+
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+
+	if (fileHandle)
+		CloseHandle(fileHandle);
+
+	data = nullptr;
+	size = 0;
+	isOpen = false;
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+}
+
+bool MappedFile::FileStamp(const std::string& fileName, long long& outTime, long long& outSize) {
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(fileName.c_str(), GetFileExInfoStandard, &attributes))
+		return false;
+
+	outTime = ((long long)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	outSize = ((long long)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	return true;
+}
+#else
+bool MappedFile::Open(const std::string& fileName) {
+	Close();
+
+	int file = open(fileName.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0) {
+		close(file);
+		return false;
+	}
+
+	isOpen = true;
+
+	// Empty files can't be mapped
+	if (fileStat.st_size == 0) {
+		close(file);
+		return true;
+	}
+
+	// The mapping stays valid after closing the descriptor
+	void* view = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+
+	if (view == MAP_FAILED) {
+		isOpen = false;
+		return false;
+	}
+
+	data = (const char*)view;
+	size = (size_t)fileStat.st_size;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (data)
+		munmap((void*)data, size);
+
+	data = nullptr;
+	size = 0;
+	isOpen = false;
+}
+
+bool MappedFile::FileStamp(const std::string& fileName, long long& outTime, long long& outSize) {
+	struct stat fileStat;
+	if (stat(fileName.c_str(), &fileStat) != 0)
+		return false;
+
+	outTime = (long long)fileStat.st_mtim.tv_sec * 10000000 + fileStat.st_mtim.tv_nsec / 100;
+	outSize = fileStat.st_size;
+	return true;
+}
+#endif
@@ -0,0 +1,47 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <string>
+
+// Read-only memory mapping of a whole file.
+// The mapping keeps the file open, so it should be closed again as soon as the data was read.
+class MappedFile {
+	const char* data = nullptr;
+	size_t size = 0;
+	bool isOpen = false;
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+
+public:
+	MappedFile() {}
+	MappedFile(const std::string& fileName) {
+		Open(fileName);
+	}
+
+	~MappedFile() {
+		Close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps the file, empty files open successfully without any data
+	bool Open(const std::string& fileName);
+	void Close();
+
+	// Modification time in 100 ns units and size of a file, without opening it.
+	// Seconds alone miss a file that is rewritten right after it was read.
+	static bool FileStamp(const std::string& fileName, long long& outTime, long long& outSize);
+
+	bool IsOpen() { return isOpen; }
+	const char* Data() { return data; }
+	size_t Size() { return size; }
+};
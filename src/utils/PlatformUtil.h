@@ -0,0 +1,26 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "../NIF/utils/StringUtil.h"
+
+#include <algorithm>
+#include <string>
+
+#ifdef _WIN32
+const char PathSepChar = '\\';
+#else
+const char PathSepChar = '/';
+#endif
+
+// Slider sets and configurations store paths with backslashes, other platforms only understand forward slashes.
+inline std::string ToOSSlashes(std::string path) {
+#ifndef _WIN32
+	std::replace(path.begin(), path.end(), '\\', '/');
+#endif
+	return path;
+}
@@ -0,0 +1,219 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <iterator>
+
+namespace {
+	// Pool and queue index of the worker running on this thread
+	thread_local ThreadPool* tlsPool = nullptr;
+	thread_local int tlsWorker = -1;
+}
+
+ThreadPool::ThreadPool(int threadCount) : queuedCount(0), nextQueue(0) {
+	if (threadCount <= 0)
+		threadCount = HardwareThreads();
+
+	for (int i = 0; i < threadCount; i++)
+		queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+
+	workers.reserve(threadCount);
+	for (int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lk(sleepLock);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+
+	for (auto &w : workers)
+		if (w.joinable())
+			w.join();
+}
+
+int ThreadPool::HardwareThreads() {
+	int count = std::thread::hardware_concurrency();
+	if (count < 1)
+		count = 1;
+
+	return count;
+}
+
+int ThreadPool::CurrentWorker() {
+	if (tlsPool == this)
+		return tlsWorker;
+
+	return -1;
+}
+
+void ThreadPool::Submit(TaskGroup& group, Task task) {
+	Job job;
+	job.func = std::move(task);
+	job.group = &group;
+
+	{
+		std::lock_guard<std::mutex> lk(group.lock);
+		group.pending++;
+	}
+
+	// Workers push to their own queue, other threads distribute round-robin
+	int worker = CurrentWorker();
+	if (worker < 0)
+		worker = nextQueue++ % queues.size();
+
+	{
+		std::lock_guard<std::mutex> lk(queues[worker]->lock);
+		queues[worker]->jobs.push_back(std::move(job));
+	}
+	queuedCount++;
+
+	// Taking the lock prevents a lost wakeup between the predicate check and the wait of a worker
+	{
+		std::lock_guard<std::mutex> lk(sleepLock);
+	}
+	wakeWorkers.notify_one();
+}
+
+bool ThreadPool::PopJob(int worker, Job& outJob) {
+	if (queuedCount.load() <= 0)
+		return false;
+
+	// Own queue first, newest job for better cache locality
+	if (worker >= 0) {
+		WorkQueue& own = *queues[worker];
+		std::lock_guard<std::mutex> lk(own.lock);
+		if (!own.jobs.empty()) {
+			outJob = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			queuedCount--;
+			return true;
+		}
+	}
+
+	// Steal the oldest job of another queue
+	int queueCount = queues.size();
+	int start = worker >= 0 ? worker + 1 : 0;
+	for (int i = 0; i < queueCount; i++) {
+		int victim = (start + i) % queueCount;
+		if (victim == worker)
+			continue;
+
+		WorkQueue& other = *queues[victim];
+		std::lock_guard<std::mutex> lk(other.lock);
+		if (!other.jobs.empty()) {
+			outJob = std::move(other.jobs.front());
+			other.jobs.pop_front();
+			queuedCount--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ThreadPool::PopGroupJob(TaskGroup& group, Job& outJob) {
+	if (queuedCount.load() <= 0)
+		return false;
+
+	// Jobs of the group were pushed last by the waiting thread, so they're searched from the back
+	for (auto &queue : queues) {
+		std::lock_guard<std::mutex> lk(queue->lock);
+		for (auto it = queue->jobs.rbegin(); it != queue->jobs.rend(); ++it) {
+			if (it->group == &group) {
+				outJob = std::move(*it);
+				queue->jobs.erase(std::next(it).base());
+				queuedCount--;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::RunJob(Job& job) {
+	std::exception_ptr error;
+	try {
+		job.func();
+	}
+	catch (...) {
+		error = std::current_exception();
+	}
+
+	// Last access to the group, it may be destroyed as soon as the lock is released
+	TaskGroup* group = job.group;
+	std::lock_guard<std::mutex> lk(group->lock);
+	if (error && !group->error)
+		group->error = error;
+
+	if (--group->pending == 0)
+		group->done.notify_all();
+}
+
+void ThreadPool::RethrowError(TaskGroup& group) {
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lk(group.lock);
+		std::swap(error, group.error);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void ThreadPool::WorkerLoop(int worker) {
+	tlsPool = this;
+	tlsWorker = worker;
+
+	while (true) {
+		Job job;
+		if (PopJob(worker, job)) {
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lk(sleepLock);
+		wakeWorkers.wait(lk, [&]() { return stopping || queuedCount.load() > 0; });
+		if (stopping && queuedCount.load() <= 0)
+			break;
+	}
+
+	tlsPool = nullptr;
+	tlsWorker = -1;
+}
+
+void ThreadPool::Wait(TaskGroup& group) {
+	// Only jobs of this group are helped with, so the wait never ends up running unrelated long jobs
+	Job job;
+	while (!group.Finished() && PopGroupJob(group, job))
+		RunJob(job);
+
+	// Nothing left to help with, remaining tasks are running on other threads
+	{
+		std::unique_lock<std::mutex> lk(group.lock);
+		group.done.wait(lk, [&]() { return group.pending == 0; });
+	}
+
+	RethrowError(group);
+}
+
+bool ThreadPool::WaitFor(TaskGroup& group, int milliseconds) {
+	bool finished = false;
+	{
+		std::unique_lock<std::mutex> lk(group.lock);
+		finished = group.done.wait_for(lk, std::chrono::milliseconds(milliseconds), [&]() { return group.pending == 0; });
+	}
+
+	if (finished)
+		RethrowError(group);
+
+	return finished;
+}
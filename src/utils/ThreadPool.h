@@ -0,0 +1,108 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks completion of a batch of tasks submitted to a ThreadPool.
+// All state is guarded by the lock, a task counts down and notifies under it as its last access to the group.
+// That way a waiter can't see the group finished while a worker still uses it, and destroying it after the wait is safe.
+class TaskGroup {
+	friend class ThreadPool;
+
+	int pending;
+	std::exception_ptr error;	// First exception thrown by a task, rethrown by the waiter
+	std::mutex lock;
+	std::condition_variable done;
+
+public:
+	TaskGroup() : pending(0) {}
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	bool Finished() {
+		std::lock_guard<std::mutex> lk(lock);
+		return pending == 0;
+	}
+};
+
+// Work-stealing thread pool built on the standard library.
+// Every worker owns a queue it pushes to and pops from at the back, idle workers steal from the front of the other queues.
+class ThreadPool {
+public:
+	typedef std::function<void()> Task;
+
+private:
+	struct Job {
+		Task func;
+		TaskGroup* group = nullptr;
+	};
+
+	struct WorkQueue {
+		std::mutex lock;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex sleepLock;
+	std::condition_variable wakeWorkers;
+	std::atomic<int> queuedCount;
+	std::atomic<unsigned int> nextQueue;
+	bool stopping = false;
+
+	int CurrentWorker();
+	bool PopJob(int worker, Job& outJob);
+	bool PopGroupJob(TaskGroup& group, Job& outJob);
+	void RunJob(Job& job);
+	void RethrowError(TaskGroup& group);
+	void WorkerLoop(int worker);
+
+public:
+	// A thread count of zero or less uses all hardware threads.
+	ThreadPool(int threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	static int HardwareThreads();
+
+	int ThreadCount() {
+		return workers.size();
+	}
+
+	void Submit(TaskGroup& group, Task task);
+
+	// Blocks until all tasks of the group are done. The calling thread helps executing the queued tasks of the group meanwhile,
+	// so waiting from inside a task (nested parallelism) does not deadlock. Tasks of other groups are left to the workers.
+	// Rethrows the first exception thrown by a task of the group.
+	void Wait(TaskGroup& group);
+
+	// Sleeps for at most the given time without executing tasks. Returns true if all tasks of the group are done.
+	// Rethrows the first exception thrown by a task of the group once it's done.
+	bool WaitFor(TaskGroup& group, int milliseconds);
+
+	// Calls func(i) for every i in [0, count) and returns once all calls are done.
+	template<typename Func>
+	void ParallelFor(int count, const Func& func) {
+		TaskGroup group;
+		for (int i = 0; i < count; i++)
+			Submit(group, [&func, i]() { func(i); });
+
+		Wait(group);
+	}
+};
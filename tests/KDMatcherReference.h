@@ -0,0 +1,79 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#pragma once
+
+#include "../lib/NIF/utils/Object3d.h"
+
+#include <memory>
+
+// The duplicate vertex matcher as it was before kd_matcher sorted the points into a grid.
+// Each point descends an unbalanced tree of the earlier unmatched points in insertion order
+// and is matched with the first point on its path that is closer than EPSILON on all axes.
+class kd_matcher_reference {
+public:
+	class kd_node {
+	public:
+		std::pair<Vector3*, int> p = std::pair<Vector3*, int>(nullptr, -1);
+		std::unique_ptr<kd_node> less;
+		std::unique_ptr<kd_node> more;
+
+		kd_node(const std::pair<Vector3*, int>& point) {
+			p = point;
+		}
+
+		std::pair<Vector3*, int> add(const std::pair<Vector3*, int>& point, int depth) {
+			int axis = depth % 3;
+			bool domore = false;
+			float dx = p.first->x - point.first->x;
+			float dy = p.first->y - point.first->y;
+			float dz = p.first->z - point.first->z;
+
+			if (std::fabs(dx) < EPSILON && std::fabs(dy) < EPSILON && std::fabs(dz) < EPSILON)
+				return p;
+
+			switch (axis) {
+			case 0:
+				if (dx > 0) domore = true;
+				break;
+			case 1:
+				if (dy > 0) domore = true;
+				break;
+			case 2:
+				if (dz > 0) domore = true;
+				break;
+			}
+			if (domore) {
+				if (more) return more->add(point, depth + 1);
+				else more = std::make_unique<kd_node>(point);
+			}
+			else {
+				if (less) return less->add(point, depth + 1);
+				else less = std::make_unique<kd_node>(point);
+			}
+			return std::pair<Vector3*, int>(nullptr, -1);
+		}
+	};
+
+	std::unique_ptr<kd_node> root;
+	Vector3* points = nullptr;
+	int count;
+	std::vector<std::pair<std::pair<Vector3*, int>, std::pair<Vector3*, int>>> matches;
+
+	kd_matcher_reference(Vector3* points, int count) {
+		if (count <= 0)
+			return;
+
+		std::pair<Vector3*, int> pong;
+		root = std::make_unique<kd_node>(std::pair<Vector3*, int>(&points[0], 0));
+		for (int i = 1; i < count; i++) {
+			std::pair<Vector3*, int> point(&points[i], i);
+			pong = root->add(point, 0);
+			if (pong.first)
+				matches.push_back(std::pair<std::pair<Vector3*, int>, std::pair<Vector3*, int>>(point, pong));
+		}
+	}
+};
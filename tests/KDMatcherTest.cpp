@@ -0,0 +1,191 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+// Compares kd_matcher with the tree it replaced and times both.
+// Without arguments generated meshes are checked, any NIF files given are checked shape by shape:
+//   KDMatcherTest [file.nif ...]
+
+#include "../lib/NIF/NifFile.h"
+#include "../lib/NIF/utils/KDMatcher.h"
+#include "KDMatcherReference.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what) {
+	if (!condition) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+struct MatchComparison {
+	int count = 0;
+	int newMatches = 0;
+	int refMatches = 0;
+	int differentPairs = 0;		// Points matched by only one of both or with different partners
+	int invalidPairs = 0;		// Pairs of kd_matcher that aren't closer than EPSILON or point forward
+	double newMs = 0.0;
+	double refMs = 0.0;
+};
+
+template<typename Matcher>
+static double TimeMatcher(std::vector<Vector3>& points, std::vector<int>& outPartners, int& outMatches) {
+	const int runs = 5;
+	double best = 0.0;
+
+	for (int r = 0; r < runs; r++) {
+		auto start = std::chrono::steady_clock::now();
+		Matcher matcher(points.data(), points.size());
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (r == 0 || ms < best)
+			best = ms;
+
+		if (r == 0) {
+			outPartners.assign(points.size(), -1);
+			outMatches = matcher.matches.size();
+			for (auto &m : matcher.matches)
+				outPartners[m.first.second] = m.second.second;
+		}
+	}
+
+	return best;
+}
+
+static MatchComparison CompareMatchers(std::vector<Vector3>& points) {
+	MatchComparison result;
+	result.count = points.size();
+
+	std::vector<int> newPartners;
+	std::vector<int> refPartners;
+	result.newMs = TimeMatcher<kd_matcher>(points, newPartners, result.newMatches);
+	result.refMs = TimeMatcher<kd_matcher_reference>(points, refPartners, result.refMatches);
+
+	for (int i = 0; i < result.count; i++) {
+		if (newPartners[i] != refPartners[i])
+			result.differentPairs++;
+
+		int j = newPartners[i];
+		if (j != -1) {
+			Vector3 d = points[i] - points[j];
+			if (j >= i || std::fabs(d.x) >= EPSILON || std::fabs(d.y) >= EPSILON || std::fabs(d.z) >= EPSILON)
+				result.invalidPairs++;
+		}
+	}
+
+	return result;
+}
+
+static void PrintComparison(const std::string& name, const MatchComparison& c) {
+	printf("%-40s %7d points  %6d / %6d matches  %5d different  new %8.3f ms  old %8.3f ms\n",
+		name.c_str(), c.count, c.newMatches, c.refMatches, c.differentPairs, c.newMs, c.refMs);
+}
+
+// Tube of rings around the Y axis, like a limb or torso. The last column repeats the first one as UV seam,
+// both poles are closed by one row of points at the same position, split like a UV mapped cap.
+static std::vector<Vector3> MakeTube(int rings, int segments, float radius, float height) {
+	std::vector<Vector3> points;
+	points.reserve((rings + 2) * (segments + 1));
+
+	for (int r = -1; r <= rings; r++) {
+		for (int s = 0; s <= segments; s++) {
+			if (r == -1 || r == rings) {
+				points.emplace_back(0.0f, r == -1 ? 0.0f : height, 0.0f);
+				continue;
+			}
+
+			if (s == segments) {
+				points.push_back(points[points.size() - segments]);
+				continue;
+			}
+
+			float t = (float)r / (rings - 1);
+			float a = 2.0f * PI * s / segments;
+			float rr = radius * (0.6f + 0.4f * std::sin(t * PI));
+			points.emplace_back(rr * std::cos(a), t * height, rr * std::sin(a));
+		}
+	}
+
+	return points;
+}
+
+// Moves every point by less than EPSILON / 4 on each axis, so duplicates don't match exactly anymore
+static void Jitter(std::vector<Vector3>& points, unsigned int seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> offset(-EPSILON / 4.0f, EPSILON / 4.0f);
+	for (auto &p : points) {
+		p.x += offset(rng);
+		p.y += offset(rng);
+		p.z += offset(rng);
+	}
+}
+
+static void TestGeneratedMeshes() {
+	// Body sized mesh with exact duplicates on seams and poles, in mesh order and shuffled
+	std::vector<Vector3> body = MakeTube(250, 120, 15.0f, 120.0f);
+	MatchComparison c = CompareMatchers(body);
+	PrintComparison("generated body", c);
+	Check(c.newMatches > 0 && c.differentPairs == 0, "Same pairs as the old matcher for exact duplicates");
+	Check(c.invalidPairs == 0, "Valid pairs for exact duplicates");
+
+	std::vector<Vector3> shuffled = body;
+	std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1));
+	c = CompareMatchers(shuffled);
+	PrintComparison("generated body, shuffled", c);
+	Check(c.differentPairs == 0, "Same pairs as the old matcher for shuffled exact duplicates");
+	Check(c.invalidPairs == 0, "Valid pairs for shuffled exact duplicates");
+
+	// Near duplicates may be paired differently, points of the poles are within EPSILON of many earlier points.
+	// The old tree takes the first of them on its descent path or misses all of them behind a split,
+	// kd_matcher always takes the earliest unmatched one.
+	std::vector<Vector3> jittered = body;
+	Jitter(jittered, 2);
+	c = CompareMatchers(jittered);
+	PrintComparison("generated body, near duplicates", c);
+	Check(c.invalidPairs == 0, "Valid pairs for near duplicates");
+}
+
+static void TestNifFile(const std::string& fileName) {
+	NifFile nif;
+	if (nif.Load(fileName)) {
+		printf("FAILED: Couldn't load %s\n", fileName.c_str());
+		failures++;
+		return;
+	}
+
+	std::vector<std::string> shapes;
+	nif.GetShapeList(shapes);
+	for (auto &s : shapes) {
+		std::vector<Vector3> verts;
+		if (!nif.GetVertsForShape(s, verts))
+			continue;
+
+		MatchComparison c = CompareMatchers(verts);
+		PrintComparison(s, c);
+		Check(c.invalidPairs == 0, "Valid pairs for the shape");
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++)
+			TestNifFile(argv[i]);
+	}
+	else
+		TestGeneratedMeshes();
+
+	if (failures) {
+		printf("%d test(s) failed.\n", failures);
+		return 1;
+	}
+
+	printf("All tests passed.\n");
+	return 0;
+}
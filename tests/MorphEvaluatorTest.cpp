@@ -0,0 +1,60 @@
+/*
+BodySlide and Outfit Studio
+Copyright (C) 2017  Caliente & ousnius
+See the included LICENSE file
+*/
+
+#include "../src/components/MorphEvaluator.h"
+
+#include <cmath>
+#include <cstdio>
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what) {
+	if (!condition) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+static bool Near(float a, float b) {
+	return std::fabs(a - b) < 1e-5f;
+}
+
+// A recompute without UVs followed by an evaluation with UVs has to apply the UV diffs only once
+static void TestUVsAfterRecomputeWithoutUVs() {
+	DiffDataSets data;
+	data.LoadSet("move", "Shape", std::unordered_map<ushort, Vector3>{ { 0, Vector3(1.0f, 0.0f, 0.0f) } });
+	data.LoadSet("uv", "Shape", std::unordered_map<ushort, Vector3>{ { 0, Vector3(0.25f, 0.5f, 0.0f) } });
+
+	std::vector<Vector3> baseVerts = { Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f) };
+	std::vector<Vector2> baseUVs = { Vector2(0.0f, 0.0f), Vector2(1.0f, 1.0f) };
+	std::vector<MorphTerm> terms = { MorphTerm("move", 1.0f), MorphTerm("uv", 1.0f, true) };
+
+	MorphEvaluator evaluator;
+	std::vector<Vector3> verts;
+	std::vector<Vector2> uvs;
+	evaluator.Evaluate("Shape", data, "Shape", baseVerts, &baseUVs, terms, verts, &uvs);
+	Check(uvs.size() == 2 && Near(uvs[0].u, 0.25f) && Near(uvs[0].v, 0.5f), "UVs of the first evaluation");
+
+	// Changed base vertices recompute the shape, this time without UVs
+	baseVerts[1] = Vector3(2.0f, 2.0f, 2.0f);
+	evaluator.Evaluate("Shape", data, "Shape", baseVerts, nullptr, terms, verts);
+	Check(Near(verts[0].x, 1.0f) && Near(verts[1].x, 2.0f), "vertices of the evaluation without UVs");
+
+	uvs.clear();
+	evaluator.Evaluate("Shape", data, "Shape", baseVerts, &baseUVs, terms, verts, &uvs);
+	Check(uvs.size() == 2 && Near(uvs[0].u, 0.25f) && Near(uvs[0].v, 0.5f), "UVs after the evaluation without UVs");
+	Check(Near(verts[0].x, 1.0f), "vertices after the evaluation without UVs");
+}
+
+int main() {
+	TestUVsAfterRecomputeWithoutUVs();
+
+	if (failures > 0)
+		return 1;
+
+	printf("All tests passed.\n");
+	return 0;
+}